@@ -28,7 +28,12 @@
 
 //==============================================================================
 #include "rt-wdf.h"
+#include "rt-wdf_equations.h"
 #include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 
 #pragma mark - Tree
 //==============================================================================
@@ -39,6 +44,11 @@ wdfTree::wdfTree( ) {
     ascendingWaves.reset();
     descendingWaves.reset();
     treeSampleRate  = 1;
+    rootMatrCacheSize = 0;
+    stateFingerprint = 0;
+    stateNumValues = 0;
+    guardMode = false;
+    guardResets = 0;
 }
 
 wdfTree::~wdfTree( ) {
@@ -47,6 +57,13 @@ wdfTree::~wdfTree( ) {
 
 //----------------------------------------------------------------------
 void wdfTree::cycleWave( ) {
+    if( threadPool ) {
+        threadPool->run( &wdfTree::pullSubtrees, this );
+        root->processAscendingWaves( ascendingWaves.get(), descendingWaves.get() );
+        threadPool->run( &wdfTree::pushSubtrees, this );
+        return;
+    }
+
     for( unsigned int i = 0; i < subtreeCount; i++ ) {
         double wave = subtreeEntryNodes[i]->pullWaveUp( );
         (*ascendingWaves)[i] = wave;
@@ -59,6 +76,127 @@ void wdfTree::cycleWave( ) {
     }
 }
 
+//----------------------------------------------------------------------
+void wdfTree::pullSubtrees( void* context,
+                            size_t threadIndex ) {
+    wdfTree* tree = static_cast<wdfTree*>( context );
+    double* a = tree->ascendingWaves->memptr( );
+    const std::vector<size_t>& subtrees = tree->threadSubtrees[threadIndex];
+    for( size_t i = 0; i < subtrees.size(); i++ ) {
+        a[subtrees[i]] = tree->subtreeEntryNodes[subtrees[i]]->pullWaveUp( );
+    }
+}
+
+//----------------------------------------------------------------------
+void wdfTree::pushSubtrees( void* context,
+                            size_t threadIndex ) {
+    wdfTree* tree = static_cast<wdfTree*>( context );
+    const double* b = tree->descendingWaves->memptr( );
+    const std::vector<size_t>& subtrees = tree->threadSubtrees[threadIndex];
+    for( size_t i = 0; i < subtrees.size(); i++ ) {
+        tree->subtreeEntryNodes[subtrees[i]]->pushWaveDown( b[subtrees[i]] );
+    }
+}
+
+//----------------------------------------------------------------------
+void wdfTree::applyGuardMode( void* context,
+                              size_t threadIndex ) {
+    wdfTree* tree = static_cast<wdfTree*>( context );
+    if( threadIndex != 0 ) {
+        wdfSetFlushToZero( tree->guardMode );
+    }
+}
+
+//----------------------------------------------------------------------
+void wdfTree::processBlock( const double* input,
+                            double* output,
+                            size_t numSamples ) {
+    if( !guardMode ) {
+        for( size_t n = 0; n < numSamples; n++ ) {
+            setInputValue( input[n] );
+            cycleWave( );
+            output[n] = getOutputValue( );
+        }
+        return;
+    }
+
+    wdfDenormalScope denormalScope;
+    for( size_t n = 0; n < numSamples; n++ ) {
+        setInputValue( input[n] );
+        cycleWave( );
+        output[n] = getOutputValue( );
+    }
+    guardState( output, numSamples );
+}
+
+//----------------------------------------------------------------------
+void wdfTree::setGuardMode( bool enabled ) {
+    guardMode = enabled;
+    guardResets = 0;
+    guardRootState.assign( enabled ? root->getNumStates( ) : 0, 0 );
+    if( threadPool ) {
+        threadPool->run( &wdfTree::applyGuardMode, this );
+    }
+}
+
+//----------------------------------------------------------------------
+size_t wdfTree::getNumGuardResets( ) const {
+    return guardResets;
+}
+
+//----------------------------------------------------------------------
+/**
+ Counts the nodes of a subtree.
+ */
+static size_t countNodes( const wdfTreeNode* node ) {
+    size_t count = 1;
+    const std::vector<wdfTreeNode*>& children = node->getChildrenNodes( );
+    for( size_t i = 0; i < children.size(); i++ ) {
+        count += countNodes( children[i] );
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------
+int wdfTree::setNumThreads( size_t numThreads ) {
+    if( numThreads == 0 || !ascendingWaves ) {
+        return -1;
+    }
+    numThreads = std::min( numThreads, subtreeCount );
+
+    threadPool.reset( );
+    threadSubtrees.clear( );
+    if( numThreads <= 1 ) {
+        return 0;
+    }
+
+    // largest subtrees first, each to the thread with the least nodes
+    std::vector<std::pair<size_t, size_t>> sizes;
+    for( size_t i = 0; i < subtreeCount; i++ ) {
+        sizes.push_back( std::make_pair( countNodes( subtreeEntryNodes[i] ), i ) );
+    }
+    std::sort( sizes.rbegin(), sizes.rend() );
+
+    threadSubtrees.resize( numThreads );
+    std::vector<size_t> load( numThreads, 0 );
+    for( size_t i = 0; i < sizes.size(); i++ ) {
+        size_t t = std::min_element( load.begin(), load.end() ) - load.begin();
+        load[t] += sizes[i].first;
+        threadSubtrees[t].push_back( sizes[i].second );
+    }
+
+    threadPool.reset( new wdfThreadPool( numThreads ) );
+    if( guardMode ) {
+        threadPool->run( &wdfTree::applyGuardMode, this );
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+size_t wdfTree::getNumThreads( ) const {
+    return threadPool ? threadPool->getNumThreads() : 1;
+}
+
 //----------------------------------------------------------------------
 void wdfTree::initTree( ) {
     ascendingWaves.reset( new vec( subtreeCount ) );
@@ -81,7 +219,7 @@ double wdfTree::getSamplerate( ) {
 }
 
 //----------------------------------------------------------------------
-int wdfTree::adaptTree( ) {
+void wdfTree::adaptSubtrees( ) {
     for( unsigned int i = 0; i < subtreeCount; i++ ) {
         subtreeEntryNodes[i]->adaptPorts( treeSampleRate );
         Rp[i] = subtreeEntryNodes[i]->upPort->Rp;
@@ -89,20 +227,508 @@ int wdfTree::adaptTree( ) {
     }
 
     root->setPortResistances( Rp );
+}
+
+//----------------------------------------------------------------------
+int wdfTree::adaptTree( ) {
+    adaptSubtrees( );
 
     matData* rootMatrixData = root->getRootMatrPtr( );
     if( rootMatrixData != NULL ){
-        return setRootMatrData( rootMatrixData, Rp );
+        std::lock_guard<std::mutex> lock( rootMatrMutex );
+
+        std::map<double, rootMatrCacheEntry>::iterator prepared;
+        prepared = samplerateCache.find( treeSampleRate );
+        if( prepared != samplerateCache.end() &&
+            std::equal( Rp, Rp + subtreeCount, prepared->second.Rp.begin() ) ) {
+            *rootMatrixData = prepared->second.data;
+        }
+        else if( rootMatrCacheSize == 0 ) {
+            if( setRootMatrDataAt( rootMatrixData, Rp, treeSampleRate ) != 0 ) {
+                return -1;
+            }
+        }
+        else {
+            std::vector<double> key( Rp, Rp + subtreeCount );
+            std::list<rootMatrCacheEntry>::iterator entry = rootMatrCache.begin( );
+            while( entry != rootMatrCache.end() && entry->Rp != key ) {
+                ++entry;
+            }
+
+            if( entry != rootMatrCache.end() ) {
+                rootMatrCache.splice( rootMatrCache.begin(), rootMatrCache, entry );
+                *rootMatrixData = rootMatrCache.front().data;
+            }
+            else {
+                if( setRootMatrDataAt( rootMatrixData, Rp, treeSampleRate ) != 0 ) {
+                    return -1;
+                }
+                rootMatrCacheEntry newEntry;
+                newEntry.Rp = key;
+                newEntry.data = *rootMatrixData;
+                rootMatrCache.push_front( newEntry );
+                if( rootMatrCache.size() > rootMatrCacheSize ) {
+                    rootMatrCache.pop_back( );
+                }
+            }
+        }
+        root->prepareRootMatrData( );
+    }
+
+    return 0;
+}
+
+//----------------------------------------------------------------------
+int wdfTree::setRootMatrDataAt( matData* rootMatrixData,
+                                double *Rp,
+                                double fs ) {
+    return setRootMatrData( rootMatrixData, Rp );
+}
+
+//----------------------------------------------------------------------
+int wdfTree::prepareSamplerate( double fs ) {
+    matData* rootMatrixData = root->getRootMatrPtr( );
+    if( rootMatrixData == NULL ) {
+        return 0;
+    }
+    if( fs <= 0 ) {
+        return -1;
+    }
+
+    std::vector<double> preparedRp( subtreeCount );
+    for( unsigned int i = 0; i < subtreeCount; i++ ) {
+        preparedRp[i] = subtreeEntryNodes[i]->getUpRes( fs );
+        if( !( preparedRp[i] > 0 ) ) {
+            return -1;
+        }
+    }
+
+    rootMatrCacheEntry entry;
+    entry.Rp = preparedRp;
+
+    std::lock_guard<std::mutex> lock( rootMatrMutex );
+
+    // start from a copy so that setRootMatrDataAt() finds the matrix sizes
+    entry.data = *rootMatrixData;
+    if( setRootMatrDataAt( &entry.data, preparedRp.data(), fs ) != 0 ) {
+        return -1;
+    }
+
+    samplerateCache[fs] = std::move( entry );
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void wdfTree::clearSamplerateCache( ) {
+    std::lock_guard<std::mutex> lock( rootMatrMutex );
+    samplerateCache.clear( );
+}
+
+//----------------------------------------------------------------------
+void wdfTree::setRootMatrCacheSize( size_t maxEntries ) {
+    rootMatrCacheSize = maxEntries;
+    while( rootMatrCache.size() > rootMatrCacheSize ) {
+        rootMatrCache.pop_back( );
+    }
+}
+
+//----------------------------------------------------------------------
+/**
+ Resets the state of all nodes of a subtree.
+ */
+static void resetSubtree( wdfTreeNode* node ) {
+    node->resetState( );
+    const std::vector<wdfTreeNode*>& children = node->getChildrenNodes( );
+    for( size_t i = 0; i < children.size(); i++ ) {
+        resetSubtree( children[i] );
+    }
+}
+
+//----------------------------------------------------------------------
+/**
+ Snapshot header as documented in wdfTree::saveState().
+ */
+typedef struct stateHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fingerprint;
+    double sampleRate;
+    uint64_t numValues;
+} stateHeader;
+
+//----------------------------------------------------------------------
+/**
+ Mixes the type and the number of states of a node into an FNV-1a hash.
+ */
+static uint64_t hashNode( uint64_t hash,
+                          const std::string& type,
+                          size_t numStates ) {
+    for( size_t i = 0; i < type.size(); i++ ) {
+        hash = ( hash ^ (unsigned char)type[i] ) * 0x100000001b3ULL;
+    }
+    return ( hash ^ numStates ) * 0x100000001b3ULL;
+}
+
+//----------------------------------------------------------------------
+/**
+ Copies the states of all nodes of a subtree in depth-first order from or
+ to a buffer. Without buffers only the fingerprint and the number of values
+ are updated.
+ */
+static void walkSubtreeState( wdfTreeNode* node,
+                              uint64_t* fingerprint,
+                              size_t* numValues,
+                              double* saveTo,
+                              const double* loadFrom ) {
+    const size_t n = node->getNumStates( );
+    if( saveTo != NULL ) {
+        node->getState( saveTo + *numValues );
+    }
+    else if( loadFrom != NULL ) {
+        node->setState( loadFrom + *numValues );
+    }
+    else {
+        *fingerprint = hashNode( *fingerprint, node->getType(), n );
     }
+    *numValues += n;
 
+    const std::vector<wdfTreeNode*>& children = node->getChildrenNodes( );
+    for( size_t i = 0; i < children.size(); i++ ) {
+        walkSubtreeState( children[i], fingerprint, numValues, saveTo, loadFrom );
+    }
+}
+
+//----------------------------------------------------------------------
+void wdfTree::walkState( double* saveTo,
+                         const double* loadFrom ) {
+    uint64_t fingerprint = 0xcbf29ce484222325ULL;
+    size_t count = 0;
+    for( size_t i = 0; i < subtreeCount; i++ ) {
+        walkSubtreeState( subtreeEntryNodes[i], &fingerprint, &count, saveTo, loadFrom );
+    }
+
+    for( size_t i = 0; i < subtreeCount; i++ ) {
+        if( saveTo != NULL ) {
+            saveTo[count + i] = ascendingWaves->at( i );
+            saveTo[count + subtreeCount + i] = descendingWaves->at( i );
+        }
+        else if( loadFrom != NULL ) {
+            ascendingWaves->at( i ) = loadFrom[count + i];
+            descendingWaves->at( i ) = loadFrom[count + subtreeCount + i];
+        }
+    }
+    count += 2 * subtreeCount;
+
+    const size_t n = root->getNumStates( );
+    if( saveTo != NULL ) {
+        root->getState( saveTo + count );
+    }
+    else if( loadFrom != NULL ) {
+        root->setState( loadFrom + count );
+    }
+    else {
+        fingerprint = hashNode( fingerprint, root->getType(), n );
+        stateFingerprint = fingerprint;
+        stateNumValues = count + n;
+    }
+}
+
+//----------------------------------------------------------------------
+size_t wdfTree::getStateSize( ) {
+    if( stateNumValues == 0 ) {
+        walkState( NULL, NULL );
+    }
+    return sizeof( stateHeader ) + stateNumValues * sizeof( double );
+}
+
+//----------------------------------------------------------------------
+void wdfTree::saveState( std::vector<unsigned char>* snapshot ) {
+    snapshot->resize( getStateSize() );
+    walkState( reinterpret_cast<double*>( snapshot->data() + sizeof( stateHeader ) ), NULL );
+
+    stateHeader header;
+    header.magic = WDF_STATE_MAGIC;
+    header.version = WDF_STATE_VERSION;
+    header.fingerprint = stateFingerprint;
+    header.sampleRate = treeSampleRate;
+    header.numValues = stateNumValues;
+    memcpy( snapshot->data(), &header, sizeof( stateHeader ) );
+}
+
+//----------------------------------------------------------------------
+int wdfTree::restoreState( const unsigned char* snapshot,
+                           size_t size ) {
+    stateHeader header;
+    if( snapshot == NULL || size < sizeof( stateHeader ) ||
+        size != getStateSize() ) {
+        return -1;
+    }
+    memcpy( &header, snapshot, sizeof( stateHeader ) );
+
+    if( header.magic != WDF_STATE_MAGIC ||
+        header.version != WDF_STATE_VERSION ||
+        header.fingerprint != stateFingerprint ||
+        header.sampleRate != treeSampleRate ||
+        header.numValues != stateNumValues ) {
+        return -1;
+    }
+
+    walkState( NULL, reinterpret_cast<const double*>( snapshot + sizeof( stateHeader ) ) );
     return 0;
 }
 
+//----------------------------------------------------------------------
+/**
+ Collects the nodes of a subtree whose state has delay elements in
+ addition to the port waves.
+ */
+static void collectDelayNodes( wdfTreeNode* node,
+                               std::vector<wdfTreeNode*>* nodes ) {
+    if( node->getNumStates() > node->wdfTreeNode::getNumStates() ) {
+        nodes->push_back( node );
+    }
+    const std::vector<wdfTreeNode*>& children = node->getChildrenNodes( );
+    for( size_t i = 0; i < children.size(); i++ ) {
+        collectDelayNodes( children[i], nodes );
+    }
+}
+
+//----------------------------------------------------------------------
+/**
+ Copies the delay elements of some nodes and of a root element from or to
+ a vector. Delay elements are the node states behind the port waves and
+ all states of an unadapted root element. buffer is a scratch vector that
+ holds the states of the largest node.
+ */
+static void accessDelays( const std::vector<wdfTreeNode*>& nodes,
+                          wdfRootNode* rootElement,
+                          vec* delays,
+                          bool write,
+                          std::vector<double>* buffer ) {
+    double* states = buffer->data( );
+    size_t k = 0;
+    for( wdfTreeNode* node : nodes ) {
+        const size_t numStates = node->getNumStates( );
+        node->getState( states );
+        for( size_t i = node->wdfTreeNode::getNumStates(); i < numStates; i++, k++ ) {
+            if( write ) {
+                states[i] = delays->at( k );
+            }
+            else {
+                delays->at( k ) = states[i];
+            }
+        }
+        if( write ) {
+            node->setState( states );
+        }
+    }
+    if( rootElement != NULL && rootElement->getNumStates() > 0 ) {
+        const size_t numStates = rootElement->getNumStates( );
+        rootElement->getState( states );
+        for( size_t i = 0; i < numStates; i++, k++ ) {
+            if( write ) {
+                states[i] = delays->at( k );
+            }
+            else {
+                delays->at( k ) = states[i];
+            }
+        }
+        if( write ) {
+            rootElement->setState( states );
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+int wdfTree::initOperatingPoint( double inputValue ) {
+    setInputValue( inputValue );
+
+    std::vector<wdfTreeNode*> nodes;
+    for( size_t i = 0; i < subtreeCount; i++ ) {
+        collectDelayNodes( subtreeEntryNodes[i], &nodes );
+    }
+    wdfRootSimple* simpleRoot = dynamic_cast<wdfRootSimple*>( root.get() );
+    wdfRootNode* rootElement = simpleRoot ? simpleRoot->getRootElement() : NULL;
+
+    size_t numDelays = 0;
+    size_t maxStates = 0;
+    for( wdfTreeNode* node : nodes ) {
+        numDelays += node->getNumStates() - node->wdfTreeNode::getNumStates();
+        maxStates = std::max( maxStates, node->getNumStates() );
+    }
+    if( rootElement != NULL ) {
+        numDelays += rootElement->getNumStates( );
+        maxStates = std::max( maxStates, rootElement->getNumStates() );
+    }
+    std::vector<double> buffer( maxStates );
+
+    std::vector<unsigned char> original;
+    std::vector<unsigned char> base;
+    saveState( &original );
+    base = original;
+
+    // phi(x): delay elements after one sample that started from x
+    vec x( numDelays, fill::zeros );
+    vec phi( numDelays, fill::zeros );
+    vec phiStep( numDelays, fill::zeros );
+    mat J( numDelays, numDelays, fill::zeros );
+    accessDelays( nodes, rootElement, &x, false, &buffer );
+
+    vec xPrev = x;
+    vec step( numDelays, fill::zeros );
+    double normPrev = DBL_MAX;
+    bool converged = false;
+    for( int iter = 0; iter < DCOP_ITMAX; iter++ ) {
+        restoreState( base.data(), base.size() );
+        accessDelays( nodes, rootElement, &x, true, &buffer );
+        cycleWave( );
+        accessDelays( nodes, rootElement, &phi, false, &buffer );
+
+        // residual G(x) = phi(x) - x
+        double normG = 0.0;
+        bool finite = true;
+        for( size_t i = 0; i < numDelays; i++ ) {
+            normG = std::max( normG, std::fabs( phi(i) - x(i) ) );
+            finite = finite && std::isfinite( phi(i) );
+        }
+        // the tree is now one sample past the fixed point x
+        if( finite && ( converged || normG == 0.0 ) ) {
+            return 0;
+        }
+
+        // halve the step if it made things worse, e.g. diverged the NL solver
+        if( !finite || normG > normPrev ) {
+            step = 0.5 * step;
+            x = xPrev + step;
+            converged = false;
+
+            // no more progress below the accuracy of the NL solver, the
+            // last accepted sample is as close as it gets
+            double normStep = 0.0;
+            double normX = 0.0;
+            for( size_t i = 0; i < numDelays; i++ ) {
+                normStep = std::max( normStep, std::fabs( step(i) ) );
+                normX = std::max( normX, std::fabs( xPrev(i) ) );
+            }
+            if( finite && normStep <= DCOP_TOL * ( 1.0 + normX ) ) {
+                restoreState( base.data(), base.size() );
+                return 0;
+            }
+            continue;
+        }
+        normPrev = normG;
+
+        // keep the converged NL guess for the next evaluations
+        saveState( &base );
+
+        for( size_t j = 0; j < numDelays; j++ ) {
+            const double h = DCOP_FD_STEP * ( 1.0 + std::fabs( x(j) ) );
+            vec xStep = x;
+            xStep(j) += h;
+            restoreState( base.data(), base.size() );
+            accessDelays( nodes, rootElement, &xStep, true, &buffer );
+            cycleWave( );
+            accessDelays( nodes, rootElement, &phiStep, false, &buffer );
+            for( size_t i = 0; i < numDelays; i++ ) {
+                J(i, j) = ( phiStep(i) - phi(i) ) / h - ( i == j ? 1.0 : 0.0 );
+            }
+        }
+
+        // Newton step J * step = -G(x), a singular Jacobian ends the search
+        const vec negG = x - phi;
+        if( !solve( step, J, negG ) ) {
+            break;
+        }
+        xPrev = x;
+        x = x + step;
+
+        // the Newton step estimates the distance to the fixed point
+        double normStep = 0.0;
+        double normX = 0.0;
+        for( size_t i = 0; i < numDelays; i++ ) {
+            normStep = std::max( normStep, std::fabs( step(i) ) );
+            normX = std::max( normX, std::fabs( x(i) ) );
+        }
+        converged = ( normStep <= DCOP_TOL * ( 1.0 + normX ) );
+    }
+
+    restoreState( original.data(), original.size() );
+    return -1;
+}
+
+//----------------------------------------------------------------------
+void wdfTree::guardState( double* output,
+                          size_t numSamples ) {
+    double* a = ascendingWaves->memptr( );
+    double* b = descendingWaves->memptr( );
+
+    bool rootFinite = true;
+    root->getState( guardRootState.data() );
+    for( size_t i = 0; i < guardRootState.size(); i++ ) {
+        if( !std::isfinite( guardRootState[i] ) ) {
+            rootFinite = false;
+            break;
+        }
+    }
+
+    bool treeFinite = rootFinite;
+    for( unsigned int i = 0; i < subtreeCount; i++ ) {
+        if( !std::isfinite( b[i] ) ) {
+            rootFinite = false;
+        }
+        if( !std::isfinite( a[i] ) || !std::isfinite( b[i] ) ) {
+            resetSubtree( subtreeEntryNodes[i] );
+            a[i] = 0;
+            b[i] = 0;
+            guardResets++;
+            treeFinite = false;
+        }
+    }
+
+    if( !rootFinite ) {
+        root->resetState( );
+        guardResets++;
+    }
+
+    if( !treeFinite ) {
+        for( size_t n = 0; n < numSamples; n++ ) {
+            if( !std::isfinite( output[n] ) ) {
+                output[n] = 0;
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+void wdfTree::resetState( ) {
+    for( unsigned int i = 0; i < subtreeCount; i++ ) {
+        resetSubtree( subtreeEntryNodes[i] );
+        (*ascendingWaves)[i] = 0;
+        (*descendingWaves)[i] = 0;
+    }
+    root->resetState( );
+}
+
 //----------------------------------------------------------------------
 const std::vector<paramData>& wdfTree::getParams( ) {
     return params;
 }
 
+//----------------------------------------------------------------------
+wdfRoot* wdfTree::getRoot( ) {
+    return root.get();
+}
+
+//----------------------------------------------------------------------
+size_t wdfTree::getSubtreeCount( ) {
+    return subtreeCount;
+}
+
+//----------------------------------------------------------------------
+wdfTreeNode* wdfTree::getSubtreeEntryNode( size_t index ) {
+    return subtreeEntryNodes[index];
+}
+
 
 #pragma mark - Roots
 //==============================================================================
@@ -125,6 +751,31 @@ matData* wdfRoot::getRootMatrPtr( ) {
     return NULL;
 }
 
+//----------------------------------------------------------------------
+void wdfRoot::prepareRootMatrData( ) {
+    //do nothing here, might be implemented by a subclass of wdfRoot..
+}
+
+//----------------------------------------------------------------------
+void wdfRoot::resetState( ) {
+    //do nothing here, might be implemented by a subclass of wdfRoot..
+}
+
+//----------------------------------------------------------------------
+size_t wdfRoot::getNumStates( ) {
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void wdfRoot::getState( double* /*state*/ ) {
+    //do nothing here, might be implemented by a subclass of wdfRoot..
+}
+
+//----------------------------------------------------------------------
+void wdfRoot::setState( const double* /*state*/ ) {
+    //do nothing here, might be implemented by a subclass of wdfRoot..
+}
+
 #pragma mark R-type Root
 //==============================================================================
 wdfRootRtype::wdfRootRtype( int numSubtrees ) : wdfRoot(),
@@ -144,7 +795,17 @@ wdfRootRtype::~wdfRootRtype( ) {
 //----------------------------------------------------------------------
 void wdfRootRtype::processAscendingWaves( vec* ascendingWaves,
                                           vec* descendingWaves ) {
-    (*descendingWaves) = rootMatrixData->Smat * (*ascendingWaves);
+    scatteringKernel.multiply( ascendingWaves->memptr(), descendingWaves->memptr() );
+}
+
+//----------------------------------------------------------------------
+void wdfRootRtype::prepareRootMatrData( ) {
+    scatteringKernel.setMatrix( rootMatrixData->Smat );
+}
+
+//----------------------------------------------------------------------
+const wdfMatVec& wdfRootRtype::getScatteringKernel( ) const {
+    return scatteringKernel;
 }
 
 //----------------------------------------------------------------------
@@ -160,14 +821,54 @@ std::string wdfRootRtype::getType( ) const {
 
 #pragma mark Non-Linear Root
 //==============================================================================
+/**
+ Creates the NL solver for a solverType as defined in rt-wdf_nlSolvers.h,
+ nlNewtonSolver for unknown types. Newton solvers for a single port are
+ replaced by the scalar nlScalarSolver.
+ */
+static nlNewtonSolver* createNlSolver( std::vector<int> nlList,
+                                       matData* myMatData,
+                                       int solverType ) {
+    switch( solverType ) {
+        case BROYDEN_SOLVER:
+        case CHORD_SOLVER:
+            return new nlQuasiNewtonSolver( nlList, myMatData, solverType );
+        case MLP_SOLVER:
+            return new nlMlpSolver( nlList, myMatData );
+        default:
+        {
+            int numPorts = 0;
+            for( int modelType : nlList ) {
+                numPorts += nlModel::getNumPorts( modelType );
+            }
+            if( numPorts == 1 ) {
+                return new nlScalarSolver( nlList, myMatData );
+            }
+            return new nlNewtonSolver( nlList, myMatData );
+        }
+    }
+}
+
+//----------------------------------------------------------------------
 wdfRootNL::wdfRootNL( int numSubtrees,
                       std::vector<int> nlList,
-                      int solverType ) : wdfRoot( ),
-                                         numSubtrees( numSubtrees ) {
+                      int solverType ) : wdfRootNL( numSubtrees,
+                                                    nlList,
+                                                    solverType,
+                                                    NULL ) {
+
+}
+
+wdfRootNL::wdfRootNL( int numSubtrees,
+                      std::vector<int> nlList,
+                      int solverType,
+                      matData* solverMatrixData ) : wdfRoot( ),
+                                                    nlMatrixData( solverMatrixData ),
+                                                    numSubtrees( numSubtrees ) {
     rootMatrixData.reset( new matData );
 
-    // TODO make ENUM / MAP variant with different nlSolvers (!!)
-    NlSolver.reset( new nlNewtonSolver( nlList, rootMatrixData.get() ) );
+    matData* solverData = nlMatrixData ? nlMatrixData.get() : rootMatrixData.get();
+    NlSolver.reset( createNlSolver( nlList, solverData, solverType ) );
     int numNonlinearities = NlSolver->getNumPorts( );
 
     rootMatrixData->Smat.set_size( numSubtrees+numNonlinearities, numSubtrees+numNonlinearities );
@@ -187,6 +888,11 @@ void wdfRootNL::processAscendingWaves( vec* ascendingWaves,
     NlSolver->nlSolve( ascendingWaves, descendingWaves );
 }
 
+//----------------------------------------------------------------------
+void wdfRootNL::prepareRootMatrData( ) {
+    NlSolver->prepareMatrData( );
+}
+
 //----------------------------------------------------------------------
 matData* wdfRootNL::getRootMatrPtr( ) {
     return rootMatrixData.get();
@@ -197,6 +903,125 @@ std::string wdfRootNL::getType( ) const {
     return "Root (NL-type)";
 }
 
+//----------------------------------------------------------------------
+void wdfRootNL::resetState( ) {
+    NlSolver->resetState( );
+}
+
+//----------------------------------------------------------------------
+size_t wdfRootNL::getNumStates( ) {
+    return NlSolver->getNumStates( );
+}
+
+//----------------------------------------------------------------------
+void wdfRootNL::getState( double* state ) {
+    NlSolver->getState( state );
+}
+
+//----------------------------------------------------------------------
+void wdfRootNL::setState( const double* state ) {
+    NlSolver->setState( state );
+}
+
+//----------------------------------------------------------------------
+nlNewtonSolver* wdfRootNL::getNlSolver( ) {
+    return NlSolver.get();
+}
+
+
+#pragma mark Mixed Root
+//==============================================================================
+wdfRootMixed::wdfRootMixed( int numSubtrees,
+                            std::vector<int> nlList,
+                            int solverType ) : wdfRootNL( numSubtrees,
+                                                          nlList,
+                                                          solverType,
+                                                          new matData ) {
+    nlInWaves.reset( new vec( 0 ) );
+    nlOutWaves.reset( new vec( 0 ) );
+}
+
+wdfRootMixed::~wdfRootMixed( ) {
+
+}
+
+//----------------------------------------------------------------------
+void wdfRootMixed::processAscendingWaves( vec* ascendingWaves,
+                                          vec* descendingWaves ) {
+    const double* a = ascendingWaves->memptr( );
+    double* b = descendingWaves->memptr( );
+
+    double* nlIn = nlInWaves->memptr( );
+    for( size_t k = 0; k < nlInputs.size(); k++ ) {
+        nlIn[k] = a[nlInputs[k]];
+    }
+    NlSolver->nlSolve( nlInWaves.get(), nlOutWaves.get() );
+
+    linearKernel.multiply( a, b );
+
+    const double* fNL = NlSolver->getCurrents()->memptr( );
+    const mat& Tmat = rootMatrixData->Tmat;
+    for( size_t r = 0; r < nlOutputs.size(); r++ ) {
+        double sum = 0.0;
+        for( size_t l = 0; l < Tmat.n_cols; l++ ) {
+            sum += Tmat.at( r, l ) * fNL[l];
+        }
+        b[nlOutputs[r]] += sum;
+    }
+}
+
+//----------------------------------------------------------------------
+void wdfRootMixed::prepareRootMatrData( ) {
+    const mat& Emat = rootMatrixData->Emat;
+    const mat& Nmat = rootMatrixData->Nmat;
+    const size_t numNlPorts = Emat.n_rows;
+
+    nlInputs.clear( );
+    for( size_t k = 0; k < Emat.n_cols; k++ ) {
+        for( size_t j = 0; j < numNlPorts; j++ ) {
+            if( Emat.at( j, k ) != 0.0 ) {
+                nlInputs.push_back( k );
+                break;
+            }
+        }
+    }
+    nlOutputs.clear( );
+    for( size_t i = 0; i < Nmat.n_rows; i++ ) {
+        for( size_t l = 0; l < numNlPorts; l++ ) {
+            if( Nmat.at( i, l ) != 0.0 ) {
+                nlOutputs.push_back( i );
+                break;
+            }
+        }
+    }
+
+    nlMatrixData->Emat.set_size( numNlPorts, nlInputs.size() );
+    for( size_t k = 0; k < nlInputs.size(); k++ ) {
+        for( size_t j = 0; j < numNlPorts; j++ ) {
+            nlMatrixData->Emat.at( j, k ) = Emat.at( j, nlInputs[k] );
+        }
+    }
+    nlMatrixData->Fmat = rootMatrixData->Fmat;
+    nlMatrixData->Mmat.set_size( 0, nlInputs.size() );
+    nlMatrixData->Nmat.set_size( 0, numNlPorts );
+
+    rootMatrixData->Tmat.set_size( nlOutputs.size(), numNlPorts );
+    for( size_t r = 0; r < nlOutputs.size(); r++ ) {
+        for( size_t l = 0; l < numNlPorts; l++ ) {
+            rootMatrixData->Tmat.at( r, l ) = Nmat.at( nlOutputs[r], l );
+        }
+    }
+
+    nlInWaves->set_size( nlInputs.size() );
+    linearKernel.setMatrix( rootMatrixData->Mmat );
+    NlSolver->prepareMatrData( );
+}
+
+//----------------------------------------------------------------------
+std::string wdfRootMixed::getType( ) const {
+    return "Root (Mixed-type)";
+}
+
 
 #pragma mark Simple Root
 //==============================================================================
@@ -213,8 +1038,7 @@ void wdfRootSimple::setPortResistances( double * Rp ) {
 //----------------------------------------------------------------------
 void wdfRootSimple::processAscendingWaves( vec* ascendingWaves,
                                            vec* descendingWaves ) {
-    size_t idx = 0;
-    rootElement->calculateDownB( ascendingWaves, descendingWaves, &idx );
+    rootElement->calculateDownB( ascendingWaves->memptr( ), descendingWaves->memptr( ) );
 }
 
 //----------------------------------------------------------------------
@@ -222,6 +1046,31 @@ std::string wdfRootSimple::getType( ) const {
     return "Root (Simple-type)";
 }
 
+//----------------------------------------------------------------------
+wdfRootNode* wdfRootSimple::getRootElement( ) {
+    return rootElement;
+}
+
+//----------------------------------------------------------------------
+void wdfRootSimple::resetState( ) {
+    rootElement->resetState( );
+}
+
+//----------------------------------------------------------------------
+size_t wdfRootSimple::getNumStates( ) {
+    return rootElement->getNumStates( );
+}
+
+//----------------------------------------------------------------------
+void wdfRootSimple::getState( double* state ) {
+    rootElement->getState( state );
+}
+
+//----------------------------------------------------------------------
+void wdfRootSimple::setState( const double* state ) {
+    rootElement->setState( state );
+}
+
 
 #pragma mark - Wave Port -
 //==============================================================================
@@ -297,6 +1146,11 @@ double wdfTreeNode::adaptPorts( double sampleRate ) {
     return upPort->Rp;
 }
 
+//----------------------------------------------------------------------
+double wdfTreeNode::getUpRes( double sampleRate ) const {
+    return 0;
+}
+
 //----------------------------------------------------------------------
 double wdfTreeNode::pullWaveUp( ) {
     for( wdfPort* downPort : downPorts ) {
@@ -316,6 +1170,46 @@ void wdfTreeNode::pushWaveDown( double descendingWave ) {
     }
 }
 
+//----------------------------------------------------------------------
+const std::vector<wdfTreeNode*>& wdfTreeNode::getChildrenNodes( ) const {
+    return childrenNodes;
+}
+
+//----------------------------------------------------------------------
+void wdfTreeNode::resetState( ) {
+    upPort->a = 0;
+    upPort->b = 0;
+    for( wdfPort* downPort : downPorts ) {
+        downPort->a = 0;
+        downPort->b = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+size_t wdfTreeNode::getNumStates( ) {
+    return 2 * ( 1 + downPorts.size() );
+}
+
+//----------------------------------------------------------------------
+void wdfTreeNode::getState( double* state ) {
+    state[0] = upPort->a;
+    state[1] = upPort->b;
+    for( size_t i = 0; i < downPorts.size(); i++ ) {
+        state[2 + 2 * i] = downPorts[i]->a;
+        state[3 + 2 * i] = downPorts[i]->b;
+    }
+}
+
+//----------------------------------------------------------------------
+void wdfTreeNode::setState( const double* state ) {
+    upPort->a = state[0];
+    upPort->b = state[1];
+    for( size_t i = 0; i < downPorts.size(); i++ ) {
+        downPorts[i]->a = state[2 + 2 * i];
+        downPorts[i]->b = state[3 + 2 * i];
+    }
+}
+
 
 #pragma mark - Terminated Adapters -
 //==============================================================================
@@ -396,6 +1290,12 @@ std::string wdfTerminatedRtype::getType( ) const
     return "R-type Adapter (TOP adapted)";
 }
 
+//----------------------------------------------------------------------
+const mat* wdfTerminatedRtype::getScatteringMatrix( ) const
+{
+    return S.get();
+}
+
 
 #pragma mark Terminated Series Adapter
 //==============================================================================
@@ -411,10 +1311,17 @@ wdfTerminatedSeries::wdfTerminatedSeries( wdfTreeNode *left,
 double wdfTerminatedSeries::calculateUpRes( double sampleRate ) {
     const double Rleft  = downPorts[0]->Rp;
     const double Rright = downPorts[1]->Rp;
-    const double Rser   = Rleft + Rright;
+    const double Rser   = wdfSeriesUpRes( Rleft, Rright );
     return ( Rser );
 }
 
+//----------------------------------------------------------------------
+double wdfTerminatedSeries::getUpRes( double sampleRate ) const {
+    const double Rleft  = downPorts[0]->connectedNode->getUpRes( sampleRate );
+    const double Rright = downPorts[1]->connectedNode->getUpRes( sampleRate );
+    return wdfSeriesUpRes( Rleft, Rright );
+}
+
 //----------------------------------------------------------------------
 void wdfTerminatedSeries::calculateScatterCoeffs( ) {
     const double Ru = upPort->Rp;
@@ -422,7 +1329,7 @@ void wdfTerminatedSeries::calculateScatterCoeffs( ) {
     const double Rr = downPorts[1]->Rp;
 
     yu = 1.0;
-    yl = 2.0 * Rl / ( Ru + Rl + Rr );
+    yl = wdfSeriesCoeff( Ru, Rl, Rr );
     yr = 1.0 - yl;
 
     for ( wdfPort* downPort : downPorts ) {
@@ -432,14 +1339,16 @@ void wdfTerminatedSeries::calculateScatterCoeffs( ) {
 
 //----------------------------------------------------------------------
 double wdfTerminatedSeries::calculateUpB( ) {
-    double upB = -( downPorts[0]->a + downPorts[1]->a );
+    double upB = wdfSeriesUpB( downPorts[0]->a, downPorts[1]->a );
     return upB;
 }
 
 //----------------------------------------------------------------------
 void wdfTerminatedSeries::calculateDownB( double descendingWave ) {
-    downPorts[0]->b = yl * ( downPorts[0]->a * ((1.0 / yl) - 1) - downPorts[1]->a - descendingWave );
-    downPorts[1]->b = yr * ( downPorts[1]->a * ((1.0 / yr) - 1) - downPorts[0]->a - descendingWave );
+    wdfSeriesDownB( yl, yr,
+                    downPorts[0]->a, downPorts[1]->a,
+                    descendingWave,
+                    &downPorts[0]->b, &downPorts[1]->b );
 }
 
 //----------------------------------------------------------------------
@@ -466,10 +1375,20 @@ double wdfTerminatedParallel::calculateUpRes( double sampleRate ) {
     assert(Rleft > 0 && "Port resistance must be a nonzero positive number.");
     assert(Rright > 0 && "Port resistance must be a nonzero positive number.");
     
-    const double Rpar   = ( Rleft * Rright ) / ( Rleft + Rright );
+    const double Rpar   = wdfParallelUpRes( Rleft, Rright );
     return Rpar;
 }
 
+//----------------------------------------------------------------------
+double wdfTerminatedParallel::getUpRes( double sampleRate ) const {
+    const double Rleft  = downPorts[0]->connectedNode->getUpRes( sampleRate );
+    const double Rright = downPorts[1]->connectedNode->getUpRes( sampleRate );
+    if( Rleft <= 0 || Rright <= 0 ) {
+        return 0;
+    }
+    return wdfParallelUpRes( Rleft, Rright );
+}
+
 //----------------------------------------------------------------------
 void wdfTerminatedParallel::calculateScatterCoeffs( ) {
     const double Gu = 1.0 / upPort->Rp;
@@ -477,7 +1396,7 @@ void wdfTerminatedParallel::calculateScatterCoeffs( ) {
     const double Gr = 1.0 / downPorts[1]->Rp;
 
     du = 1.0;
-    dl = 2.0 * Gl / ( Gu + Gl + Gr );
+    dl = wdfParallelCoeff( Gu, Gl, Gr );
     dr = 1.0 - dl;
 
     for ( wdfPort* downPort : downPorts ) {
@@ -487,13 +1406,15 @@ void wdfTerminatedParallel::calculateScatterCoeffs( ) {
 
 //----------------------------------------------------------------------
 double wdfTerminatedParallel::calculateUpB( ) {
-    return ( dl * downPorts[0]->a + dr * downPorts[1]->a );
+    return wdfParallelUpB( dl, dr, downPorts[0]->a, downPorts[1]->a );
 }
 
 //----------------------------------------------------------------------
 void wdfTerminatedParallel::calculateDownB( double descendingWave ) {
-    downPorts[0]->b = ( ( dl - 1 ) * downPorts[0]->a + dr * downPorts[1]->a + du * descendingWave );
-    downPorts[1]->b = ( dl * downPorts[0]->a + ( dr - 1 ) * downPorts[1]->a + du * descendingWave );
+    wdfParallelDownB( du, dl, dr,
+                      downPorts[0]->a, downPorts[1]->a,
+                      descendingWave,
+                      &downPorts[0]->b, &downPorts[1]->b );
 }
 
 //----------------------------------------------------------------------
@@ -511,6 +1432,11 @@ double wdfInverter::calculateUpRes( double sampleRate ) {
     return downPorts[0]->Rp;
 }
 
+//----------------------------------------------------------------------
+double wdfInverter::getUpRes( double sampleRate ) const {
+    return downPorts[0]->connectedNode->getUpRes( sampleRate );
+}
+
 //----------------------------------------------------------------------
 void wdfInverter::calculateScatterCoeffs( ) {
     for ( wdfPort* downPort : downPorts ) {
@@ -520,12 +1446,12 @@ void wdfInverter::calculateScatterCoeffs( ) {
 
 //----------------------------------------------------------------------
 double wdfInverter::calculateUpB( ) {
-    return -1 * downPorts[0]->a ;
+    return wdfInverterB( downPorts[0]->a );
 }
 
 //----------------------------------------------------------------------
 void wdfInverter::calculateDownB( double descendingWave ) {
-    downPorts[0]->b = -1 * descendingWave;
+    downPorts[0]->b = wdfInverterB( descendingWave );
 }
 
 //----------------------------------------------------------------------
@@ -562,10 +1488,15 @@ double wdfTerminatedCap::calculateUpRes( double sampleRate ) {
     assert(C > 0 && "capacitance must be a nonzero positive number.");
 
     this->sampleRate = sampleRate;
-    const double R = 1 / ( 2.0 * sampleRate * C );
+    const double R = wdfCapRes( sampleRate, C );
     return R;
 }
 
+//----------------------------------------------------------------------
+double wdfTerminatedCap::getUpRes( double sampleRate ) const {
+    return wdfCapRes( sampleRate, C );
+}
+
 //----------------------------------------------------------------------
 double wdfTerminatedCap::calculateUpB( ) {
     return prevA;
@@ -581,6 +1512,29 @@ std::string wdfTerminatedCap::getType( ) const {
     return "C (adapted)";
 }
 
+//----------------------------------------------------------------------
+void wdfTerminatedCap::resetState( ) {
+    wdfTreeNode::resetState( );
+    prevA = 0;
+}
+
+//----------------------------------------------------------------------
+size_t wdfTerminatedCap::getNumStates( ) {
+    return wdfTreeNode::getNumStates( ) + 1;
+}
+
+//----------------------------------------------------------------------
+void wdfTerminatedCap::getState( double* state ) {
+    wdfTreeNode::getState( state );
+    state[wdfTreeNode::getNumStates()] = prevA;
+}
+
+//----------------------------------------------------------------------
+void wdfTerminatedCap::setState( const double* state ) {
+    wdfTreeNode::setState( state );
+    prevA = state[wdfTreeNode::getNumStates()];
+}
+
 #pragma mark Terminated Inductor
 //==============================================================================
 wdfTerminatedInd::wdfTerminatedInd( double L,
@@ -597,10 +1551,15 @@ double wdfTerminatedInd::calculateUpRes( double sampleRate ) {
     assert(L > 0 && "inductance must be a nonzero positive number.");
 
     this->sampleRate = sampleRate;
-    const double R = 2.0 * sampleRate * L ;
+    const double R = wdfIndRes( sampleRate, L );
     return R;
 }
 
+//----------------------------------------------------------------------
+double wdfTerminatedInd::getUpRes( double sampleRate ) const {
+    return wdfIndRes( sampleRate, L );
+}
+
 //----------------------------------------------------------------------
 double wdfTerminatedInd::calculateUpB( ) {
     return prevA;
@@ -616,6 +1575,29 @@ std::string wdfTerminatedInd::getType( ) const {
     return "L (adapted)";
 }
 
+//----------------------------------------------------------------------
+void wdfTerminatedInd::resetState( ) {
+    wdfTreeNode::resetState( );
+    prevA = 0;
+}
+
+//----------------------------------------------------------------------
+size_t wdfTerminatedInd::getNumStates( ) {
+    return wdfTreeNode::getNumStates( ) + 1;
+}
+
+//----------------------------------------------------------------------
+void wdfTerminatedInd::getState( double* state ) {
+    wdfTreeNode::getState( state );
+    state[wdfTreeNode::getNumStates()] = prevA;
+}
+
+//----------------------------------------------------------------------
+void wdfTerminatedInd::setState( const double* state ) {
+    wdfTreeNode::setState( state );
+    prevA = state[wdfTreeNode::getNumStates()];
+}
+
 #pragma mark Terminated Resistor
 //==============================================================================
 wdfTerminatedRes::wdfTerminatedRes( double R ) : wdfTerminatedLeaf( ),
@@ -628,6 +1610,11 @@ double wdfTerminatedRes::calculateUpRes( double sampleRate ) {
     return R;
 }
 
+//----------------------------------------------------------------------
+double wdfTerminatedRes::getUpRes( double sampleRate ) const {
+    return R;
+}
+
 //----------------------------------------------------------------------
 double wdfTerminatedRes::calculateUpB( ) {
     return 0.0;
@@ -657,6 +1644,11 @@ double wdfTerminatedResVSource::calculateUpRes( double sampleRate ) {
     return RSer;
 }
 
+//----------------------------------------------------------------------
+double wdfTerminatedResVSource::getUpRes( double sampleRate ) const {
+    return RSer;
+}
+
 //----------------------------------------------------------------------
 double wdfTerminatedResVSource::calculateUpB( ) {
     return Vs;
@@ -686,6 +1678,11 @@ double wdfTerminatedResCSource::calculateUpRes( double sampleRate ) {
     return RPar;
 }
 
+//----------------------------------------------------------------------
+double wdfTerminatedResCSource::getUpRes( double sampleRate ) const {
+    return RPar;
+}
+
 //----------------------------------------------------------------------
 double wdfTerminatedResCSource::calculateUpB( ) {
     return RPar * Is;
@@ -722,6 +1719,26 @@ int wdfRootNode::getNumPorts( ){
     return numPorts;
 }
 
+//----------------------------------------------------------------------
+void wdfRootNode::resetState( ) {
+    //do nothing here, might be implemented by a subclass of wdfRootNode..
+}
+
+//----------------------------------------------------------------------
+size_t wdfRootNode::getNumStates( ) {
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void wdfRootNode::getState( double* /*state*/ ) {
+    //do nothing here, might be implemented by a subclass of wdfRootNode..
+}
+
+//----------------------------------------------------------------------
+void wdfRootNode::setState( const double* /*state*/ ) {
+    //do nothing here, might be implemented by a subclass of wdfRootNode..
+}
+
 #pragma mark Unterminated Switch
 //==============================================================================
 //                  U N T E R M I N A T E D   E L E M E N T S
@@ -732,19 +1749,15 @@ wdfUnterminatedSwitch::wdfUnterminatedSwitch( int position ) : wdfRootNode( 1 ),
 }
 
 //----------------------------------------------------------------------
-void wdfUnterminatedSwitch::calculateDownB( vec* ascendingWaves,
-                                            vec* descendingWaves,
-                                            size_t* portIndex ) {
-    size_t idx   = (*portIndex);
-    (*portIndex) = idx+numPorts;
-
+void wdfUnterminatedSwitch::calculateDownB( const double* ascendingWaves,
+                                            double* descendingWaves ) {
     if( position == 0 ) // open
     {
-        (*descendingWaves)[idx] = +1.0 * (*ascendingWaves)[idx];
+        descendingWaves[0] = +1.0 * ascendingWaves[0];
     }
     else                // closed
     {
-        (*descendingWaves)[idx] = -1.0 * (*ascendingWaves)[idx];
+        descendingWaves[0] = -1.0 * ascendingWaves[0];
     }
 }
 
@@ -753,6 +1766,11 @@ void wdfUnterminatedSwitch::setSwitch( int position ) {
     this->position = position;
 }
 
+//----------------------------------------------------------------------
+int wdfUnterminatedSwitch::getSwitch( ) const {
+    return position;
+}
+
 //----------------------------------------------------------------------
 std::string wdfUnterminatedSwitch::getType( ) const {
     return "SW (unadapted)";
@@ -771,13 +1789,12 @@ wdfUnterminatedCap::wdfUnterminatedCap(double C,
 
 
 //----------------------------------------------------------------------
-void wdfUnterminatedCap::calculateDownB( vec* ascendingWaves,
-                                         vec* descendingWaves,
-                                         size_t* portIndex) {
-    descendingWaves->at(*portIndex) = reflectionCoeff * prevB - reflectionCoeff * ascendingWaves->at(*portIndex) + prevA;
-    prevB = descendingWaves->at(*portIndex);
-    prevA = ascendingWaves->at(*portIndex);
-    (*portIndex) += numPorts;
+void wdfUnterminatedCap::calculateDownB( const double* ascendingWaves,
+                                         double* descendingWaves ) {
+    const double a = ascendingWaves[0];
+    prevB = wdfUnterminatedCapB( reflectionCoeff, a, prevA, prevB );
+    prevA = a;
+    descendingWaves[0] = prevB;
 }
 
 //----------------------------------------------------------------------
@@ -785,9 +1802,37 @@ std::string wdfUnterminatedCap::getType( ) const {
     return "C (unadapted)";
 }
 
+//----------------------------------------------------------------------
+double wdfUnterminatedCap::getReflectionCoeff( ) const {
+    return reflectionCoeff;
+}
+
+//----------------------------------------------------------------------
+void wdfUnterminatedCap::resetState( ) {
+    prevA = 0;
+    prevB = 0;
+}
+
+//----------------------------------------------------------------------
+size_t wdfUnterminatedCap::getNumStates( ) {
+    return 2;
+}
+
+//----------------------------------------------------------------------
+void wdfUnterminatedCap::getState( double* state ) {
+    state[0] = prevA;
+    state[1] = prevB;
+}
+
+//----------------------------------------------------------------------
+void wdfUnterminatedCap::setState( const double* state ) {
+    prevA = state[0];
+    prevB = state[1];
+}
+
 void wdfUnterminatedCap::setPortResistance( double Rp ) {
     this->Rp = Rp;
-    reflectionCoeff = (Rp - 1 / (2 * sampleRate * C)) / (Rp + (1 / (2 * sampleRate * C)));
+    reflectionCoeff = wdfUnterminatedCapCoeff( Rp, sampleRate, C );
 }
 
 #pragma mark Unterminated Inductor
@@ -803,13 +1848,12 @@ wdfUnterminatedInd::wdfUnterminatedInd( double L,
 
 
 //----------------------------------------------------------------------
-void wdfUnterminatedInd::calculateDownB( vec* ascendingWaves,
-                                         vec* descendingWaves,
-                                         size_t* portIndex) {
-    descendingWaves->at(*portIndex) = -reflectionCoeff * prevB - reflectionCoeff * ascendingWaves->at(*portIndex) - prevA;
-    prevB = descendingWaves->at(*portIndex);
-    prevA = ascendingWaves->at(*portIndex);
-    (*portIndex) += numPorts;
+void wdfUnterminatedInd::calculateDownB( const double* ascendingWaves,
+                                         double* descendingWaves ) {
+    const double a = ascendingWaves[0];
+    prevB = wdfUnterminatedIndB( reflectionCoeff, a, prevA, prevB );
+    prevA = a;
+    descendingWaves[0] = prevB;
 }
 
 //----------------------------------------------------------------------
@@ -817,9 +1861,37 @@ std::string wdfUnterminatedInd::getType( ) const {
     return "L (unadapted)";
 }
 
+//----------------------------------------------------------------------
+double wdfUnterminatedInd::getReflectionCoeff( ) const {
+    return reflectionCoeff;
+}
+
+//----------------------------------------------------------------------
+void wdfUnterminatedInd::resetState( ) {
+    prevA = 0;
+    prevB = 0;
+}
+
+//----------------------------------------------------------------------
+size_t wdfUnterminatedInd::getNumStates( ) {
+    return 2;
+}
+
+//----------------------------------------------------------------------
+void wdfUnterminatedInd::getState( double* state ) {
+    state[0] = prevA;
+    state[1] = prevB;
+}
+
+//----------------------------------------------------------------------
+void wdfUnterminatedInd::setState( const double* state ) {
+    prevA = state[0];
+    prevB = state[1];
+}
+
 void wdfUnterminatedInd::setPortResistance( double Rp ) {
     this->Rp = Rp;
-    reflectionCoeff = (Rp - 2 * sampleRate * L) / (Rp + 2 * sampleRate * L);
+    reflectionCoeff = wdfUnterminatedIndCoeff( Rp, sampleRate, L );
 }
 
 
@@ -831,11 +1903,9 @@ wdfUnterminatedRes::wdfUnterminatedRes( double R ) : wdfRootNode(1),
 }
 
 //----------------------------------------------------------------------
-void wdfUnterminatedRes::calculateDownB( vec* ascendingWaves,
-                                         vec* descendingWaves,
-                                         size_t* portIndex) {
-    descendingWaves->at(*portIndex) = reflectionCoeff * ascendingWaves->at(*portIndex);
-    (*portIndex) += numPorts;
+void wdfUnterminatedRes::calculateDownB( const double* ascendingWaves,
+                                         double* descendingWaves ) {
+    descendingWaves[0] = reflectionCoeff * ascendingWaves[0];
 }
 
 //----------------------------------------------------------------------
@@ -843,9 +1913,14 @@ std::string wdfUnterminatedRes::getType( ) const {
     return "R (unadapted)";
 }
 
+//----------------------------------------------------------------------
+double wdfUnterminatedRes::getReflectionCoeff( ) const {
+    return reflectionCoeff;
+}
+
 void wdfUnterminatedRes::setPortResistance( double Rp ) {
     this->Rp = Rp;
-    reflectionCoeff = (R - Rp) / (R + Rp);
+    reflectionCoeff = wdfUnterminatedResCoeff( Rp, R );
 }
 
 
@@ -857,11 +1932,9 @@ wdfIdealVSource::wdfIdealVSource( double Vs ) : wdfRootNode(1),
 }
 
 //----------------------------------------------------------------------
-void wdfIdealVSource::calculateDownB( vec* ascendingWaves,
-                                            vec* descendingWaves,
-                                            size_t* portIndex) {
-    descendingWaves->at(*portIndex) = 2 * Vs - ascendingWaves->at(*portIndex);
-    (*portIndex) += numPorts;
+void wdfIdealVSource::calculateDownB( const double* ascendingWaves,
+                                      double* descendingWaves ) {
+    descendingWaves[0] = wdfIdealVSourceB( Vs, ascendingWaves[0] );
 }
 
 //----------------------------------------------------------------------
@@ -882,11 +1955,9 @@ wdfIdealCSource::wdfIdealCSource( double Is ) : wdfRootNode(1),
 }
 
 //----------------------------------------------------------------------
-void wdfIdealCSource::calculateDownB( vec* ascendingWaves,
-                                      vec* descendingWaves,
-                                      size_t* portIndex) {
-    descendingWaves->at(*portIndex) = 2 * Rp * Is + ascendingWaves->at(*portIndex);
-    (*portIndex) += numPorts;
+void wdfIdealCSource::calculateDownB( const double* ascendingWaves,
+                                      double* descendingWaves ) {
+    descendingWaves[0] = wdfIdealCSourceB( Rp, Is, ascendingWaves[0] );
 }
 
 //----------------------------------------------------------------------
@@ -30,7 +30,11 @@
 #define __RTWDF_H__
 
 //==============================================================================
+#include <cstdint>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 
 
 
@@ -38,6 +42,29 @@
 // include nlSolverClass for nonlinear solvers
 #include "rt-wdf_types.h"
 #include "rt-wdf_nlSolvers.h"
+#include "rt-wdf_matVec.h"
+#include "rt-wdf_threadPool.h"
+#include "rt-wdf_denormals.h"
+
+
+//==============================================================================
+// State snapshot format
+
+/** Magic number at the start of every state snapshot ("WDFS") */
+#define WDF_STATE_MAGIC     0x53464457
+/** Version of the snapshot layout */
+#define WDF_STATE_VERSION   1
+
+
+//==============================================================================
+// DC operating point config parameters
+
+/** tolerance for the Newton step of the delay elements, relative to their size */
+#define DCOP_TOL        1.0e-09
+/** limit on Newton iterations */
+#define DCOP_ITMAX      100
+/** relative step size of the finite difference Jacobian */
+#define DCOP_FD_STEP    1.0e-06
 
 
 //==============================================================================
@@ -50,6 +77,7 @@ class wdfTree;
 class wdfRoot;
     class wdfRootRtype;
     class wdfRootNL;
+        class wdfRootMixed;
     class wdfRootSimple;
 
 // UTILITIES:
@@ -158,6 +186,117 @@ protected:
      */
     std::vector<paramData> params;
 
+private:
+    //----------------------------------------------------------------------
+    /**
+     Root matrices that were computed by setRootMatrData() for a set of port
+     resistances, most recently used first.
+     */
+    typedef struct rootMatrCacheEntry {
+        std::vector<double> Rp;
+        matData data;
+    } rootMatrCacheEntry;
+    std::list<rootMatrCacheEntry> rootMatrCache;
+
+    //----------------------------------------------------------------------
+    /**
+     Maximum number of entries in rootMatrCache, 0 to disable the cache.
+     */
+    size_t rootMatrCacheSize;
+
+    //----------------------------------------------------------------------
+    /**
+     Root matrices that were computed by prepareSamplerate(), keyed by the
+     sample rate. The port resistances are kept to detect parameter changes
+     since the rate was prepared.
+     */
+    std::map<double, rootMatrCacheEntry> samplerateCache;
+
+    //----------------------------------------------------------------------
+    /**
+     Serializes the calls to setRootMatrDataAt() and guards
+     samplerateCache, so prepareSamplerate() can run on a worker thread.
+     */
+    std::mutex rootMatrMutex;
+
+    //----------------------------------------------------------------------
+    /**
+     Adapts all subtrees to treeSampleRate and passes the resulting port
+     resistances to the root, without updating the root matrices.
+     */
+    void adaptSubtrees( );
+
+    //----------------------------------------------------------------------
+    /**
+     Fingerprint and number of values of a state snapshot, computed once by
+     the first call to getStateSize().
+     */
+    uint64_t stateFingerprint;
+    size_t stateNumValues;
+
+    //----------------------------------------------------------------------
+    /**
+     Copies the state of all nodes and the root from or to a buffer in
+     snapshot order. Without buffers it computes stateFingerprint and
+     stateNumValues.
+     */
+    void walkState( double* saveTo,
+                    const double* loadFrom );
+
+    //----------------------------------------------------------------------
+    /**
+     Pool that evaluates the subtrees in parallel, NULL for serial
+     evaluation.
+     */
+    std::unique_ptr<wdfThreadPool> threadPool;
+
+    //----------------------------------------------------------------------
+    /**
+     Indices of the subtrees that are evaluated by each thread of the pool.
+     */
+    std::vector<std::vector<size_t>> threadSubtrees;
+
+    //----------------------------------------------------------------------
+    /**
+     True if processBlock() runs in guard mode, see setGuardMode().
+     */
+    bool guardMode;
+
+    //----------------------------------------------------------------------
+    /**
+     Number of subtrees and roots that were reset by the guard.
+     */
+    size_t guardResets;
+
+    //----------------------------------------------------------------------
+    /**
+     Buffer for the root state that is checked by the guard.
+     */
+    std::vector<double> guardRootState;
+
+    //----------------------------------------------------------------------
+    /**
+     Resets all subtrees and the root whose waves or state became NaN or
+     Inf and replaces non-finite output samples with zero.
+
+     @param output              output block of processBlock()
+     @param numSamples          number of samples in the block
+     */
+    void guardState( double* output,
+                     size_t numSamples );
+
+    //----------------------------------------------------------------------
+    /**
+     Thread pool tasks that set the flush-to-zero mode of the workers
+     according to guardMode, or pull or push the subtrees of one thread.
+     */
+    static void applyGuardMode( void* context,
+                                size_t threadIndex );
+    static void pullSubtrees( void* context,
+                              size_t threadIndex );
+    static void pushSubtrees( void* context,
+                              size_t threadIndex );
+
 public:
     //----------------------------------------------------------------------
     /**
@@ -196,6 +335,150 @@ public:
      */
     int adaptTree( );
 
+    //----------------------------------------------------------------------
+    /**
+     Enables a cache of root matrices keyed by the port resistances at the
+     root.
+
+     adaptTree() then only calls setRootMatrData() for port resistances
+     that are not in the cache. This pays off when parameters are switched
+     back and forth (presets, sweeps) or when a parameter does not change
+     the port resistances at the root at all. It is only valid if
+     setRootMatrData() depends on nothing but the port resistances.
+
+     @param maxEntries          number of cached matrix sets, the least
+                                recently used set is dropped first. 0
+                                disables and clears the cache.
+     */
+    void setRootMatrCacheSize( size_t maxEntries );
+
+    //----------------------------------------------------------------------
+    /**
+     Computes the root matrices for a sample rate in advance.
+
+     The expensive part of an adaptation is setRootMatrData(). This function
+     runs setRootMatrDataAt() for fs into a separate matData object and keeps
+     the result, so a later setSamplerate( fs ) followed by adaptTree()
+     adapts the subtrees, copies the cached matrices and lets the root
+     prepare them without deriving them again. That skips the matrix
+     inversions, but adaptTree() is still not realtime safe: the copy and
+     prepareRootMatrData() (scattering kernels, NL solver products) allocate
+     memory.
+
+     Nothing of the live tree is written: the port resistances at fs are
+     calculated by the const getUpRes() walk and fs is passed to
+     setRootMatrDataAt() explicitly. The finished entry is published under a
+     lock, so this function may run on a worker thread while the audio
+     thread keeps processing; only adaptTree() waits for it. It must not run
+     concurrently with parameter changes, since the walk reads the component
+     values. Call it for all rates a host may switch to (including
+     oversampled rates).
+
+     A prepared rate is only used while the port resistances at the root
+     match the ones it was prepared with; after a parameter change it falls
+     back to setRootMatrData() (or the cache of setRootMatrCacheSize()) until
+     it is prepared again.
+
+     @param fs                  samplerate to prepare
+     @returns                   0 for success, -1 if a subtree does not
+                                implement getUpRes() or the root matrices
+                                could not be derived
+     */
+    int prepareSamplerate( double fs );
+
+    //----------------------------------------------------------------------
+    /**
+     Drops all root matrices that were computed by prepareSamplerate().
+     */
+    void clearSamplerateCache( );
+
+    //----------------------------------------------------------------------
+    /**
+     Resets the dynamic state of the tree to that of a new tree: all waves,
+     the delay elements of reactive elements and the NL solver guess are
+     set to zero. Coefficients and parameters are kept.
+     */
+    void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the size of a state snapshot of this tree in bytes.
+
+     @returns                   the size of the snapshot
+     */
+    size_t getStateSize( );
+
+    //----------------------------------------------------------------------
+    /**
+     Stores the complete dynamic state of the tree in a binary snapshot.
+
+     The snapshot starts with a header (all fields in host byte order):
+
+         uint32  WDF_STATE_MAGIC
+         uint32  WDF_STATE_VERSION
+         uint64  fingerprint of the tree structure
+         double  sample rate
+         uint64  number of state values
+
+     followed by the state values as doubles: the states of all nodes of
+     each subtree in depth-first order (port waves and delay elements),
+     the ascending and descending waves at the root and finally the state
+     of the root (unadapted elements, NL solver). The fingerprint is a hash
+     of the node types and state sizes, so a snapshot can only be restored
+     into a tree with the same structure. Parameters and coefficients are
+     not part of the snapshot.
+
+     @param snapshot            is a pointer to a buffer that is resized to
+                                getStateSize() and filled with the snapshot
+     */
+    void saveState( std::vector<unsigned char>* snapshot );
+
+    //----------------------------------------------------------------------
+    /**
+     Restores the dynamic state of the tree from a snapshot that was taken
+     by saveState() of this or another tree with the same structure and
+     sample rate. Once the snapshot layout is known (after the first call
+     to getStateSize(), saveState() or restoreState()) this does not
+     allocate memory, so preset A/B switching can be done on the audio
+     thread.
+
+     @param snapshot            pointer to the snapshot
+     @param size                size of the snapshot in bytes
+
+     @returns                   0 for success, -1 if the snapshot does not
+                                match the tree
+     */
+    int restoreState( const unsigned char* snapshot,
+                      size_t size );
+
+    //----------------------------------------------------------------------
+    /**
+     Initializes the tree in its DC operating point for a constant input.
+
+     For a constant input the DC solution (capacitors open, inductors
+     shorted) is exactly the fixed point of cycleWave() in the delay
+     elements of all reactive elements: a trapezoidal capacitor with
+     b = prevA = a reflects like an open circuit, an inductor with
+     b = -a like a short. This function finds that fixed point with a
+     Newton iteration on the delay elements and a finite difference
+     Jacobian, where every evaluation is one cycleWave() from a snapshot
+     of the tree. The NL solver is solved along the way, so its guess ends
+     up at the operating point as well.
+
+     Afterwards the tree continues from the operating point without
+     start-up transient. Must be called after adaptTree().
+
+     @param inputValue          constant input value passed to
+                                setInputValue(), e.g. 0 for silence
+
+     @returns                   0 for success, -1 if the iteration did not
+                                converge. The state of the tree is left
+                                unchanged in that case, but inputValue stays
+                                applied: wdfTree cannot read back the
+                                previous input, so set it again if needed.
+     */
+    int initOperatingPoint( double inputValue );
+
     //----------------------------------------------------------------------
     /**
      Virtual placeholder function that is meant to update a root's matrix
@@ -216,6 +499,30 @@ public:
     virtual int setRootMatrData( matData* rootMatrixData,
                                  double *Rp ) = 0;
 
+    //----------------------------------------------------------------------
+    /**
+     Updates a root's matrix elements for the port resistances of the
+     subtrees at an explicitly given sample rate.
+
+     Called by adaptTree() with the tree's sample rate and by
+     prepareSamplerate() with the rate to prepare, possibly on another
+     thread while the tree is processed. Calls are serialized, but an
+     implementation must take everything it needs from its arguments and
+     not from treeSampleRate or the state of the subtrees. The default
+     calls setRootMatrData(), which is right for roots whose matrices only
+     depend on the port resistances.
+
+     @param rootMatrixData      is a pointer to the matData object to fill
+     @param Rp                  is a vector of port resistances of all
+                                subtrees of the root at fs.
+     @param fs                  sample rate the port resistances belong to
+
+     @returns                   0 for success, -1 for error
+     */
+    virtual int setRootMatrDataAt( matData* rootMatrixData,
+                                   double *Rp,
+                                   double fs );
+
     //----------------------------------------------------------------------
     /**
      High level function that is called to evaluate the WDF structure for
@@ -223,9 +530,86 @@ public:
 
      It pulls the waves from all connected subtrees, passes them to the
      root and finally pushes the roots' answer down back into the subtrees.
+     If a thread pool was set up with setNumThreads(), the subtrees are
+     pulled and pushed in parallel.
      */
     void cycleWave( );
 
+    //----------------------------------------------------------------------
+    /**
+     Evaluates a block of samples by calling setInputValue(), cycleWave()
+     and getOutputValue() for every sample.
+
+     @param input               array of numSamples input values
+     @param output              array to store numSamples output values, may
+                                be the same as input
+     @param numSamples          number of samples to process
+     */
+    void processBlock( const double* input,
+                       double* output,
+                       size_t numSamples );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets the number of threads that evaluate the subtrees in cycleWave().
+
+     The subtrees hanging off the root are independent during the pull and
+     the push phase, so they can be distributed over a thread pool. They
+     are assigned to the threads once, balanced by their number of nodes.
+     Each sample costs two barriers, so this only speeds up trees with
+     many nodes per thread and is intended for offline rendering. Must be
+     called after initTree() and not while cycleWave() runs.
+
+     @param numThreads          number of threads including the calling
+                                thread, 1 for serial evaluation. Is limited
+                                to the number of subtrees.
+
+     @returns                   0 for success, -1 for error
+     */
+    int setNumThreads( size_t numThreads );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of threads that evaluate the subtrees.
+
+     @returns                   the number of threads, 1 for serial evaluation
+     */
+    size_t getNumThreads( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Enables the guard mode of processBlock().
+
+     In guard mode every block is processed with flush-to-zero enabled (see
+     wdfDenormalScope), so decaying waves in reactive elements do not drift
+     into slow subnormal numbers when the input goes silent. After each
+     block the waves at the root and the root state are checked for NaN and
+     Inf. A subtree whose waves are not finite is reset to zero (see
+     resetState()), the root as well if its state or one of its descending
+     waves is not finite, so a single diverged solve does not silence the
+     tree forever. Non-finite output samples of that block are set to zero.
+
+     The worker threads of setNumThreads() keep flush-to-zero enabled for
+     as long as the guard mode is on; it is set once per worker by a pool
+     task when the mode or the number of threads changes. The calling thread
+     only flushes inside processBlock().
+
+     The check costs O(subtrees) per block. cycleWave() is not guarded.
+     Must be called after initTree().
+
+     @param enabled             true to enable the guard mode
+     */
+    void setGuardMode( bool enabled );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of subtrees and roots that were reset by the guard
+     since the guard mode was enabled.
+
+     @returns                   the number of resets
+     */
+    size_t getNumGuardResets( ) const;
+
     //----------------------------------------------------------------------
     /**
      Virtual placeholder function that is meant to set the circuit's input
@@ -268,6 +652,31 @@ public:
      */
     const std::vector<paramData>& getParams( );
 
+    //----------------------------------------------------------------------
+    /**
+     Function that returns a pointer to the root of the tree.
+
+     @returns                   a pointer to the root object
+     */
+    wdfRoot* getRoot( );
+
+    //----------------------------------------------------------------------
+    /**
+     Function that returns the number of subtrees hanging off the root.
+
+     @returns                   the number of subtrees
+     */
+    size_t getSubtreeCount( );
+
+    //----------------------------------------------------------------------
+    /**
+     Function that returns the first node of a subtree.
+
+     @param index               index of the subtree
+     @returns                   a pointer to the subtree's entry node
+     */
+    wdfTreeNode* getSubtreeEntryNode( size_t index );
+
     //----------------------------------------------------------------------
     /**
      Virtual placeholder function that is meant to set a specific parameter to
@@ -347,6 +756,50 @@ public:
      */
     virtual matData* getRootMatrPtr( );
 
+    //----------------------------------------------------------------------
+    /**
+     Function that does nothing if not overwritten by a method in a subclass.
+
+     Is called by adaptTree() after the tree has successfully populated the
+     rootMatrixData element, so a root can precompute anything that only
+     depends on its matrices.
+     */
+    virtual void prepareRootMatrData( );
+
+    //----------------------------------------------------------------------
+    /**
+     Function that does nothing if not overwritten by a method in a subclass.
+
+     Resets the dynamic state of the root (unadapted reactive elements,
+     solver guess) to that of a new root.
+     */
+    virtual void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of state values of the root, 0 if not overwritten
+     by a method in a subclass.
+
+     @returns                   the number of doubles of the root state
+     */
+    virtual size_t getNumStates( );
+
+    //----------------------------------------------------------------------
+    /**
+     Stores the state of the root.
+
+     @param state               array of getNumStates() values
+     */
+    virtual void getState( double* state );
+
+    //----------------------------------------------------------------------
+    /**
+     Restores the state of the root.
+
+     @param state               array of getNumStates() values
+     */
+    virtual void setState( const double* state );
+
     //----------------------------------------------------------------------
     /**
      Virtual placeholder function that is meant to return a String
@@ -361,7 +814,7 @@ public:
 //==============================================================================
 class wdfRootRtype : public wdfRoot {
 
-private:
+protected:
     //----------------------------------------------------------------------
     /**
      Pointer to an object which holds all matrices of coefficients of the
@@ -375,11 +828,22 @@ private:
      */
     int numSubtrees;
 
+    //----------------------------------------------------------------------
+    /**
+     Allocation-free kernel for the product with the S-Matrix.
+     */
+    wdfMatVec scatteringKernel;
+
 public:
     //----------------------------------------------------------------------
     /**
      R-type root implementation.
 
+     After each adaptation the S-Matrix is analyzed once and stored in the
+     cheapest of a dense, sparse or low-rank representation (see wdfMatVec),
+     so the per-sample cost of large roots scales with the nonzeros or the
+     rank of S instead of numSubtrees^2.
+
      @param numSubtrees         specifies the number of subtrees which are
                                 connected to the root to correctly allocate
                                 memory for rootMatrixData
@@ -390,14 +854,144 @@ public:
     /**
      Deconstructor
      */
-    ~wdfRootRtype( );
+    ~wdfRootRtype( );
+
+    //----------------------------------------------------------------------
+    /**
+     Function to process a vector of ascending waves in the root and return
+     the descending result.
+
+     Scatters the incoming waves according to the S-Matrix of rootMatrixData.
+
+     @param *ascendingWaves     is a pointer to a vector of waves that were
+                                collected at the upfacing ports of the subtrees,
+                                traveling into the root.
+     @param *descendingWaves    is a pointer to a vector to store the resulting
+                                waves that leave the root afterprocessing into
+                                the subtrees
+     */
+    virtual void processAscendingWaves( vec* ascendingWaves,
+                                        vec* descendingWaves );
+
+    //----------------------------------------------------------------------
+    /**
+     Analyzes the S-Matrix for the scattering kernel.
+     */
+    virtual void prepareRootMatrData( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the kernel that holds the analyzed S-Matrix.
+
+     @returns                   a reference to the scattering kernel
+     */
+    const wdfMatVec& getScatteringKernel( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Function that returns a pointer to the rootMatrixData element.
+
+     The pointer is be used to populate or update the S-Matrix of the
+     R-type adapter by the setRootMatrData() function of the tree.
+
+     @returns                   matData* to the rootMatrixData element
+     */
+    virtual matData* getRootMatrPtr( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns a String describing the type of this root.
+
+     @returns                   a String describing the type of this root as
+                                "Root (R-type)"
+     */
+    virtual std::string getType( ) const;
+
+};
+
+
+
+//==============================================================================
+class wdfRootNL : public wdfRoot {
+
+protected:
+    //----------------------------------------------------------------------
+    /**
+     Pointer to an object which holds all matrices of coefficients of the
+     root.
+     */
+    std::unique_ptr<matData> rootMatrixData;
+
+    //----------------------------------------------------------------------
+    /**
+     Matrices the NL solver works on if they differ from rootMatrixData
+     (reduced system of wdfRootMixed), empty otherwise.
+     */
+    std::unique_ptr<matData> nlMatrixData;
+
+    //----------------------------------------------------------------------
+    /**
+     Number of subtrees which are connected to the root.
+     */
+    int numSubtrees;
+
+    //----------------------------------------------------------------------
+    /**
+     Pointer to a NL Solver which solves the implicit scattering loop
+     around the non-linearities in the root.
+     */
+    std::unique_ptr<nlNewtonSolver> NlSolver;
+
+    //----------------------------------------------------------------------
+    /**
+     Creates the root with a NL solver that works on separate matrices.
+
+     @param numSubtrees         specifies the number of subtrees which are
+                                connected to the root to correctly allocate
+                                memory for rootMatrixData
+     @param nlList              is a vector defines that map to available
+                                NL models. See nlModelClass.h for all models
+     @param solverType          sets the solver to use in this root. See
+                                nlSolverClass.h for all solvers.
+     @param solverMatrixData    matrices for the NL solver, the root takes
+                                ownership. NULL to solve on rootMatrixData.
+     */
+    wdfRootNL( int numSubtrees,
+               std::vector<int> nlList,
+               int solverType,
+               matData* solverMatrixData );
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Multiple/Multiport Non-Linearities root implementation.
+
+     @param numSubtrees         specifies the number of subtrees which are
+                                connected to the root to correctly allocate
+                                memory for rootMatrixData
+     @param nlList              is a vector defines that map to available
+                                NL models. See nlModelClass.h for all models
+     @param solverType          sets the solver to use in this root. See
+                                nlSolverClass.h for all solvers.
+     */
+    wdfRootNL( int numSubtrees,
+               std::vector<int> nlList,
+               int solverType );
+
+    //----------------------------------------------------------------------
+    /**
+     Deconstructor
+     */
+    ~wdfRootNL( );
 
     //----------------------------------------------------------------------
     /**
      Function to process a vector of ascending waves in the root and return
      the descending result.
 
-     Scatters the incoming waves according to the S-Matrix of rootMatrixData.
+     Scatters the waves according to the R-type connector towards the
+     non-linearities, solves the inner loop with a NLSolver and returns
+     the result.
 
      @param *ascendingWaves     is a pointer to a vector of waves that were
                                 collected at the upfacing ports of the subtrees,
@@ -409,12 +1003,18 @@ public:
     virtual void processAscendingWaves( vec* ascendingWaves,
                                         vec* descendingWaves );
 
+    //----------------------------------------------------------------------
+    /**
+     Lets the NL solver analyze the new root matrices.
+     */
+    virtual void prepareRootMatrData( );
+
     //----------------------------------------------------------------------
     /**
      Function that returns a pointer to the rootMatrixData element.
 
-     The pointer is be used to populate or update the S-Matrix of the
-     R-type adapter by the setRootMatrData() function of the tree.
+     The pointer is be used to populate or update the E,-F-,M-,N-Matrices
+     of the root loop by the setRootMatrData() function of the tree.
 
      @returns                   matData* to the rootMatrixData element
      */
@@ -425,42 +1025,88 @@ public:
      Returns a String describing the type of this root.
 
      @returns                   a String describing the type of this root as
-                                "Root (R-type)"
+                                "Root (NL-type)"
      */
     virtual std::string getType( ) const;
 
-};
+    //----------------------------------------------------------------------
+    /**
+     Function that returns a pointer to the NL solver of this root.
+
+     @returns                   a pointer to the NL solver
+     */
+    nlNewtonSolver* getNlSolver( );
+
+    //----------------------------------------------------------------------
+    /**
+     Resets the NL solver to its initial guess.
+     */
+    virtual void resetState( );
 
+    //----------------------------------------------------------------------
+    /**
+     State of the NL solver.
+     */
+    virtual size_t getNumStates( );
+    virtual void getState( double* state );
+    virtual void setState( const double* state );
 
+};
 
 //==============================================================================
-class wdfRootNL : public wdfRoot {
+class wdfRootMixed : public wdfRootNL {
 
 private:
     //----------------------------------------------------------------------
     /**
-     Pointer to an object which holds all matrices of coefficients of the
-     root.
+     Indices of the subtrees whose waves reach the non-linear ports
+     (nonzero columns of Emat).
      */
-    std::unique_ptr<matData> rootMatrixData;
+    std::vector<size_t> nlInputs;
 
     //----------------------------------------------------------------------
     /**
-     Number of subtrees which are connected to the root.
+     Indices of the subtrees that receive non-linear currents (nonzero rows
+     of Nmat). Their rows of Nmat are stored in Tmat.
      */
-    int numSubtrees;
+    std::vector<size_t> nlOutputs;
 
     //----------------------------------------------------------------------
     /**
-     Pointer to a NL Solver which solves the implicit scattering loop
-     around the non-linearities in the root.
+     Allocation-free kernel for the product with the M-Matrix.
      */
-    std::unique_ptr<nlNewtonSolver> NlSolver;
+    wdfMatVec linearKernel;
+
+    //----------------------------------------------------------------------
+    /**
+     Ascending waves of the subtrees in nlInputs.
+     */
+    std::unique_ptr<vec> nlInWaves;
+
+    //----------------------------------------------------------------------
+    /**
+     Empty output of the solver, the descending waves are calculated by the
+     root itself.
+     */
+    std::unique_ptr<vec> nlOutWaves;
 
 public:
     //----------------------------------------------------------------------
     /**
-     Multiple/Multiport Non-Linearities root implementation.
+     Mixed linear / non-linear root implementation.
+
+     Drop-in replacement of wdfRootNL: the tree populates E,F,M,N exactly
+     like for a NL root. After each adaptation the root splits the ports into
+     a linear and a non-linear part. Only subtrees with a nonzero column in
+     Emat are passed to the NL solver, the linear part M*a is calculated by
+     an allocation-free kernel and the non-linear currents are only added to
+     the ports with a nonzero row in Nmat (compressed into Tmat).
+
+     Only the linear inputs and outputs are pruned. The NL solver still runs
+     on all numNLPorts ports of the models in nlList, since every port of a
+     device model is coupled through its Jacobian. The solver matrices are
+     kept in nlMatrixData: Emat restricted to the subtrees in nlInputs and
+     Fmat.
 
      @param numSubtrees         specifies the number of subtrees which are
                                 connected to the root to correctly allocate
@@ -470,25 +1116,21 @@ public:
      @param solverType          sets the solver to use in this root. See
                                 nlSolverClass.h for all solvers.
      */
-    wdfRootNL( int numSubtrees,
-               std::vector<int> nlList,
-               int solverType );
+    wdfRootMixed( int numSubtrees,
+                  std::vector<int> nlList,
+                  int solverType );
 
     //----------------------------------------------------------------------
     /**
      Deconstructor
      */
-    ~wdfRootNL( );
+    ~wdfRootMixed( );
 
     //----------------------------------------------------------------------
     /**
      Function to process a vector of ascending waves in the root and return
      the descending result.
 
-     Scatters the waves according to the R-type connector towards the
-     non-linearities, solves the inner loop with a NLSolver and returns
-     the result.
-
      @param *ascendingWaves     is a pointer to a vector of waves that were
                                 collected at the upfacing ports of the subtrees,
                                 traveling into the root.
@@ -501,21 +1143,16 @@ public:
 
     //----------------------------------------------------------------------
     /**
-     Function that returns a pointer to the rootMatrixData element.
-
-     The pointer is be used to populate or update the E,-F-,M-,N-Matrices
-     of the root loop by the setRootMatrData() function of the tree.
-
-     @returns                   matData* to the rootMatrixData element
+     Splits the root into its linear and non-linear part.
      */
-    virtual matData* getRootMatrPtr( );
+    virtual void prepareRootMatrData( );
 
     //----------------------------------------------------------------------
     /**
      Returns a String describing the type of this root.
 
      @returns                   a String describing the type of this root as
-                                "Root (NL-type)"
+                                "Root (Mixed-type)"
      */
     virtual std::string getType( ) const;
 
@@ -576,6 +1213,28 @@ public:
      */
     virtual std::string getType( ) const ;
 
+    //----------------------------------------------------------------------
+    /**
+     Function that returns a pointer to the root element.
+
+     @returns                   a pointer to the single unadapted root element
+     */
+    wdfRootNode* getRootElement( );
+
+    //----------------------------------------------------------------------
+    /**
+     Resets the state of the root element.
+     */
+    virtual void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     State of the root element.
+     */
+    virtual size_t getNumStates( );
+    virtual void getState( double* state );
+    virtual void setState( const double* state );
+
 };
 
 # pragma mark - Basic Tree Classes
@@ -729,6 +1388,24 @@ public:
      */
     double adaptPorts( double sampleRate );
 
+    //----------------------------------------------------------------------
+    /**
+     Recursively calculates the up-facing port resistance at another sample
+     rate without adapting the tree.
+
+     Only reads the component values and writes nothing, so it may run on
+     another thread while the tree is processed. The adapters and leaves of
+     this library implement it; the default returns 0 to signal that the
+     node does not support it, so a user-defined subclass of
+     wdfTerminatedRtype must override it to be used with
+     wdfTree::prepareSamplerate().
+
+     @param sampleRate          sample rate to calculate the resistance for
+     @returns                   a double type up-facing port resistance of that
+                                WDF element at sampleRate, 0 if unsupported
+     */
+    virtual double getUpRes( double sampleRate ) const;
+
     //----------------------------------------------------------------------
     /**
      Virtual placeholder function that is meant to return the nodes' upfacing
@@ -816,6 +1493,49 @@ public:
      */
     virtual std::string getType( ) const = 0;
 
+    //----------------------------------------------------------------------
+    /**
+     Function that returns the children of this node.
+
+     @returns                   a vector of pointers to all children that are
+                                connected to the downfacing ports
+     */
+    const std::vector<wdfTreeNode*>& getChildrenNodes( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Resets the dynamic state of this node (not of its children): sets the
+     waves of all ports to zero. Nodes with delay elements additionally
+     clear them.
+     */
+    virtual void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of state values of this node (not of its children):
+     the waves a and b of the upfacing and all downfacing ports plus the
+     delay elements of nodes that have them.
+
+     @returns                   the number of doubles of the node state
+     */
+    virtual size_t getNumStates( );
+
+    //----------------------------------------------------------------------
+    /**
+     Stores the state of this node.
+
+     @param state               array of getNumStates() values
+     */
+    virtual void getState( double* state );
+
+    //----------------------------------------------------------------------
+    /**
+     Restores the state of this node.
+
+     @param state               array of getNumStates() values
+     */
+    virtual void setState( const double* state );
+
     //----------------------------------------------------------------------
     /**
      Pointer to the upfacing port object of this node.
@@ -965,6 +1685,14 @@ public:
      */
     virtual std::string getType( ) const;
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the scattering matrix of the adaptor.
+
+     @returns                   a pointer to the scattering matrix S
+     */
+    const mat* getScatteringMatrix( ) const;
+
 protected:
     //----------------------------------------------------------------------
     /**
@@ -1023,6 +1751,18 @@ public:
      */
     virtual double calculateUpRes( double sampleRate );
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the upfacing port resistance at another sample rate without
+     adapting the node: Rup = Rleft + Rright with the resistances of both children at
+     sampleRate.
+
+     @param sampleRate          sample rate to calculate the resistance for
+     @returns                   a double type port resistance of that element
+                                in Ohms
+     */
+    virtual double getUpRes( double sampleRate ) const;
+
     //----------------------------------------------------------------------
     /**
      Recursively calculates scattering coefficients of adapters.
@@ -1116,6 +1856,18 @@ public:
      */
     virtual double calculateUpRes( double sampleRate );
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the upfacing port resistance at another sample rate without
+     adapting the node: Rup = Rleft * Rright / ( Rleft + Rright ) with the resistances of
+     both children at sampleRate.
+
+     @param sampleRate          sample rate to calculate the resistance for
+     @returns                   a double type port resistance of that element
+                                in Ohms
+     */
+    virtual double getUpRes( double sampleRate ) const;
+
     //----------------------------------------------------------------------
     /**
      Recursively calculates scattering coefficients of adapters.
@@ -1191,6 +1943,17 @@ public:
      */
     virtual double calculateUpRes( double sampleRate );
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the upfacing port resistance at another sample rate without
+     adapting the node: Rup = Rchild with the resistance of the child at sampleRate.
+
+     @param sampleRate          sample rate to calculate the resistance for
+     @returns                   a double type port resistance of that element
+                                in Ohms
+     */
+    virtual double getUpRes( double sampleRate ) const;
+
     //----------------------------------------------------------------------
     /**
      Recursively calculates scattering coefficients of adapters.
@@ -1294,6 +2057,17 @@ public:
      */
     virtual double calculateUpRes( double sampleRate );
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the upfacing port resistance at another sample rate without
+     adapting the node: Rup = 1 / ( 2.0 * sampleRate * C ).
+
+     @param sampleRate          sample rate to calculate the resistance for
+     @returns                   a double type port resistance of that element
+                                in Ohms
+     */
+    virtual double getUpRes( double sampleRate ) const;
+
     //----------------------------------------------------------------------
     /**
      Returns the upfacing wave component towards the root.
@@ -1327,6 +2101,20 @@ public:
      */
     virtual std::string getType( ) const;
 
+    //----------------------------------------------------------------------
+    /**
+     Resets the ports and the delay element.
+     */
+    virtual void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     State of the ports and the delay element.
+     */
+    virtual size_t getNumStates( );
+    virtual void getState( double* state );
+    virtual void setState( const double* state );
+
     //----------------------------------------------------------------------
     /**
      Capacitance in Farad
@@ -1374,6 +2162,17 @@ public:
      */
     virtual double calculateUpRes( double sampleRate );
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the upfacing port resistance at another sample rate without
+     adapting the node: Rup = 2.0 * sampleRate * L.
+
+     @param sampleRate          sample rate to calculate the resistance for
+     @returns                   a double type port resistance of that element
+                                in Ohms
+     */
+    virtual double getUpRes( double sampleRate ) const;
+
     //----------------------------------------------------------------------
     /**
      Returns the upfacing wave component towards the root.
@@ -1408,6 +2207,20 @@ public:
      */
     virtual std::string getType( ) const;
 
+    //----------------------------------------------------------------------
+    /**
+     Resets the ports and the delay element.
+     */
+    virtual void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     State of the ports and the delay element.
+     */
+    virtual size_t getNumStates( );
+    virtual void getState( double* state );
+    virtual void setState( const double* state );
+
     //----------------------------------------------------------------------
     /**
      Inductance in Henry
@@ -1453,6 +2266,17 @@ public:
      */
     virtual double calculateUpRes( double sampleRate );
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the upfacing port resistance at another sample rate without
+     adapting the node: Rup = R.
+
+     @param sampleRate          sample rate to calculate the resistance for
+     @returns                   a double type port resistance of that element
+                                in Ohms
+     */
+    virtual double getUpRes( double sampleRate ) const;
+
     //----------------------------------------------------------------------
     /**
      Returns the upfacing wave component towards the root.
@@ -1525,6 +2349,17 @@ public:
      */
     virtual double calculateUpRes( double sampleRate );
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the upfacing port resistance at another sample rate without
+     adapting the node: Rup = RSer.
+
+     @param sampleRate          sample rate to calculate the resistance for
+     @returns                   a double type port resistance of that element
+                                in Ohms
+     */
+    virtual double getUpRes( double sampleRate ) const;
+
     //----------------------------------------------------------------------
     /**
      Returns the upfacing wave component towards the root.
@@ -1602,6 +2437,17 @@ public:
      */
     virtual double calculateUpRes( double sampleRate );
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the upfacing port resistance at another sample rate without
+     adapting the node: Rup = RPar.
+
+     @param sampleRate          sample rate to calculate the resistance for
+     @returns                   a double type port resistance of that element
+                                in Ohms
+     */
+    virtual double getUpRes( double sampleRate ) const;
+
     //----------------------------------------------------------------------
     /**
      Returns the upfacing wave component towards the root.
@@ -1701,16 +2547,15 @@ public:
      value of the node, the port resistance Rp, past states and the ascending
      wave itself.
 
-     @param *ascendingWaves     Pointer to a vector of ascending waves
-     @param *descendingWaves    Pointer to a vector to store descending waves
-     @param *portIndex          Pointer to a counter with the port index to use
-                                in the vectors of ascending and descending
-                                waves. Needs to be incremented by numPorts in
-                                the node's implementation.
+     The ports of the node are a contiguous span of numPorts waves that
+     starts at the given pointers. Access is unchecked, the caller
+     (wdfRootSimple) passes the right position in its wave vectors.
+
+     @param ascendingWaves      numPorts incoming waves
+     @param descendingWaves     array to store numPorts outgoing waves
      */
-    virtual void calculateDownB( vec* ascendingWaves,
-                                 vec* descendingWaves,
-                                 size_t* portIndex ) = 0;
+    virtual void calculateDownB( const double* ascendingWaves,
+                                 double* descendingWaves ) = 0;
 
     //----------------------------------------------------------------------
     /**
@@ -1729,6 +2574,39 @@ public:
      */
     virtual std::string getType( ) const = 0;
 
+    //----------------------------------------------------------------------
+    /**
+     Function that does nothing if not overwritten by a method in a subclass.
+
+     Resets the dynamic state of this root node to that of a new one.
+     */
+    virtual void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of state values of this root node, 0 if not
+     overwritten by a method in a subclass.
+
+     @returns                   the number of doubles of the node state
+     */
+    virtual size_t getNumStates( );
+
+    //----------------------------------------------------------------------
+    /**
+     Stores the state of this root node.
+
+     @param state               array of getNumStates() values
+     */
+    virtual void getState( double* state );
+
+    //----------------------------------------------------------------------
+    /**
+     Restores the state of this root node.
+
+     @param state               array of getNumStates() values
+     */
+    virtual void setState( const double* state );
+
 };
 
 
@@ -1761,17 +2639,11 @@ public:
      This is either a complete reflection or it's inverse, depending on
      the switch position.
 
-     @param *ascendingWaves     Pointer to a vector of ascending waves
-     @param *descendingWaves    Pointer to a vector to store descending waves
-     @param *portIndex          Pointer to a counter with the port index to use
-
-                                in the vectors of ascending and descending
-                                waves. Needs to be incremented by numPorts in
-                                the node's implementation.
+     @param ascendingWaves      incoming wave of the port
+     @param descendingWaves     pointer to store the outgoing wave
      */
-    virtual void calculateDownB( vec* ascendingWaves,
-                                 vec* descendingWaves,
-                                 size_t* portIndex );
+    virtual void calculateDownB( const double* ascendingWaves,
+                                 double* descendingWaves );
 
     //----------------------------------------------------------------------
     /**
@@ -1782,6 +2654,14 @@ public:
      */
     void setSwitch( int position );
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the switch position (0/1)
+
+     @returns                   1 for a closed switch or 0 for an open one.
+     */
+    int getSwitch( ) const;
+
     //----------------------------------------------------------------------
     /**
      Returns a String describing the type of this root node.
@@ -1840,16 +2720,11 @@ public:
      This is composed of the recent ascending wave component and former
      components on this port.
 
-     @param *ascendingWaves     Pointer to a vector of ascending waves
-     @param *descendingWaves    Pointer to a vector to store descending waves
-     @param *portIndex          Pointer to a counter with the port index to use
-                                in the vectors of ascending and descending
-                                waves. Needs to be incremented by numPorts in
-                                the node's implementation.
-    */
-    virtual void calculateDownB( vec* ascendingWaves,
-                                 vec* descendingWaves,
-                                 size_t* portIndex );
+     @param ascendingWaves      incoming wave of the port
+     @param descendingWaves     pointer to store the outgoing wave
+     */
+    virtual void calculateDownB( const double* ascendingWaves,
+                                 double* descendingWaves );
 
     //----------------------------------------------------------------------
     /**
@@ -1874,6 +2749,28 @@ public:
      */
     virtual std::string getType( ) const;
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the reflection coefficient as calculated by setPortResistance().
+
+     @returns                   the reflection coefficient reflectionCoeff
+     */
+    double getReflectionCoeff( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Resets the delay elements.
+     */
+    virtual void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     State of the delay elements.
+     */
+    virtual size_t getNumStates( );
+    virtual void getState( double* state );
+    virtual void setState( const double* state );
+
     //----------------------------------------------------------------------
     /**
      Capacitance in Farad
@@ -1927,16 +2824,11 @@ public:
      This is composed of the recent ascending wave component and former
      components on this port.
 
-     @param *ascendingWaves     Pointer to a vector of ascending waves
-     @param *descendingWaves    Pointer to a vector to store descending waves
-     @param *portIndex          Pointer to a counter with the port index to use
-                                in the vectors of ascending and descending
-                                waves. Needs to be incremented by numPorts in
-                                the node's implementation.
-    */
-    virtual void calculateDownB( vec* ascendingWaves,
-                                 vec* descendingWaves,
-                                 size_t* portIndex );
+     @param ascendingWaves      incoming wave of the port
+     @param descendingWaves     pointer to store the outgoing wave
+     */
+    virtual void calculateDownB( const double* ascendingWaves,
+                                 double* descendingWaves );
 
     //----------------------------------------------------------------------
     /**
@@ -1960,6 +2852,28 @@ public:
      */
     virtual std::string getType( ) const;
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the reflection coefficient as calculated by setPortResistance().
+
+     @returns                   the reflection coefficient reflectionCoeff
+     */
+    double getReflectionCoeff( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Resets the delay elements.
+     */
+    virtual void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     State of the delay elements.
+     */
+    virtual size_t getNumStates( );
+    virtual void getState( double* state );
+    virtual void setState( const double* state );
+
     //----------------------------------------------------------------------
     /**
      Inductance in Henry
@@ -1996,16 +2910,11 @@ public:
     /**
      Calculates the reflection of the incoming, ascending wave.
 
-     @param *ascendingWaves     Pointer to a vector of ascending waves
-     @param *descendingWaves    Pointer to a vector to store descending waves
-     @param *portIndex          Pointer to a counter with the port index to use
-                                in the vectors of ascending and descending
-                                waves. Needs to be incremented by numPorts in
-                                the node's implementation.
-    */
-    virtual void calculateDownB( vec* ascendingWaves,
-                                 vec* descendingWaves,
-                                 size_t* portIndex );
+     @param ascendingWaves      incoming wave of the port
+     @param descendingWaves     pointer to store the outgoing wave
+     */
+    virtual void calculateDownB( const double* ascendingWaves,
+                                 double* descendingWaves );
 
     //----------------------------------------------------------------------
     /**
@@ -2029,6 +2938,14 @@ public:
      */
     virtual std::string getType( ) const;
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the reflection coefficient as calculated by setPortResistance().
+
+     @returns                   the reflection coefficient reflectionCoeff
+     */
+    double getReflectionCoeff( ) const;
+
     //----------------------------------------------------------------------
     /**
      Resistance in Ohms
@@ -2055,16 +2972,11 @@ public:
     /**
      Calculates the reflection of the incoming, ascending wave.
 
-     @param *ascendingWaves     Pointer to a vector of ascending waves
-     @param *descendingWaves    Pointer to a vector to store descending waves
-     @param *portIndex          Pointer to a counter with the port index to use
-                                in the vectors of ascending and descending
-                                waves. Needs to be incremented by numPorts in
-                                the node's implementation.
-    */
-    virtual void calculateDownB( vec* ascendingWaves,
-                                 vec* descendingWaves,
-                                 size_t* portIndex );
+     @param ascendingWaves      incoming wave of the port
+     @param descendingWaves     pointer to store the outgoing wave
+     */
+    virtual void calculateDownB( const double* ascendingWaves,
+                                 double* descendingWaves );
 
     //----------------------------------------------------------------------
     /**
@@ -2110,16 +3022,11 @@ public:
     /**
      Calculates the reflection of the incoming, ascending wave.
 
-     @param *ascendingWaves     Pointer to a vector of ascending waves
-     @param *descendingWaves    Pointer to a vector to store descending waves
-     @param *portIndex          Pointer to a counter with the port index to use
-                                in the vectors of ascending and descending
-                                waves. Needs to be incremented by numPorts in
-                                the node's implementation.
-    */
-    virtual void calculateDownB( vec* ascendingWaves,
-                                 vec* descendingWaves,
-                                 size_t* portIndex );
+     @param ascendingWaves      incoming wave of the port
+     @param descendingWaves     pointer to store the outgoing wave
+     */
+    virtual void calculateDownB( const double* ascendingWaves,
+                                 double* descendingWaves );
 
     //----------------------------------------------------------------------
     /**
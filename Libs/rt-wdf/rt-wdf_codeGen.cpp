@@ -0,0 +1,1104 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_codeGen.cpp
+ Created: 18 Oct 2026 4:05:00pm
+
+ ==============================================================================
+ */
+
+#include "rt-wdf_codeGen.h"
+
+#include <fstream>
+#include <stdio.h>
+#include <ctype.h>
+#include <cmath>
+
+
+//==============================================================================
+//                        C O D E   G E N E R A T O R
+//==============================================================================
+wdfCodeGenerator::wdfCodeGenerator( wdfTree* tree ) : tree( tree ),
+                                                      finite( true ) {
+
+}
+
+wdfCodeGenerator::~wdfCodeGenerator( ) {
+
+}
+
+//----------------------------------------------------------------------
+int wdfCodeGenerator::addInput( const std::string& name,
+                                wdfTreeNode* source ) {
+    if( !isValidName( name ) ) {
+        return -1;
+    }
+    if( !dynamic_cast<wdfTerminatedResVSource*>( source ) &&
+        !dynamic_cast<wdfTerminatedResCSource*>( source ) ) {
+        errorMessage = "Input '" + name + "' is not a resistive voltage or current source";
+        return -1;
+    }
+    codeGenPort input = { name, source, NULL };
+    inputs.push_back( input );
+    return 0;
+}
+
+//----------------------------------------------------------------------
+int wdfCodeGenerator::addInput( const std::string& name,
+                                wdfRootNode* source ) {
+    if( !isValidName( name ) ) {
+        return -1;
+    }
+    if( !dynamic_cast<wdfIdealVSource*>( source ) &&
+        !dynamic_cast<wdfIdealCSource*>( source ) ) {
+        errorMessage = "Input '" + name + "' is not an ideal voltage or current source";
+        return -1;
+    }
+    codeGenPort input = { name, NULL, source };
+    inputs.push_back( input );
+    return 0;
+}
+
+//----------------------------------------------------------------------
+int wdfCodeGenerator::addOutput( const std::string& name,
+                                 wdfTreeNode* node ) {
+    if( !isValidName( name ) ) {
+        return -1;
+    }
+    if( node == NULL ) {
+        errorMessage = "Output '" + name + "' has no node";
+        return -1;
+    }
+    codeGenPort output = { name, node, NULL };
+    outputs.push_back( output );
+    return 0;
+}
+
+//----------------------------------------------------------------------
+const std::string& wdfCodeGenerator::getErrorMessage( ) const {
+    return errorMessage;
+}
+
+//----------------------------------------------------------------------
+int wdfCodeGenerator::writeHeader( const std::string& structName,
+                                   const std::string& fileName ) {
+    std::string code;
+    if( generate( structName, &code ) != 0 ) {
+        return -1;
+    }
+
+    std::ofstream file( fileName.c_str() );
+    if( !file.is_open() ) {
+        errorMessage = "Could not open file '" + fileName + "'";
+        return -1;
+    }
+    file << code;
+    return file.good() ? 0 : -1;
+}
+
+//----------------------------------------------------------------------
+int wdfCodeGenerator::generate( const std::string& structName,
+                                std::string* code ) {
+    errorMessage.clear( );
+    nodeIds.clear( );
+    internalNames.clear( );
+    coeffCode.str( "" );
+    stateCode.str( "" );
+    resetCode.str( "" );
+    processCode.str( "" );
+    helperCode.str( "" );
+    publicCode.str( "" );
+    finite = true;
+
+    if( tree->getRoot() == NULL || tree->getSubtreeCount() == 0 ) {
+        errorMessage = "Tree has no root or no subtrees";
+        return -1;
+    }
+
+    for( const char* name : { "process", "processSample", "processBlock", "reset",
+                              "evalNl", "stepNl", "normNl", "getResidual", "in", "out", "i",
+                              "numSamples" } ) {
+        internalNames.insert( name );
+    }
+    internalNames.insert( structName );
+
+    for( size_t i = 0; i < tree->getSubtreeCount(); i++ ) {
+        numberNodes( tree->getSubtreeEntryNode( i ) );
+    }
+
+    processCode << "        // ascending waves\n";
+    for( size_t i = 0; i < tree->getSubtreeCount(); i++ ) {
+        if( emitUpWaves( tree->getSubtreeEntryNode( i ) ) != 0 ) {
+            return -1;
+        }
+    }
+
+    processCode << "\n        // " << tree->getRoot()->getType() << "\n";
+    if( emitRoot( ) != 0 ) {
+        return -1;
+    }
+
+    processCode << "\n        // descending waves\n";
+    for( size_t i = 0; i < tree->getSubtreeCount(); i++ ) {
+        emitDownWaves( tree->getSubtreeEntryNode( i ) );
+    }
+
+    if( !outputs.empty() ) {
+        processCode << "\n        // outputs\n";
+    }
+    for( const codeGenPort& output : outputs ) {
+        if( nodeIds.find( output.node ) == nodeIds.end() ) {
+            errorMessage = "Output '" + output.name + "' is not part of the tree";
+            return -1;
+        }
+        const size_t n = nodeIds[output.node];
+        processCode << "        " << output.name << " = ( a" << n << " + b" << n << " ) / 2.0;\n";
+    }
+
+    if( !finite ) {
+        errorMessage = "Tree has non-finite coefficients, adapt the tree first";
+        return -1;
+    }
+    for( const std::vector<codeGenPort>* ports : { &inputs, &outputs } ) {
+        for( const codeGenPort& port : *ports ) {
+            if( internalNames.count( port.name ) ) {
+                errorMessage = "Name '" + port.name + "' is used by the generated code";
+                return -1;
+            }
+        }
+    }
+
+    std::string guard = structName + "_H_INCLUDED";
+    for( char& c : guard ) {
+        c = toupper( c );
+    }
+
+    std::ostringstream out;
+    out << "/*\n"
+        << " ==============================================================================\n"
+        << "\n"
+        << " " << structName << "\n"
+        << " Generated by wdfCodeGenerator from the tree \"" << tree->getTreeIdentifier() << "\"\n"
+        << " at a sample rate of " << literal( tree->getSamplerate() ) << " Hz. Do not edit.\n"
+        << "\n"
+        << " ==============================================================================\n"
+        << " */\n"
+        << "\n"
+        << "#ifndef " << guard << "\n"
+        << "#define " << guard << "\n"
+        << "\n"
+        << "#include <cmath>\n"
+        << "#include <cstddef>\n"
+        << "\n"
+        << "\n"
+        << "struct " << structName << " {\n"
+        << "\n";
+
+    if( !inputs.empty() ) {
+        out << "    // inputs\n";
+        for( const codeGenPort& input : inputs ) {
+            const double value = input.node ?
+                ( dynamic_cast<wdfTerminatedResVSource*>( input.node ) ?
+                  static_cast<wdfTerminatedResVSource*>( input.node )->Vs :
+                  static_cast<wdfTerminatedResCSource*>( input.node )->Is ) :
+                ( dynamic_cast<wdfIdealVSource*>( input.rootNode ) ?
+                  static_cast<wdfIdealVSource*>( input.rootNode )->Vs :
+                  static_cast<wdfIdealCSource*>( input.rootNode )->Is );
+            out << "    double " << input.name << " = " << literal( value ) << ";\n";
+        }
+        out << "\n";
+    }
+    if( !outputs.empty() ) {
+        out << "    // outputs\n";
+        for( const codeGenPort& output : outputs ) {
+            out << "    double " << output.name << " = 0.0;\n";
+        }
+        out << "\n";
+    }
+
+    out << "    " << structName << "( ) {\n"
+        << "        reset( );\n"
+        << "    }\n"
+        << "\n"
+        << "    // restores the state the kernel was generated with\n"
+        << "    void reset( ) {\n"
+        << resetCode.str()
+        << "    }\n"
+        << "\n"
+        << "    // computes one sample, equivalent to wdfTree::cycleWave( )\n"
+        << "    inline void process( ) {\n"
+        << processCode.str()
+        << "    }\n";
+
+    if( inputs.size() == 1 && outputs.size() == 1 ) {
+        out << "\n"
+            << "    inline double processSample( double in ) {\n"
+            << "        " << inputs[0].name << " = in;\n"
+            << "        process( );\n"
+            << "        return " << outputs[0].name << ";\n"
+            << "    }\n"
+            << "\n"
+            << "    inline void processBlock( const double* in,\n"
+            << "                              double* out,\n"
+            << "                              size_t numSamples ) {\n"
+            << "        for( size_t i = 0; i < numSamples; i++ ) {\n"
+            << "            out[i] = processSample( in[i] );\n"
+            << "        }\n"
+            << "    }\n";
+    }
+    out << publicCode.str();
+
+    out << "\n"
+        << "private:\n"
+        << helperCode.str()
+        << "    // coefficients\n"
+        << coeffCode.str()
+        << "\n"
+        << "    // state\n"
+        << stateCode.str()
+        << "\n"
+        << "};\n"
+        << "\n"
+        << "#endif  // " << guard << "\n";
+
+    *code = out.str();
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void wdfCodeGenerator::numberNodes( wdfTreeNode* node ) {
+    const size_t n = nodeIds.size();
+    nodeIds[node] = n;
+    internalNames.insert( "a" + std::to_string( n ) );
+    internalNames.insert( "b" + std::to_string( n ) );
+    for( wdfTreeNode* child : node->getChildrenNodes() ) {
+        numberNodes( child );
+    }
+}
+
+//----------------------------------------------------------------------
+int wdfCodeGenerator::emitUpWaves( wdfTreeNode* node ) {
+    for( wdfTreeNode* child : node->getChildrenNodes() ) {
+        if( emitUpWaves( child ) != 0 ) {
+            return -1;
+        }
+    }
+
+    const std::string n = std::to_string( nodeIds[node] );
+    const std::vector<wdfTreeNode*>& children = node->getChildrenNodes();
+    std::vector<std::string> b;
+    for( wdfTreeNode* child : children ) {
+        b.push_back( "b" + std::to_string( nodeIds[child] ) );
+    }
+
+    processCode << "        // n" << n << ": " << node->getType() << "\n";
+    std::string expr;
+
+    if( dynamic_cast<wdfTerminatedSeries*>( node ) ) {
+        const double Ru = node->upPort->Rp;
+        const double Rl = children[0]->upPort->Rp;
+        const double Rr = children[1]->upPort->Rp;
+        const double yl = 2.0 * Rl / ( Ru + Rl + Rr );
+        addCoefficient( "y" + n + "l", yl );
+        addCoefficient( "y" + n + "r", 1.0 - yl );
+        expr = "-( " + b[0] + " + " + b[1] + " )";
+    }
+    else if( dynamic_cast<wdfTerminatedParallel*>( node ) ) {
+        const double Gu = 1.0 / node->upPort->Rp;
+        const double Gl = 1.0 / children[0]->upPort->Rp;
+        const double Gr = 1.0 / children[1]->upPort->Rp;
+        const double dl = 2.0 * Gl / ( Gu + Gl + Gr );
+        addCoefficient( "d" + n + "l", dl );
+        addCoefficient( "d" + n + "r", 1.0 - dl );
+        expr = "d" + n + "l * " + b[0] + " + d" + n + "r * " + b[1];
+    }
+    else if( dynamic_cast<wdfInverter*>( node ) ) {
+        expr = "-" + b[0];
+    }
+    else if( wdfTerminatedRtype* rtype = dynamic_cast<wdfTerminatedRtype*>( node ) ) {
+        const mat& S = *rtype->getScatteringMatrix( );
+        for( size_t i = 0; i <= children.size(); i++ ) {
+            for( size_t j = 0; j <= children.size(); j++ ) {
+                if( S.at( i, j ) != 0.0 ) {
+                    addCoefficient( "S" + n + "_" + std::to_string( i ) + "_" + std::to_string( j ), S.at( i, j ) );
+                }
+            }
+        }
+        std::vector<std::string> terms;
+        for( size_t j = 0; j < children.size(); j++ ) {
+            if( S.at( 0, j+1 ) != 0.0 ) {
+                terms.push_back( "S" + n + "_0_" + std::to_string( j+1 ) + " * " + b[j] );
+            }
+        }
+        expr = joinTerms( terms );
+    }
+    else if( wdfTerminatedCap* cap = dynamic_cast<wdfTerminatedCap*>( node ) ) {
+        stateCode << "    double s" << n << ";\n";
+        resetCode << "        s" << n << " = " << literal( cap->prevA ) << ";\n";
+        internalNames.insert( "s" + n );
+        expr = "s" + n;
+    }
+    else if( wdfTerminatedInd* ind = dynamic_cast<wdfTerminatedInd*>( node ) ) {
+        stateCode << "    double s" << n << ";\n";
+        resetCode << "        s" << n << " = " << literal( ind->prevA ) << ";\n";
+        internalNames.insert( "s" + n );
+        expr = "s" + n;
+    }
+    else if( dynamic_cast<wdfTerminatedRes*>( node ) ) {
+        expr = "0.0";
+    }
+    else if( wdfTerminatedResVSource* vs = dynamic_cast<wdfTerminatedResVSource*>( node ) ) {
+        expr = sourceValue( node, NULL, "Vs" + n, vs->Vs );
+    }
+    else if( wdfTerminatedResCSource* cs = dynamic_cast<wdfTerminatedResCSource*>( node ) ) {
+        addCoefficient( "R" + n, cs->RPar );
+        expr = "R" + n + " * " + sourceValue( node, NULL, "Is" + n, cs->Is );
+    }
+    else {
+        errorMessage = "Unsupported node type: " + node->getType();
+        return -1;
+    }
+
+    processCode << "        const double b" << n << " = " << expr << ";\n";
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void wdfCodeGenerator::emitDownWaves( wdfTreeNode* node ) {
+    const std::string n = std::to_string( nodeIds[node] );
+    const std::vector<wdfTreeNode*>& children = node->getChildrenNodes();
+    std::vector<std::string> a, b;
+    for( wdfTreeNode* child : children ) {
+        a.push_back( "a" + std::to_string( nodeIds[child] ) );
+        b.push_back( "b" + std::to_string( nodeIds[child] ) );
+    }
+
+    std::vector<std::string> expr( children.size() );
+
+    if( dynamic_cast<wdfTerminatedSeries*>( node ) ) {
+        expr[0] = "y" + n + "l * ( " + b[0] + " * ( ( 1.0 / y" + n + "l ) - 1 ) - " + b[1] + " - a" + n + " )";
+        expr[1] = "y" + n + "r * ( " + b[1] + " * ( ( 1.0 / y" + n + "r ) - 1 ) - " + b[0] + " - a" + n + " )";
+    }
+    else if( dynamic_cast<wdfTerminatedParallel*>( node ) ) {
+        expr[0] = "( d" + n + "l - 1 ) * " + b[0] + " + d" + n + "r * " + b[1] + " + a" + n;
+        expr[1] = "d" + n + "l * " + b[0] + " + ( d" + n + "r - 1 ) * " + b[1] + " + a" + n;
+    }
+    else if( dynamic_cast<wdfInverter*>( node ) ) {
+        expr[0] = "-a" + n;
+    }
+    else if( wdfTerminatedRtype* rtype = dynamic_cast<wdfTerminatedRtype*>( node ) ) {
+        const mat& S = *rtype->getScatteringMatrix( );
+        for( size_t i = 0; i < children.size(); i++ ) {
+            const std::string row = "S" + n + "_" + std::to_string( i+1 ) + "_";
+            std::vector<std::string> terms;
+            if( S.at( i+1, 0 ) != 0.0 ) {
+                terms.push_back( row + "0 * a" + n );
+            }
+            for( size_t j = 0; j < children.size(); j++ ) {
+                if( S.at( i+1, j+1 ) != 0.0 ) {
+                    terms.push_back( row + std::to_string( j+1 ) + " * " + b[j] );
+                }
+            }
+            expr[i] = joinTerms( terms );
+        }
+    }
+    else if( dynamic_cast<wdfTerminatedCap*>( node ) ) {
+        processCode << "        s" << n << " = a" << n << ";\n";
+    }
+    else if( dynamic_cast<wdfTerminatedInd*>( node ) ) {
+        processCode << "        s" << n << " = -a" << n << ";\n";
+    }
+
+    for( size_t i = 0; i < children.size(); i++ ) {
+        if( usesDownWave( children[i] ) ) {
+            processCode << "        const double " << a[i] << " = " << expr[i] << ";\n";
+        }
+    }
+    for( wdfTreeNode* child : children ) {
+        emitDownWaves( child );
+    }
+}
+
+//----------------------------------------------------------------------
+int wdfCodeGenerator::emitRoot( ) {
+    wdfRoot* root = tree->getRoot( );
+    const size_t numSubtrees = tree->getSubtreeCount( );
+    std::vector<std::string> a, b;
+    for( size_t i = 0; i < numSubtrees; i++ ) {
+        const size_t n = nodeIds[tree->getSubtreeEntryNode( i )];
+        a.push_back( "a" + std::to_string( n ) );
+        b.push_back( "b" + std::to_string( n ) );
+    }
+
+    if( wdfRootNL* nlRoot = dynamic_cast<wdfRootNL*>( root ) ) {
+        return emitNlRoot( nlRoot );
+    }
+
+    if( dynamic_cast<wdfRootRtype*>( root ) ) {
+        const mat& S = root->getRootMatrPtr()->Smat;
+        for( size_t i = 0; i < numSubtrees; i++ ) {
+            std::vector<std::string> terms;
+            for( size_t j = 0; j < numSubtrees; j++ ) {
+                if( S.at( i, j ) != 0.0 ) {
+                    const std::string name = "Sr_" + std::to_string( i ) + "_" + std::to_string( j );
+                    addCoefficient( name, S.at( i, j ) );
+                    terms.push_back( name + " * " + b[j] );
+                }
+            }
+            if( usesDownWave( tree->getSubtreeEntryNode( i ) ) ) {
+                processCode << "        const double " << a[i] << " = " << joinTerms( terms ) << ";\n";
+            }
+        }
+        return 0;
+    }
+
+    wdfRootSimple* simpleRoot = dynamic_cast<wdfRootSimple*>( root );
+    if( simpleRoot == NULL || numSubtrees != 1 ) {
+        errorMessage = "Unsupported root type: " + root->getType();
+        return -1;
+    }
+
+    wdfRootNode* element = simpleRoot->getRootElement( );
+    const bool used = usesDownWave( tree->getSubtreeEntryNode( 0 ) );
+    processCode << "        // " << element->getType() << "\n";
+
+    if( wdfUnterminatedSwitch* sw = dynamic_cast<wdfUnterminatedSwitch*>( element ) ) {
+        if( used ) {
+            processCode << "        const double " << a[0] << " = " << ( sw->getSwitch() == 0 ? "" : "-" ) << b[0] << ";\n";
+        }
+    }
+    else if( dynamic_cast<wdfUnterminatedCap*>( element ) || dynamic_cast<wdfUnterminatedInd*>( element ) ) {
+        const bool isCap = ( dynamic_cast<wdfUnterminatedCap*>( element ) != NULL );
+        addCoefficient( "rootRc", isCap ? static_cast<wdfUnterminatedCap*>( element )->getReflectionCoeff() :
+                                          static_cast<wdfUnterminatedInd*>( element )->getReflectionCoeff() );
+        stateCode << "    double rootPrevA;\n"
+                  << "    double rootPrevB;\n";
+        resetCode << "        rootPrevA = 0.0;\n"
+                  << "        rootPrevB = 0.0;\n";
+        internalNames.insert( "rootPrevA" );
+        internalNames.insert( "rootPrevB" );
+        if( isCap ) {
+            processCode << "        const double " << a[0] << " = rootRc * rootPrevB - rootRc * " << b[0] << " + rootPrevA;\n";
+        }
+        else {
+            processCode << "        const double " << a[0] << " = -rootRc * rootPrevB - rootRc * " << b[0] << " - rootPrevA;\n";
+        }
+        processCode << "        rootPrevB = " << a[0] << ";\n"
+                    << "        rootPrevA = " << b[0] << ";\n";
+    }
+    else if( wdfUnterminatedRes* res = dynamic_cast<wdfUnterminatedRes*>( element ) ) {
+        addCoefficient( "rootRc", res->getReflectionCoeff() );
+        if( used ) {
+            processCode << "        const double " << a[0] << " = rootRc * " << b[0] << ";\n";
+        }
+    }
+    else if( wdfIdealVSource* vs = dynamic_cast<wdfIdealVSource*>( element ) ) {
+        if( used ) {
+            processCode << "        const double " << a[0] << " = 2 * " << sourceValue( NULL, element, "rootVs", vs->Vs ) << " - " << b[0] << ";\n";
+        }
+    }
+    else if( wdfIdealCSource* cs = dynamic_cast<wdfIdealCSource*>( element ) ) {
+        addCoefficient( "rootRp", tree->getSubtreeEntryNode( 0 )->upPort->Rp );
+        if( used ) {
+            processCode << "        const double " << a[0] << " = 2 * rootRp * " << sourceValue( NULL, element, "rootIs", cs->Is ) << " + " << b[0] << ";\n";
+        }
+    }
+    else {
+        errorMessage = "Unsupported root element: " + element->getType();
+        return -1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+int wdfCodeGenerator::emitNlRoot( wdfRootNL* nlRoot ) {
+    const matData* rootMatrixData = nlRoot->getRootMatrPtr( );
+    nlNewtonSolver* solver = nlRoot->getNlSolver( );
+    const int fixedIterations = solver->getFixedIterations( );
+    const size_t numSubtrees = tree->getSubtreeCount( );
+    const size_t numNlPorts = solver->getNumPorts( );
+    const std::string K = std::to_string( numSubtrees );
+    const std::string N = std::to_string( numNlPorts );
+
+    // first port of the model that drives each port
+    std::vector<size_t> blockStart;
+    std::vector<size_t> blockSize;
+
+    std::ostringstream models;
+    size_t port = 0;
+    for( nlModel* model : solver->nlModels ) {
+        const std::string p0 = std::to_string( port );
+        const std::string p1 = std::to_string( port+1 );
+        models << "        {\n";
+        if( diodeModel* diode = dynamic_cast<diodeModel*>( model ) ) {
+            const diodeParams& params = diode->getParams( );
+            const double VT = params.numSeries * params.VT;
+            const std::string Is = literal( params.Is );
+            const std::string Is_o_VT = literal( params.Is / VT );
+            models << "            const double arg1 = nlX[" << p0 << "] * " << literal( 1.0 / VT ) << ";\n";
+            if( !dynamic_cast<diodeApModel*>( model ) ) {
+                models << "            const double exp_arg1 = std::exp( arg1 );\n"
+                       << "            nlf[" << p0 << "] = " << Is << " * ( exp_arg1 - 1 );\n"
+                       << "            nlJnl[" << p0 << "][" << p0 << "] = " << Is_o_VT << " * exp_arg1;\n";
+            }
+            else {
+                models << "            const double exp_arg1 = std::exp( arg1 );\n"
+                       << "            const double exp_m_arg1 = std::exp( -arg1 );\n"
+                       << "            nlf[" << p0 << "] = " << Is << " * ( exp_arg1 - exp_m_arg1 );\n"
+                       << "            nlJnl[" << p0 << "][" << p0 << "] = " << Is_o_VT << " * ( exp_arg1 + exp_m_arg1 );\n";
+            }
+        }
+        else if( npnEmModel* bjt = dynamic_cast<npnEmModel*>( model ) ) {
+            const bjtParams& params = bjt->getParams( );
+            const double alphaF = params.betaF / ( 1.0 + params.betaF );
+            const double alphaR = params.betaR / ( 1.0 + params.betaR );
+            const std::string Is = literal( params.Is );
+            const std::string mIs_o_VT = literal( -( params.Is / params.VT ) );
+            const std::string Is_o_ALPHAR = literal( params.Is / alphaR );
+            const std::string Is_o_ALPHAF = literal( params.Is / alphaF );
+            // a pnp transistor mirrors the port voltages and currents
+            const double polarity = bjt->getPolarity( );
+            const std::string oneOverVT = literal( polarity / params.VT );
+            const std::string fOpen = ( polarity < 0 ) ? "-( " : "";
+            const std::string fClose = ( polarity < 0 ) ? " )" : "";
+            models << "            const double exp_vBC_o_VT = std::exp( nlX[" << p0 << "] * " << oneOverVT << " );\n"
+                   << "            const double exp_vBE_o_VT = std::exp( nlX[" << p1 << "] * " << oneOverVT << " );\n"
+                   << "            nlf[" << p0 << "] = " << fOpen << "-" << Is << " * ( exp_vBE_o_VT - 1 ) + " << Is_o_ALPHAR << " * ( exp_vBC_o_VT - 1 )" << fClose << ";\n"
+                   << "            nlJnl[" << p0 << "][" << p0 << "] = " << literal( ( params.Is / alphaR ) / params.VT ) << " * exp_vBC_o_VT;\n"
+                   << "            nlJnl[" << p0 << "][" << p1 << "] = " << mIs_o_VT << " * exp_vBE_o_VT;\n"
+                   << "            nlf[" << p1 << "] = " << fOpen << Is_o_ALPHAF << " * ( exp_vBE_o_VT - 1 ) - " << Is << " * ( exp_vBC_o_VT - 1 )" << fClose << ";\n"
+                   << "            nlJnl[" << p1 << "][" << p0 << "] = " << mIs_o_VT << " * exp_vBC_o_VT;\n"
+                   << "            nlJnl[" << p1 << "][" << p1 << "] = " << literal( ( params.Is / alphaF ) / params.VT ) << " * exp_vBE_o_VT;\n";
+        }
+        else if( triDwModel* triode = dynamic_cast<triDwModel*>( model ) ) {
+            const triodeParams& params = triode->getParams( );
+            const std::string C = literal( params.C );
+            const std::string Cg = literal( params.Cg );
+            const std::string G_y = literal( params.G * params.gamma );
+            models << "            const double vAC_mu = nlX[" << p0 << "] * " << literal( 1.0 / params.mu ) << ";\n"
+                   << "            const double vGC = nlX[" << p1 << "];\n"
+                   << "            const double exp_Cg_vGC = std::exp( " << Cg << " * vGC );\n"
+                   << "            const double log_1_exp_Cg_vGC_Cg = std::log( 1 + exp_Cg_vGC ) * " << literal( 1.0 / params.Cg ) << ";\n"
+                   << "            const double pow_log_1_exp_Cg_vGC_Cg_E_1 = std::pow( log_1_exp_Cg_vGC_Cg, " << literal( params.xi - 1 ) << " );\n"
+                   << "            nlf[" << p1 << "] = " << literal( params.Gg ) << " * pow_log_1_exp_Cg_vGC_Cg_E_1 * log_1_exp_Cg_vGC_Cg + " << literal( params.Ig0 ) << ";\n"
+                   << "            nlJnl[" << p1 << "][" << p0 << "] = 0;\n"
+                   << "            nlJnl[" << p1 << "][" << p1 << "] = ( " << literal( params.Gg * params.xi ) << " * exp_Cg_vGC * pow_log_1_exp_Cg_vGC_Cg_E_1 ) / ( 1 + exp_Cg_vGC );\n"
+                   << "            const double exp_C_vAC_mu_vGC = std::exp( " << C << " * ( vAC_mu + vGC ) );\n"
+                   << "            const double log_1_exp_C_vAC_mu_vGC_C = std::log( 1 + exp_C_vAC_mu_vGC ) * " << literal( 1.0 / params.C ) << ";\n"
+                   << "            const double pow_log_1_exp_C_vAC_mu_vGC_C_y_1 = std::pow( log_1_exp_C_vAC_mu_vGC_C, " << literal( params.gamma - 1 ) << " );\n"
+                   << "            const double dIk_common = ( exp_C_vAC_mu_vGC * pow_log_1_exp_C_vAC_mu_vGC_C_y_1 ) / ( 1 + exp_C_vAC_mu_vGC );\n"
+                   << "            nlf[" << p0 << "] = " << literal( params.G ) << " * pow_log_1_exp_C_vAC_mu_vGC_C_y_1 * log_1_exp_C_vAC_mu_vGC_C - nlf[" << p1 << "];\n"
+                   << "            nlJnl[" << p0 << "][" << p0 << "] = " << literal( params.G * params.gamma / params.mu ) << " * dIk_common;\n"
+                   << "            nlJnl[" << p0 << "][" << p1 << "] = " << G_y << " * dIk_common - nlJnl[" << p1 << "][" << p1 << "];\n";
+        }
+        else if( pentodeKorenModel* pentode = dynamic_cast<pentodeKorenModel*>( model ) ) {
+            const pentodeParams& params = pentode->getParams( );
+            const std::string p2 = std::to_string( port+2 );
+            const std::string oneOverMu = literal( 1.0 / params.mu );
+            const std::string oneOverKvb = literal( 1.0 / params.kvb );
+            const std::string twoOverKg1 = literal( 2.0 / params.kg1 );
+            const std::string oneOverKg2 = literal( 1.0 / params.kg2 );
+            models << "            const double vAK = nlX[" << p0 << "];\n"
+                   << "            const double vGK = nlX[" << p1 << "];\n"
+                   << "            const double vSK = nlX[" << p2 << "];\n"
+                   << "            const double exp_Cg_vGK = std::exp( " << literal( params.Cg ) << " * vGK );\n"
+                   << "            const double log_1_exp_Cg_vGK_Cg = std::log( 1 + exp_Cg_vGK ) * " << literal( 1.0 / params.Cg ) << ";\n"
+                   << "            const double pow_log_1_exp_Cg_vGK_Cg_E_1 = std::pow( log_1_exp_Cg_vGK_Cg, " << literal( params.xi - 1 ) << " );\n"
+                   << "            nlf[" << p1 << "] = " << literal( params.Gg ) << " * pow_log_1_exp_Cg_vGK_Cg_E_1 * log_1_exp_Cg_vGK_Cg + " << literal( params.Ig0 ) << ";\n"
+                   << "            nlJnl[" << p1 << "][" << p0 << "] = 0;\n"
+                   << "            nlJnl[" << p1 << "][" << p1 << "] = ( " << literal( params.Gg * params.xi ) << " * exp_Cg_vGK * pow_log_1_exp_Cg_vGK_Cg_E_1 ) / ( 1 + exp_Cg_vGK );\n"
+                   << "            nlJnl[" << p1 << "][" << p2 << "] = 0;\n"
+                   << "            const double sqrt_kvb_vSK2 = std::sqrt( " << literal( params.kvb ) << " + vSK * vSK );\n"
+                   << "            const double exp_u = std::exp( " << literal( params.kp ) << " * ( " << oneOverMu << " + vGK / sqrt_kvb_vSK2 ) );\n"
+                   << "            const double log_1_exp_u = std::log( 1 + exp_u );\n"
+                   << "            const double sigma_u = exp_u / ( 1 + exp_u );\n"
+                   << "            const double E1 = vSK * " << literal( 1.0 / params.kp ) << " * log_1_exp_u;\n"
+                   << "            if( E1 > 0 ) {\n"
+                   << "                const double atan_vAK = std::atan( vAK * " << oneOverKvb << " );\n"
+                   << "                const double pow_E1_ex_1 = std::pow( E1, " << literal( params.ex - 1 ) << " );\n"
+                   << "                const double dIa_dE1 = " << literal( 2.0 / params.kg1 * params.ex ) << " * pow_E1_ex_1 * atan_vAK;\n"
+                   << "                nlf[" << p0 << "] = " << twoOverKg1 << " * pow_E1_ex_1 * E1 * atan_vAK;\n"
+                   << "                nlJnl[" << p0 << "][" << p0 << "] = " << twoOverKg1 << " * pow_E1_ex_1 * E1 * " << oneOverKvb << " / ( 1 + vAK * vAK * " << literal( 1.0 / ( params.kvb * params.kvb ) ) << " );\n"
+                   << "                nlJnl[" << p0 << "][" << p1 << "] = dIa_dE1 * vSK * sigma_u / sqrt_kvb_vSK2;\n"
+                   << "                nlJnl[" << p0 << "][" << p2 << "] = dIa_dE1 * ( " << literal( 1.0 / params.kp ) << " * log_1_exp_u - sigma_u * vGK * vSK * vSK / ( sqrt_kvb_vSK2 * sqrt_kvb_vSK2 * sqrt_kvb_vSK2 ) );\n"
+                   << "            }\n"
+                   << "            else {\n"
+                   << "                nlf[" << p0 << "] = 0;\n"
+                   << "                nlJnl[" << p0 << "][" << p0 << "] = 0;\n"
+                   << "                nlJnl[" << p0 << "][" << p1 << "] = 0;\n"
+                   << "                nlJnl[" << p0 << "][" << p2 << "] = 0;\n"
+                   << "            }\n"
+                   << "            const double vS_eff = vSK * " << oneOverMu << " + vGK;\n"
+                   << "            if( vS_eff > 0 ) {\n"
+                   << "                const double pow_vS_eff_ex_1 = std::pow( vS_eff, " << literal( params.ex - 1 ) << " );\n"
+                   << "                const double dIg2_common = " << literal( params.ex / params.kg2 ) << " * pow_vS_eff_ex_1;\n"
+                   << "                nlf[" << p2 << "] = pow_vS_eff_ex_1 * vS_eff * " << oneOverKg2 << ";\n"
+                   << "                nlJnl[" << p2 << "][" << p0 << "] = 0;\n"
+                   << "                nlJnl[" << p2 << "][" << p1 << "] = dIg2_common;\n"
+                   << "                nlJnl[" << p2 << "][" << p2 << "] = dIg2_common * " << oneOverMu << ";\n"
+                   << "            }\n"
+                   << "            else {\n"
+                   << "                nlf[" << p2 << "] = 0;\n"
+                   << "                nlJnl[" << p2 << "][" << p0 << "] = 0;\n"
+                   << "                nlJnl[" << p2 << "][" << p1 << "] = 0;\n"
+                   << "                nlJnl[" << p2 << "][" << p2 << "] = 0;\n"
+                   << "            }\n";
+        }
+        else if( fetShModel* fet = dynamic_cast<fetShModel*>( model ) ) {
+            // drain current of fetShModel::drainCurrent(), source and drain
+            // swap roles for vDS < 0
+            double VTO;
+            double k;
+            double lambda;
+            double IsGate = 0;
+            double VT = 1;
+            if( jfetShModel* jfet = dynamic_cast<jfetShModel*>( model ) ) {
+                const jfetParams& params = jfet->getParams( );
+                VTO = params.VTO;
+                k = params.beta;
+                lambda = params.lambda;
+                IsGate = params.Is;
+                VT = params.VT;
+            }
+            else if( mosfetShModel* mosfet = dynamic_cast<mosfetShModel*>( model ) ) {
+                const mosfetParams& params = mosfet->getParams( );
+                VTO = params.VTO;
+                k = 0.5 * params.beta;
+                lambda = params.lambda;
+            }
+            else {
+                errorMessage = "Unsupported non-linear model";
+                return -1;
+            }
+            const std::string polarity = literal( fet->getPolarity( ) );
+            const std::string kStr = literal( k );
+            const std::string lambdaStr = literal( lambda );
+            models << "            const double vDS = " << polarity << " * nlX[" << p0 << "];\n"
+                   << "            const double vGS = " << polarity << " * nlX[" << p1 << "];\n"
+                   << "            const double vGD = vGS - vDS;\n"
+                   << "            const bool forward = ( vDS >= 0 );\n"
+                   << "            const double vDSn = forward ? vDS : -vDS;\n"
+                   << "            const double vGST = ( forward ? vGS : vGD ) - " << literal( VTO ) << ";\n"
+                   << "            double id = 0;\n"
+                   << "            double gDS = 0;\n"
+                   << "            double gGS = 0;\n"
+                   << "            if( vGST > 0 ) {\n"
+                   << "                const double clm = 1 + " << lambdaStr << " * vDSn;\n"
+                   << "                if( vDSn < vGST ) {\n"
+                   << "                    const double vDS_2vGST_vDS = vDSn * ( 2 * vGST - vDSn );\n"
+                   << "                    id = " << kStr << " * vDS_2vGST_vDS * clm;\n"
+                   << "                    gDS = " << kStr << " * ( 2 * ( vGST - vDSn ) * clm + " << lambdaStr << " * vDS_2vGST_vDS );\n"
+                   << "                    gGS = " << literal( 2 * k ) << " * vDSn * clm;\n"
+                   << "                }\n"
+                   << "                else {\n"
+                   << "                    id = " << kStr << " * vGST * vGST * clm;\n"
+                   << "                    gDS = " << literal( k * lambda ) << " * vGST * vGST;\n"
+                   << "                    gGS = " << literal( 2 * k ) << " * vGST * clm;\n"
+                   << "                }\n"
+                   << "            }\n"
+                   << "            const double iD = forward ? id : -id;\n"
+                   << "            const double dID_dvDS = forward ? gDS : gDS + gGS;\n"
+                   << "            const double dID_dvGS = forward ? gGS : -gGS;\n";
+            if( IsGate != 0 ) {
+                const std::string Is = literal( IsGate );
+                const std::string Is_o_VT = literal( IsGate / VT );
+                models << "            const double exp_vGS_o_VT = std::exp( vGS * " << literal( 1.0 / VT ) << " );\n"
+                       << "            const double exp_vGD_o_VT = std::exp( vGD * " << literal( 1.0 / VT ) << " );\n"
+                       << "            const double iGS = " << Is << " * ( exp_vGS_o_VT - 1 );\n"
+                       << "            const double iGD = " << Is << " * ( exp_vGD_o_VT - 1 );\n"
+                       << "            nlf[" << p0 << "] = " << polarity << " * ( iD - iGD );\n"
+                       << "            nlJnl[" << p0 << "][" << p0 << "] = dID_dvDS + " << Is_o_VT << " * exp_vGD_o_VT;\n"
+                       << "            nlJnl[" << p0 << "][" << p1 << "] = dID_dvGS - " << Is_o_VT << " * exp_vGD_o_VT;\n"
+                       << "            nlf[" << p1 << "] = " << polarity << " * ( iGS + iGD );\n"
+                       << "            nlJnl[" << p1 << "][" << p0 << "] = " << literal( -IsGate / VT ) << " * exp_vGD_o_VT;\n"
+                       << "            nlJnl[" << p1 << "][" << p1 << "] = " << Is_o_VT << " * ( exp_vGS_o_VT + exp_vGD_o_VT );\n";
+            }
+            else {
+                // insulated gate
+                models << "            nlf[" << p0 << "] = " << polarity << " * iD;\n"
+                       << "            nlJnl[" << p0 << "][" << p0 << "] = dID_dvDS;\n"
+                       << "            nlJnl[" << p0 << "][" << p1 << "] = dID_dvGS;\n"
+                       << "            nlf[" << p1 << "] = 0;\n"
+                       << "            nlJnl[" << p1 << "][" << p0 << "] = 0;\n"
+                       << "            nlJnl[" << p1 << "][" << p1 << "] = 0;\n";
+            }
+        }
+        else if( opampSatModel* opamp = dynamic_cast<opampSatModel*>( model ) ) {
+            const opampParams& params = opamp->getParams( );
+            const double center = 0.5 * ( params.Vpos + params.Vneg );
+            const double swing = 0.5 * ( params.Vpos - params.Vneg );
+            const std::string oneOverRin = literal( 1.0 / params.Rin );
+            const std::string oneOverRout = literal( 1.0 / params.Rout );
+            models << "            const double tanh_vIn = std::tanh( " << literal( params.A / swing ) << " * nlX[" << p0 << "] );\n"
+                   << "            nlf[" << p0 << "] = nlX[" << p0 << "] * " << oneOverRin << ";\n"
+                   << "            nlJnl[" << p0 << "][" << p0 << "] = " << oneOverRin << ";\n"
+                   << "            nlJnl[" << p0 << "][" << p1 << "] = 0;\n"
+                   << "            nlf[" << p1 << "] = ( nlX[" << p1 << "] - " << literal( center ) << " - " << literal( swing ) << " * tanh_vIn ) * " << oneOverRout << ";\n"
+                   << "            nlJnl[" << p1 << "][" << p0 << "] = " << literal( -params.A / params.Rout ) << " * ( 1 - tanh_vIn * tanh_vIn );\n"
+                   << "            nlJnl[" << p1 << "][" << p1 << "] = " << oneOverRout << ";\n";
+        }
+        else {
+            errorMessage = "Unsupported non-linear model";
+            return -1;
+        }
+        models << "        }\n";
+
+        for( int i = 0; i < model->getNumPorts(); i++ ) {
+            blockStart.push_back( port );
+            blockSize.push_back( model->getNumPorts() );
+        }
+        port += model->getNumPorts( );
+    }
+
+    // root coefficients
+    const mat& E = rootMatrixData->Emat;
+    const mat& F = rootMatrixData->Fmat;
+    const mat& M = rootMatrixData->Mmat;
+    const mat& Nm = rootMatrixData->Nmat;
+    auto coeff = [this]( const std::string& name, const mat& A, size_t i, size_t j ) {
+        const std::string fullName = name + "_" + std::to_string( i ) + "_" + std::to_string( j );
+        if( A.at( i, j ) == 0.0 ) {
+            return std::string( );
+        }
+        return addCoefficient( fullName, A.at( i, j ) );
+    };
+
+    std::ostringstream eval;
+    eval << "    inline void evalNl( ) {\n"
+         << models.str();
+    for( size_t i = 0; i < numNlPorts; i++ ) {
+        std::vector<std::string> terms;
+        for( size_t k = 0; k < numNlPorts; k++ ) {
+            const std::string c = coeff( "F", F, i, k );
+            if( !c.empty() ) {
+                terms.push_back( c + " * nlf[" + std::to_string( k ) + "]" );
+            }
+        }
+        eval << "        nlFf[" << i << "] = " << joinTerms( terms ) << ";\n";
+    }
+    std::vector<std::string> Ea( numNlPorts );
+    for( size_t i = 0; i < numNlPorts; i++ ) {
+        std::vector<std::string> terms;
+        for( size_t k = 0; k < numSubtrees; k++ ) {
+            const std::string c = coeff( "E", E, i, k );
+            if( !c.empty() ) {
+                terms.push_back( c + " * nlIn[" + std::to_string( k ) + "]" );
+            }
+        }
+        Ea[i] = "( " + joinTerms( terms ) + " )";
+        eval << "        nlRes[" << i << "] = " << Ea[i] << " + nlFf[" << i << "] - nlX[" << i << "];\n";
+    }
+    for( size_t i = 0; i < numNlPorts; i++ ) {
+        for( size_t j = 0; j < numNlPorts; j++ ) {
+            std::vector<std::string> terms;
+            for( size_t k = blockStart[j]; k < blockStart[j] + blockSize[j]; k++ ) {
+                if( F.at( i, k ) != 0.0 ) {
+                    terms.push_back( "F_" + std::to_string( i ) + "_" + std::to_string( k ) +
+                                     " * nlJnl[" + std::to_string( k ) + "][" + std::to_string( j ) + "]" );
+                }
+            }
+            eval << "        nlJ[" << i << "][" << j << "] = ( " << joinTerms( terms ) << " )"
+                 << ( i == j ? " - 1.0" : "" ) << ";\n";
+        }
+    }
+    eval << "    }\n"
+         << "\n";
+
+    // Newton step J * p = -F by Gaussian elimination with partial pivoting,
+    // the pivot is selected without a branch like nlNewtonSolver::solveLinear()
+    std::ostringstream step;
+    step << "    inline void stepNl( ) {\n";
+    if( numNlPorts == 1 && fixedIterations > 0 ) {
+        // safeguarded step of nlNewtonSolver::limitStep()
+        step << "        const double bound = std::fabs( nlRes[0] );\n"
+             << "        const double step = -std::asinh( nlRes[0] ) * std::sqrt( 1.0 + nlRes[0] * nlRes[0] ) / nlJ[0][0];\n"
+             << "        nlX[0] += std::fmax( -bound, std::fmin( bound, step ) );\n";
+    }
+    else if( numNlPorts == 1 ) {
+        step << "        nlX[0] += -nlRes[0] / nlJ[0][0];\n";
+    }
+    else {
+        step << "        double A[" << N << "][" << numNlPorts+1 << "];\n"
+             << "        for( int i = 0; i < " << N << "; i++ ) {\n"
+             << "            for( int j = 0; j < " << N << "; j++ ) {\n"
+             << "                A[i][j] = nlJ[i][j];\n"
+             << "            }\n"
+             << "            A[i][" << N << "] = -nlRes[i];\n"
+             << "        }\n"
+             << "        for( int k = 0; k < " << N << "; k++ ) {\n"
+             << "            int pivot = k;\n"
+             << "            for( int i = k + 1; i < " << N << "; i++ ) {\n"
+             << "                pivot = ( std::fabs( A[i][k] ) > std::fabs( A[pivot][k] ) ) ? i : pivot;\n"
+             << "            }\n"
+             << "            for( int j = k; j <= " << N << "; j++ ) {\n"
+             << "                const double tmp = A[k][j];\n"
+             << "                A[k][j] = A[pivot][j];\n"
+             << "                A[pivot][j] = tmp;\n"
+             << "            }\n"
+             << "            for( int i = k + 1; i < " << N << "; i++ ) {\n"
+             << "                const double l = A[i][k] / A[k][k];\n"
+             << "                for( int j = k; j <= " << N << "; j++ ) {\n"
+             << "                    A[i][j] -= l * A[k][j];\n"
+             << "                }\n"
+             << "            }\n"
+             << "        }\n"
+             << "        for( int i = " << numNlPorts-1 << "; i >= 0; i-- ) {\n"
+             << "            double p = A[i][" << N << "];\n"
+             << "            for( int j = i + 1; j < " << N << "; j++ ) {\n"
+             << "                p -= A[i][j] * A[j][" << N << "];\n"
+             << "            }\n"
+             << "            A[i][" << N << "] = p / A[i][i];\n"
+             << "        }\n"
+             << "        for( int i = 0; i < " << N << "; i++ ) {\n"
+             << "            nlX[i] += A[i][" << N << "];\n"
+             << "        }\n";
+    }
+    step << "    }\n"
+         << "\n";
+
+    std::ostringstream norm;
+    norm << "    inline double normNl( ) const {\n"
+         << "        return std::sqrt( ";
+    for( size_t i = 0; i < numNlPorts; i++ ) {
+        norm << ( i ? " + " : "" ) << "nlRes[" << i << "] * nlRes[" << i << "]";
+    }
+    norm << " );\n"
+         << "    }\n"
+         << "\n";
+
+    helperCode << "    // non-linear models, F and J of the Newton solver\n"
+               << eval.str()
+               << "    // Newton step, J * p = -F\n"
+               << step.str()
+               << norm.str();
+
+    stateCode << "    double nlIn[" << K << "];\n"
+              << "    double nlX[" << N << "];\n"
+              << "    double nlf[" << N << "];\n"
+              << "    double nlJnl[" << N << "][" << N << "];\n"
+              << "    double nlFf[" << N << "];\n"
+              << "    double nlRes[" << N << "];\n"
+              << "    double nlJ[" << N << "][" << N << "];\n"
+              << "    bool nlFirstRun;\n"
+              << "    double nlResidual;\n";
+    if( fixedIterations == 0 ) {
+        stateCode << "    double nlXPrev[" << N << "];\n"
+                  << "    double nlXLast[" << N << "];\n";
+    }
+    resetCode << "        for( int i = 0; i < " << N << "; i++ ) {\n"
+              << "            nlX[i] = 0.0;\n"
+              << "            nlf[i] = 0.0;\n"
+              << "            nlFf[i] = 0.0;\n"
+              << "            for( int j = 0; j < " << N << "; j++ ) {\n"
+              << "                nlJnl[i][j] = 0.0;\n"
+              << "            }\n"
+              << "        }\n"
+              << "        nlFirstRun = true;\n"
+              << "        nlResidual = 0.0;\n";
+    for( const char* name : { "nlIn", "nlX", "nlf", "nlJnl", "nlFf", "nlRes", "nlJ", "nlFirstRun",
+                              "nlResidual", "nlXPrev", "nlXLast", "normF", "normFnew", "iter",
+                              "backtrack", "restarted" } ) {
+        internalNames.insert( name );
+    }
+
+    for( size_t k = 0; k < numSubtrees; k++ ) {
+        const size_t n = nodeIds[tree->getSubtreeEntryNode( k )];
+        processCode << "        nlIn[" << k << "] = b" << n << ";\n";
+    }
+    if( fixedIterations == 0 ) {
+        // solution of the last sample to restart a stagnating iteration
+        // like nlNewtonSolver::nlSolve()
+        processCode << "        bool restarted = nlFirstRun;\n"
+                    << "        for( int i = 0; i < " << N << "; i++ ) {\n"
+                    << "            nlXLast[i] = nlX[i];\n"
+                    << "        }\n";
+    }
+    processCode << "        if( nlFirstRun ) {\n"
+                << "            nlFirstRun = false;\n"
+                << "        }\n"
+                << "        else {\n";
+    if( fixedIterations > 0 ) {
+        // tangent predictor of nlNewtonSolver::solveFixed(): Newton step
+        // from the last solution with its Jacobian
+        for( size_t i = 0; i < numNlPorts; i++ ) {
+            processCode << "            nlRes[" << i << "] = nlFf[" << i << "] + " << Ea[i] << " - nlX[" << i << "];\n";
+        }
+        processCode << "            stepNl( );\n";
+    }
+    else {
+        for( size_t i = 0; i < numNlPorts; i++ ) {
+            processCode << "            nlX[" << i << "] = nlFf[" << i << "] + " << Ea[i] << ";\n";
+        }
+    }
+    processCode << "        }\n"
+                << "        evalNl( );\n";
+    if( fixedIterations > 0 ) {
+        processCode << "        for( int iter = 0; iter < " << fixedIterations << "; iter++ ) {\n"
+                    << "            stepNl( );\n"
+                    << "            evalNl( );\n"
+                    << "        }\n"
+                    << "        nlResidual = normNl( );\n";
+    }
+    else {
+        processCode << "        double normF = normNl( );\n"
+                    << "        int iter = 0;\n"
+                    << "        while( ( normF >= " << literal( TOL ) << " ) && ( iter < " << ITMAX << " ) ) {\n"
+                    << "            for( int i = 0; i < " << N << "; i++ ) {\n"
+                    << "                nlXPrev[i] = nlX[i];\n"
+                    << "            }\n"
+                    << "            stepNl( );\n"
+                    << "            evalNl( );\n"
+                    << "            double normFnew = normNl( );\n"
+                    << "            int backtrack = 0;\n"
+                    << "            while( !( normFnew < normF ) && ( backtrack < " << BACKTRACK_MAX << " ) ) {\n"
+                    << "                for( int i = 0; i < " << N << "; i++ ) {\n"
+                    << "                    nlX[i] = nlXPrev[i] + 0.5 * ( nlX[i] - nlXPrev[i] );\n"
+                    << "                }\n"
+                    << "                evalNl( );\n"
+                    << "                normFnew = normNl( );\n"
+                    << "                backtrack++;\n"
+                    << "            }\n"
+                    << "            if( !( normFnew < normF ) && !restarted ) {\n"
+                    << "                for( int i = 0; i < " << N << "; i++ ) {\n"
+                    << "                    nlX[i] = nlXLast[i];\n"
+                    << "                }\n"
+                    << "                evalNl( );\n"
+                    << "                normFnew = normNl( );\n"
+                    << "                restarted = true;\n"
+                    << "            }\n"
+                    << "            normF = normFnew;\n"
+                    << "            iter++;\n"
+                    << "        }\n"
+                    << "        nlResidual = normF;\n";
+    }
+
+    publicCode << "\n"
+               << "    // ||F||_2 the NL solver left in the last call to process( )\n"
+               << "    inline double getResidual( ) const {\n"
+               << "        return nlResidual;\n"
+               << "    }\n";
+
+    for( size_t i = 0; i < numSubtrees; i++ ) {
+        wdfTreeNode* entry = tree->getSubtreeEntryNode( i );
+        if( !usesDownWave( entry ) ) {
+            continue;
+        }
+        std::vector<std::string> Mterms, Nterms;
+        for( size_t k = 0; k < numSubtrees; k++ ) {
+            const std::string c = coeff( "M", M, i, k );
+            if( !c.empty() ) {
+                Mterms.push_back( c + " * nlIn[" + std::to_string( k ) + "]" );
+            }
+        }
+        for( size_t l = 0; l < numNlPorts; l++ ) {
+            const std::string c = coeff( "N", Nm, i, l );
+            if( !c.empty() ) {
+                Nterms.push_back( c + " * nlf[" + std::to_string( l ) + "]" );
+            }
+        }
+        processCode << "        const double a" << nodeIds[entry] << " = ( " << joinTerms( Mterms )
+                    << " ) + ( " << joinTerms( Nterms ) << " );\n";
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+std::string wdfCodeGenerator::addCoefficient( const std::string& name,
+                                              double value ) {
+    if( internalNames.insert( name ).second ) {
+        finite = finite && std::isfinite( value );
+        coeffCode << "    static constexpr double " << name << " = " << literal( value ) << ";\n";
+    }
+    return name;
+}
+
+//----------------------------------------------------------------------
+std::string wdfCodeGenerator::sourceValue( wdfTreeNode* node,
+                                           wdfRootNode* rootNode,
+                                           const std::string& constName,
+                                           double value ) {
+    for( const codeGenPort& input : inputs ) {
+        if( ( node && input.node == node ) || ( rootNode && input.rootNode == rootNode ) ) {
+            return input.name;
+        }
+    }
+    return addCoefficient( constName, value );
+}
+
+//----------------------------------------------------------------------
+bool wdfCodeGenerator::usesDownWave( wdfTreeNode* node ) {
+    for( const codeGenPort& output : outputs ) {
+        if( output.node == node ) {
+            return true;
+        }
+    }
+    for( wdfTreeNode* child : node->getChildrenNodes() ) {
+        if( usesDownWave( child ) ) {
+            return true;
+        }
+    }
+    return ( dynamic_cast<wdfTerminatedCap*>( node ) ||
+             dynamic_cast<wdfTerminatedInd*>( node ) );
+}
+
+//----------------------------------------------------------------------
+bool wdfCodeGenerator::isValidName( const std::string& name ) {
+    bool valid = !name.empty() && ( isalpha( name[0] ) || name[0] == '_' );
+    for( char c : name ) {
+        valid = valid && ( isalnum( c ) || c == '_' );
+    }
+    if( !valid ) {
+        errorMessage = "'" + name + "' is not a valid identifier";
+        return false;
+    }
+    for( const std::vector<codeGenPort>* ports : { &inputs, &outputs } ) {
+        for( const codeGenPort& port : *ports ) {
+            if( port.name == name ) {
+                errorMessage = "Name '" + name + "' is used twice";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+std::string wdfCodeGenerator::joinTerms( const std::vector<std::string>& terms ) {
+    if( terms.empty() ) {
+        return "0.0";
+    }
+    std::string sum = terms[0];
+    for( size_t i = 1; i < terms.size(); i++ ) {
+        sum += " + " + terms[i];
+    }
+    return sum;
+}
+
+//----------------------------------------------------------------------
+std::string wdfCodeGenerator::literal( double value ) {
+    char buffer[32];
+    snprintf( buffer, sizeof( buffer ), "%.17g", value );
+    std::string text( buffer );
+    if( text.find_first_of( ".eEn" ) == std::string::npos ) {
+        text += ".0";
+    }
+    return text;
+}
@@ -0,0 +1,288 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_codeGen.h
+ Created: 18 Oct 2026 4:05:00pm
+
+ ==============================================================================
+ */
+
+#ifndef RTWDF_CODEGEN_H_INCLUDED
+#define RTWDF_CODEGEN_H_INCLUDED
+
+//==============================================================================
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "rt-wdf.h"
+
+
+//==============================================================================
+class wdfCodeGenerator {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Generator for specialized C++ kernels of a wdfTree.
+
+     Once a tree is adapted, cycleWave() is a fixed sequence of multiply-adds
+     and the root solve. The generator walks the tree and emits a standalone
+     C++ header with a struct that holds the state of all reactive elements
+     and an inline process() function. All adapter and root coefficients are
+     static constexpr members, there are no virtual calls, no heap memory and
+     no dependency on RT-WDF or armadillo, so the compiler can inline and
+     vectorize across the whole circuit.
+
+     The kernel is a snapshot: coefficients are taken from the current
+     adaption of the tree, so the tree has to be initialized and adapted
+     (initTree(), setSamplerate(), adaptTree()) before generate() is called.
+     Parameter changes need a new kernel. Source values that are not
+     registered with addInput() are baked in as constants.
+
+     Non-linear roots are supported for the built-in models only, see
+     emitNlRoot().
+
+     The initial state of the kernel is the current state of the adapted
+     capacitors and inductors of the tree. All other state (unadapted root
+     elements, NL solver guess) starts at zero like in a new tree.
+
+     @param tree                is a pointer to the tree to generate code for
+     */
+    wdfCodeGenerator( wdfTree* tree );
+
+    //----------------------------------------------------------------------
+    /**
+     Deconstructor
+     */
+    virtual ~wdfCodeGenerator( );
+
+    //----------------------------------------------------------------------
+    /**
+     Registers a resistive voltage or current source as an input. The
+     kernel gets a public member with the given name that holds the source
+     value (Vs or Is).
+
+     @param name                name of the member, must be a C++ identifier
+     @param source              a wdfTerminatedResVSource or
+                                wdfTerminatedResCSource of the tree
+
+     @returns                   0 for success, -1 for error
+     */
+    int addInput( const std::string& name,
+                  wdfTreeNode* source );
+
+    //----------------------------------------------------------------------
+    /**
+     Registers an ideal voltage or current source at the root as an input.
+
+     @param name                name of the member, must be a C++ identifier
+     @param source              a wdfIdealVSource or wdfIdealCSource that is
+                                the root element of a wdfRootSimple
+
+     @returns                   0 for success, -1 for error
+     */
+    int addInput( const std::string& name,
+                  wdfRootNode* source );
+
+    //----------------------------------------------------------------------
+    /**
+     Registers the port voltage of a tree node as an output. The kernel gets
+     a public member with the given name that holds the voltage after every
+     call to process().
+
+     @param name                name of the member, must be a C++ identifier
+     @param node                any node of the tree
+
+     @returns                   0 for success, -1 for error
+     */
+    int addOutput( const std::string& name,
+                   wdfTreeNode* node );
+
+    //----------------------------------------------------------------------
+    /**
+     Generates the kernel source.
+
+     With exactly one input and one output, processSample() and
+     processBlock() are generated in addition to process().
+
+     @param structName          name of the generated struct
+     @param code                is a pointer to a string to store the code
+
+     @returns                   0 for success, -1 for error. See
+                                getErrorMessage() for details.
+     */
+    int generate( const std::string& structName,
+                  std::string* code );
+
+    //----------------------------------------------------------------------
+    /**
+     Generates the kernel and writes it to a header file.
+
+     @param structName          name of the generated struct
+     @param fileName            path of the header file
+
+     @returns                   0 for success, -1 for error. See
+                                getErrorMessage() for details.
+     */
+    int writeHeader( const std::string& structName,
+                     const std::string& fileName );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns a human readable description of the last error.
+
+     @returns                   the error message of the last failed call
+     */
+    const std::string& getErrorMessage( ) const;
+
+private:
+    //----------------------------------------------------------------------
+    /**
+     Numbers all nodes of a subtree in depth-first order.
+     */
+    void numberNodes( wdfTreeNode* node );
+
+    //----------------------------------------------------------------------
+    /**
+     Emits the ascending wave b<n> of a subtree (children first).
+
+     @returns                   0 for success, -1 for unsupported nodes
+     */
+    int emitUpWaves( wdfTreeNode* node );
+
+    //----------------------------------------------------------------------
+    /**
+     Emits the descending waves a<n> of all children of a node and the state
+     updates of a subtree (parents first).
+     */
+    void emitDownWaves( wdfTreeNode* node );
+
+    //----------------------------------------------------------------------
+    /**
+     Emits the root that maps all b<entry> to a<entry>.
+
+     @returns                   0 for success, -1 for unsupported roots
+     */
+    int emitRoot( );
+
+    //----------------------------------------------------------------------
+    /**
+     Emits the Newton solver and the model functions of a wdfRootNL. If
+     the solver runs a fixed number of iterations, the kernel does the
+     same with the tangent predictor and no convergence check.
+
+     All built-in models are supported: diodes, BJTs, the triode and
+     pentode, JFETs and MOSFETs of both polarities and the op-amp.
+     nlTableModel and user-defined subclasses of nlModel are not.
+
+     @returns                   0 for success, -1 for unsupported models
+     */
+    int emitNlRoot( wdfRootNL* nlRoot );
+
+    //----------------------------------------------------------------------
+    /**
+     Adds a static constexpr coefficient to the kernel.
+
+     @returns                   the name of the coefficient
+     */
+    std::string addCoefficient( const std::string& name,
+                                double value );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the expression for the value of a source, which is either the
+     name of the input member or a constant.
+     */
+    std::string sourceValue( wdfTreeNode* node,
+                             wdfRootNode* rootNode,
+                             const std::string& constName,
+                             double value );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns true if the descending wave of a node is used in the kernel.
+     */
+    bool usesDownWave( wdfTreeNode* node );
+
+    //----------------------------------------------------------------------
+    /**
+     Checks that a name is a valid C++ identifier which is not used by
+     another input or output.
+     */
+    bool isValidName( const std::string& name );
+
+    //----------------------------------------------------------------------
+    /**
+     Joins product terms to a sum expression ("0.0" for no terms).
+     */
+    static std::string joinTerms( const std::vector<std::string>& terms );
+
+    //----------------------------------------------------------------------
+    /**
+     Formats a double as a C++ literal that round-trips exactly.
+     */
+    static std::string literal( double value );
+
+    //----------------------------------------------------------------------
+    /**
+     An input or output of the kernel. Inputs are either a terminated source
+     (node) or an ideal source at the root (rootNode).
+     */
+    typedef struct codeGenPort {
+        std::string name;
+        wdfTreeNode* node;
+        wdfRootNode* rootNode;
+    } codeGenPort;
+
+    //----------------------------------------------------------------------
+    /** Tree to generate the kernel for */
+    wdfTree* tree;
+    /** Registered inputs */
+    std::vector<codeGenPort> inputs;
+    /** Registered outputs */
+    std::vector<codeGenPort> outputs;
+    /** Node numbers in depth-first order */
+    std::map<wdfTreeNode*, size_t> nodeIds;
+    /** All names that are declared by the generator itself */
+    std::set<std::string> internalNames;
+    /** Coefficient declarations */
+    std::ostringstream coeffCode;
+    /** State declarations */
+    std::ostringstream stateCode;
+    /** Body of reset() */
+    std::ostringstream resetCode;
+    /** Body of process() */
+    std::ostringstream processCode;
+    /** Additional private member functions */
+    std::ostringstream helperCode;
+    /** Additional public member functions */
+    std::ostringstream publicCode;
+    /** False if a non-finite coefficient was found */
+    bool finite;
+    /** Description of the last error */
+    std::string errorMessage;
+
+};
+
+#endif  // RTWDF_CODEGEN_H_INCLUDED
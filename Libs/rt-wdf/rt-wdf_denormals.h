@@ -0,0 +1,113 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_denormals.h
+ Created: 18 Oct 2026 9:40:00pm
+
+ ==============================================================================
+ */
+
+#ifndef RTWDF_DENORMALS_H_INCLUDED
+#define RTWDF_DENORMALS_H_INCLUDED
+
+//==============================================================================
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+    #include <xmmintrin.h>
+    #define RTWDF_DENORMALS_SSE 1
+#elif defined( __aarch64__ )
+    #include <cstdint>
+    #define RTWDF_DENORMALS_AARCH64 1
+#endif
+
+
+//==============================================================================
+/**
+ Enables or disables flush-to-zero mode of the calling thread until it is
+ changed again, see wdfDenormalScope. On other platforms this is a no-op.
+
+ @param enabled             true to flush subnormal numbers to zero
+ */
+inline void wdfSetFlushToZero( bool enabled ) {
+#if RTWDF_DENORMALS_SSE
+    const unsigned int mode = _mm_getcsr( );
+    _mm_setcsr( enabled ? ( mode | 0x8040 ) : ( mode & ~0x8040u ) );
+#elif RTWDF_DENORMALS_AARCH64
+    uint64_t mode;
+    __asm__ __volatile__( "mrs %0, fpcr" : "=r"( mode ) );
+    mode = enabled ? ( mode | ( 1 << 24 ) ) : ( mode & ~( uint64_t( 1 ) << 24 ) );
+    __asm__ __volatile__( "msr fpcr, %0" : : "r"( mode ) );
+#endif
+}
+
+
+//==============================================================================
+class wdfDenormalScope {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Scoped flush-to-zero mode of the calling thread.
+
+     Enables flush-to-zero and denormals-are-zero (FTZ/DAZ on SSE, FZ on
+     AArch64) for the lifetime of the object and restores the previous
+     floating point mode afterwards. Decaying waves in reactive elements
+     then become exactly zero instead of subnormal numbers, which are
+     many times slower to compute with on most CPUs. On other platforms
+     this is a no-op.
+     */
+    wdfDenormalScope( ) {
+#if RTWDF_DENORMALS_SSE
+        previousMode = _mm_getcsr( );
+        _mm_setcsr( previousMode | 0x8040 );
+#elif RTWDF_DENORMALS_AARCH64
+        uint64_t mode;
+        __asm__ __volatile__( "mrs %0, fpcr" : "=r"( mode ) );
+        previousMode = mode;
+        mode |= ( 1 << 24 );
+        __asm__ __volatile__( "msr fpcr, %0" : : "r"( mode ) );
+#endif
+    }
+
+    //----------------------------------------------------------------------
+    /**
+     Deconstructor, restores the previous floating point mode.
+     */
+    ~wdfDenormalScope( ) {
+#if RTWDF_DENORMALS_SSE
+        _mm_setcsr( previousMode );
+#elif RTWDF_DENORMALS_AARCH64
+        uint64_t mode = previousMode;
+        __asm__ __volatile__( "msr fpcr, %0" : : "r"( mode ) );
+#endif
+    }
+
+private:
+    //----------------------------------------------------------------------
+    /** Floating point control register before the scope was entered */
+#if RTWDF_DENORMALS_SSE
+    unsigned int previousMode;
+#elif RTWDF_DENORMALS_AARCH64
+    uint64_t previousMode;
+#endif
+
+};
+
+#endif  // RTWDF_DENORMALS_H_INCLUDED
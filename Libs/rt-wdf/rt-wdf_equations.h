@@ -0,0 +1,325 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_equations.h
+ Created: 18 Oct 2026 5:20:00pm
+
+ ==============================================================================
+ */
+
+#ifndef RTWDF_EQUATIONS_H_INCLUDED
+#define RTWDF_EQUATIONS_H_INCLUDED
+
+//==============================================================================
+// Wave equations of the adapters and elements.
+//
+// These are shared by the runtime tree nodes (rt-wdf.h) and the static
+// template nodes (rt-wdf_static.h), so both evaluate exactly the same
+// arithmetic.
+//==============================================================================
+
+
+#pragma mark - Series Adapter
+//----------------------------------------------------------------------
+/**
+ Upfacing port resistance of a series adapter.
+
+ @param Rl                  port resistance of the left child
+ @param Rr                  port resistance of the right child
+ @returns                   the upfacing port resistance
+ */
+inline double wdfSeriesUpRes( double Rl,
+                              double Rr ) {
+    return ( Rl + Rr );
+}
+
+//----------------------------------------------------------------------
+/**
+ Scattering coefficient yl of a series adapter. yr = 1 - yl, yu = 1.
+
+ @param Ru                  upfacing port resistance
+ @param Rl                  port resistance of the left child
+ @param Rr                  port resistance of the right child
+ @returns                   the scattering coefficient of the left port
+ */
+inline double wdfSeriesCoeff( double Ru,
+                              double Rl,
+                              double Rr ) {
+    return 2.0 * Rl / ( Ru + Rl + Rr );
+}
+
+//----------------------------------------------------------------------
+/**
+ Ascending wave of a series adapter.
+
+ @param al                  wave coming up from the left child
+ @param ar                  wave coming up from the right child
+ @returns                   the upfacing outgoing wave
+ */
+inline double wdfSeriesUpB( double al,
+                            double ar ) {
+    return -( al + ar );
+}
+
+//----------------------------------------------------------------------
+/**
+ Descending waves of a series adapter.
+
+ @param yl                  scattering coefficient of the left port
+ @param yr                  scattering coefficient of the right port
+ @param al                  wave coming up from the left child
+ @param ar                  wave coming up from the right child
+ @param descendingWave      wave coming down from the parent
+ @param *bl                 is a pointer to store the wave to the left child
+ @param *br                 is a pointer to store the wave to the right child
+ */
+inline void wdfSeriesDownB( double yl,
+                            double yr,
+                            double al,
+                            double ar,
+                            double descendingWave,
+                            double* bl,
+                            double* br ) {
+    *bl = yl * ( al * ((1.0 / yl) - 1) - ar - descendingWave );
+    *br = yr * ( ar * ((1.0 / yr) - 1) - al - descendingWave );
+}
+
+
+#pragma mark - Parallel Adapter
+//----------------------------------------------------------------------
+/**
+ Upfacing port resistance of a parallel adapter.
+
+ @param Rl                  port resistance of the left child
+ @param Rr                  port resistance of the right child
+ @returns                   the upfacing port resistance
+ */
+inline double wdfParallelUpRes( double Rl,
+                                double Rr ) {
+    return ( Rl * Rr ) / ( Rl + Rr );
+}
+
+//----------------------------------------------------------------------
+/**
+ Scattering coefficient dl of a parallel adapter. dr = 1 - dl, du = 1.
+
+ @param Gu                  upfacing port conductance
+ @param Gl                  port conductance of the left child
+ @param Gr                  port conductance of the right child
+ @returns                   the scattering coefficient of the left port
+ */
+inline double wdfParallelCoeff( double Gu,
+                                double Gl,
+                                double Gr ) {
+    return 2.0 * Gl / ( Gu + Gl + Gr );
+}
+
+//----------------------------------------------------------------------
+/**
+ Ascending wave of a parallel adapter.
+
+ @param dl                  scattering coefficient of the left port
+ @param dr                  scattering coefficient of the right port
+ @param al                  wave coming up from the left child
+ @param ar                  wave coming up from the right child
+ @returns                   the upfacing outgoing wave
+ */
+inline double wdfParallelUpB( double dl,
+                              double dr,
+                              double al,
+                              double ar ) {
+    return ( dl * al + dr * ar );
+}
+
+//----------------------------------------------------------------------
+/**
+ Descending waves of a parallel adapter.
+
+ @param du                  scattering coefficient of the upfacing port
+ @param dl                  scattering coefficient of the left port
+ @param dr                  scattering coefficient of the right port
+ @param al                  wave coming up from the left child
+ @param ar                  wave coming up from the right child
+ @param descendingWave      wave coming down from the parent
+ @param *bl                 is a pointer to store the wave to the left child
+ @param *br                 is a pointer to store the wave to the right child
+ */
+inline void wdfParallelDownB( double du,
+                              double dl,
+                              double dr,
+                              double al,
+                              double ar,
+                              double descendingWave,
+                              double* bl,
+                              double* br ) {
+    *bl = ( ( dl - 1 ) * al + dr * ar + du * descendingWave );
+    *br = ( dl * al + ( dr - 1 ) * ar + du * descendingWave );
+}
+
+
+#pragma mark - Inverter
+//----------------------------------------------------------------------
+/**
+ Ascending or descending wave of an inverter.
+
+ @param wave                incoming wave
+ @returns                   the inverted outgoing wave
+ */
+inline double wdfInverterB( double wave ) {
+    return -1 * wave;
+}
+
+
+#pragma mark - Leafs
+//----------------------------------------------------------------------
+/**
+ Port resistance of an adapted (trapezoidal) capacitor.
+
+ @param sampleRate          the sample rate the capacitor is adapted to
+ @param C                   capacitance
+ @returns                   the port resistance
+ */
+inline double wdfCapRes( double sampleRate,
+                         double C ) {
+    return 1 / ( 2.0 * sampleRate * C );
+}
+
+//----------------------------------------------------------------------
+/**
+ Port resistance of an adapted (trapezoidal) inductor.
+
+ @param sampleRate          the sample rate the inductor is adapted to
+ @param L                   inductance
+ @returns                   the port resistance
+ */
+inline double wdfIndRes( double sampleRate,
+                         double L ) {
+    return 2.0 * sampleRate * L;
+}
+
+
+#pragma mark - Unterminated Root Elements
+//----------------------------------------------------------------------
+/**
+ Reflection coefficient of an unadapted capacitor.
+
+ @param Rp                  port resistance of the connected subtree
+ @param sampleRate          the sample rate
+ @param C                   capacitance
+ @returns                   the reflection coefficient
+ */
+inline double wdfUnterminatedCapCoeff( double Rp,
+                                       double sampleRate,
+                                       double C ) {
+    return (Rp - 1 / (2 * sampleRate * C)) / (Rp + (1 / (2 * sampleRate * C)));
+}
+
+//----------------------------------------------------------------------
+/**
+ Reflected wave of an unadapted capacitor.
+
+ @param reflectionCoeff     reflection coefficient
+ @param ascendingWave       wave coming up from the subtree
+ @param prevA               ascending wave of the last sample
+ @param prevB               reflected wave of the last sample
+ @returns                   the reflected wave
+ */
+inline double wdfUnterminatedCapB( double reflectionCoeff,
+                                   double ascendingWave,
+                                   double prevA,
+                                   double prevB ) {
+    return reflectionCoeff * prevB - reflectionCoeff * ascendingWave + prevA;
+}
+
+//----------------------------------------------------------------------
+/**
+ Reflection coefficient of an unadapted inductor.
+
+ @param Rp                  port resistance of the connected subtree
+ @param sampleRate          the sample rate
+ @param L                   inductance
+ @returns                   the reflection coefficient
+ */
+inline double wdfUnterminatedIndCoeff( double Rp,
+                                       double sampleRate,
+                                       double L ) {
+    return (Rp - 2 * sampleRate * L) / (Rp + 2 * sampleRate * L);
+}
+
+//----------------------------------------------------------------------
+/**
+ Reflected wave of an unadapted inductor.
+
+ @param reflectionCoeff     reflection coefficient
+ @param ascendingWave       wave coming up from the subtree
+ @param prevA               ascending wave of the last sample
+ @param prevB               reflected wave of the last sample
+ @returns                   the reflected wave
+ */
+inline double wdfUnterminatedIndB( double reflectionCoeff,
+                                   double ascendingWave,
+                                   double prevA,
+                                   double prevB ) {
+    return -reflectionCoeff * prevB - reflectionCoeff * ascendingWave - prevA;
+}
+
+//----------------------------------------------------------------------
+/**
+ Reflection coefficient of an unadapted resistor.
+
+ @param Rp                  port resistance of the connected subtree
+ @param R                   resistance
+ @returns                   the reflection coefficient
+ */
+inline double wdfUnterminatedResCoeff( double Rp,
+                                       double R ) {
+    return (R - Rp) / (R + Rp);
+}
+
+//----------------------------------------------------------------------
+/**
+ Reflected wave of an ideal voltage source.
+
+ @param Vs                  source voltage
+ @param ascendingWave       wave coming up from the subtree
+ @returns                   the reflected wave
+ */
+inline double wdfIdealVSourceB( double Vs,
+                                double ascendingWave ) {
+    return 2 * Vs - ascendingWave;
+}
+
+//----------------------------------------------------------------------
+/**
+ Reflected wave of an ideal current source.
+
+ @param Rp                  port resistance of the connected subtree
+ @param Is                  source current
+ @param ascendingWave       wave coming up from the subtree
+ @returns                   the reflected wave
+ */
+inline double wdfIdealCSourceB( double Rp,
+                                double Is,
+                                double ascendingWave ) {
+    return 2 * Rp * Is + ascendingWave;
+}
+
+#endif  // RTWDF_EQUATIONS_H_INCLUDED
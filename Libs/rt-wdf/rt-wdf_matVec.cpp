@@ -0,0 +1,244 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_matVec.cpp
+ Created: 18 Oct 2026 6:30:00pm
+
+ ==============================================================================
+ */
+
+#include "rt-wdf_matVec.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+//==============================================================================
+//                          M A T - V E C   K E R N E L
+//==============================================================================
+wdfMatVec::wdfMatVec( ) : numRows( 0 ),
+                          numCols( 0 ),
+                          type( denseMatVec ),
+                          rank( 0 ),
+                          shift( 0 ) {
+
+}
+
+//----------------------------------------------------------------------
+void wdfMatVec::setMatrix( const mat& A ) {
+    numRows = A.n_rows;
+    numCols = A.n_cols;
+
+    values.clear( );
+    colIndex.clear( );
+    rowStart.clear( );
+    vt.clear( );
+    rank = 0;
+    shift = 0.0;
+
+    // multiply-adds per product of each representation
+    const double denseCost = (double)( numRows * numCols );
+    double sparseCost = 0.0;
+    for( size_t i = 0; i < A.n_elem; i++ ) {
+        sparseCost += ( A.at( i ) != 0.0 );
+    }
+    double bestCost = std::min( sparseCost, MATVEC_DENSE_RATIO * denseCost );
+    type = ( sparseCost <= bestCost ) ? sparseMatVec : denseMatVec;
+
+    // the largest rank that would still be cheaper than the best so far
+    const double costPerRank = (double)( numRows + numCols );
+    if( bestCost > numRows && costPerRank > 0 ) {
+        const size_t maxRank = (size_t)( ( bestCost - numRows ) / costPerRank );
+        const double shifts[] = { 0.0, -1.0, 1.0 };
+        for( double candidate : shifts ) {
+            if( ( candidate == 0.0 || numRows == numCols ) &&
+                decompose( A, candidate, maxRank ) ) {
+                const double lowRankCost = numRows + rank * costPerRank;
+                if( lowRankCost < bestCost ) {
+                    bestCost = lowRankCost;
+                    type = lowRankMatVec;
+                    break;
+                }
+            }
+        }
+    }
+
+    if( type == lowRankMatVec ) {
+        temp.assign( rank, 0.0 );
+    }
+    else if( type == sparseMatVec ) {
+        vt.clear( );
+        values.clear( );
+        rowStart.push_back( 0 );
+        for( size_t i = 0; i < numRows; i++ ) {
+            for( size_t j = 0; j < numCols; j++ ) {
+                if( A.at( i, j ) != 0.0 ) {
+                    values.push_back( A.at( i, j ) );
+                    colIndex.push_back( j );
+                }
+            }
+            rowStart.push_back( values.size() );
+        }
+        rank = 0;
+    }
+    else {
+        vt.clear( );
+        values.resize( numRows * numCols );
+        for( size_t i = 0; i < numRows; i++ ) {
+            for( size_t j = 0; j < numCols; j++ ) {
+                values[i * numCols + j] = A.at( i, j );
+            }
+        }
+        rank = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+bool wdfMatVec::decompose( const mat& A,
+                           double shift,
+                           size_t maxRank ) {
+    mat R = A;
+    double maxAbs = 0.0;
+    for( size_t i = 0; i < std::min( numRows, numCols ); i++ ) {
+        R.at( i, i ) -= shift;
+    }
+    for( size_t i = 0; i < R.n_elem; i++ ) {
+        maxAbs = std::max( maxAbs, std::fabs( R.at( i ) ) );
+    }
+    const double tol = MATVEC_RANK_TOL * maxAbs;
+
+    std::vector<double> U;
+    std::vector<double> Vt;
+    size_t r = 0;
+    while( true ) {
+        size_t pi = 0;
+        size_t pj = 0;
+        double pivot = 0.0;
+        for( size_t j = 0; j < numCols; j++ ) {
+            for( size_t i = 0; i < numRows; i++ ) {
+                if( std::fabs( R.at( i, j ) ) > std::fabs( pivot ) ) {
+                    pivot = R.at( i, j );
+                    pi = i;
+                    pj = j;
+                }
+            }
+        }
+        if( std::fabs( pivot ) <= tol ) {
+            break;
+        }
+        if( r == maxRank ) {
+            return false;
+        }
+
+        // R = R - u * v^T with u = R(:,pj) / pivot and v = R(pi,:)
+        std::vector<double> u( numRows );
+        std::vector<double> v( numCols );
+        for( size_t i = 0; i < numRows; i++ ) {
+            u[i] = R.at( i, pj ) / pivot;
+        }
+        for( size_t j = 0; j < numCols; j++ ) {
+            v[j] = R.at( pi, j );
+        }
+        for( size_t j = 0; j < numCols; j++ ) {
+            for( size_t i = 0; i < numRows; i++ ) {
+                R.at( i, j ) -= u[i] * v[j];
+            }
+        }
+        U.insert( U.end(), u.begin(), u.end() );
+        Vt.insert( Vt.end(), v.begin(), v.end() );
+        r++;
+    }
+
+    // U is stored row-major for the product, it was collected column by column
+    values.assign( numRows * r, 0.0 );
+    for( size_t k = 0; k < r; k++ ) {
+        for( size_t i = 0; i < numRows; i++ ) {
+            values[i * r + k] = U[k * numRows + i];
+        }
+    }
+    vt = Vt;
+    rank = r;
+    this->shift = shift;
+    return true;
+}
+
+//----------------------------------------------------------------------
+void wdfMatVec::multiply( const double* x,
+                          double* y ) const {
+    for( size_t i = 0; i < numRows; i++ ) {
+        y[i] = 0.0;
+    }
+    multiplyAdd( x, y );
+}
+
+//----------------------------------------------------------------------
+void wdfMatVec::multiplyAdd( const double* x,
+                             double* y ) const {
+    const double* v = values.data( );
+    if( type == sparseMatVec ) {
+        for( size_t i = 0; i < numRows; i++ ) {
+            double sum = 0.0;
+            for( size_t k = rowStart[i]; k < rowStart[i+1]; k++ ) {
+                sum += v[k] * x[colIndex[k]];
+            }
+            y[i] += sum;
+        }
+    }
+    else if( type == lowRankMatVec ) {
+        double* t = temp.data( );
+        for( size_t k = 0; k < rank; k++ ) {
+            const double* row = vt.data() + k * numCols;
+            double sum = 0.0;
+            for( size_t j = 0; j < numCols; j++ ) {
+                sum += row[j] * x[j];
+            }
+            t[k] = sum;
+        }
+        for( size_t i = 0; i < numRows; i++ ) {
+            const double* row = v + i * rank;
+            double sum = shift * x[i];
+            for( size_t k = 0; k < rank; k++ ) {
+                sum += row[k] * t[k];
+            }
+            y[i] += sum;
+        }
+    }
+    else {
+        for( size_t i = 0; i < numRows; i++ ) {
+            const double* row = v + i * numCols;
+            double sum = 0.0;
+            for( size_t j = 0; j < numCols; j++ ) {
+                sum += row[j] * x[j];
+            }
+            y[i] += sum;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+matVecType wdfMatVec::getType( ) const {
+    return type;
+}
+
+//----------------------------------------------------------------------
+size_t wdfMatVec::getRank( ) const {
+    return rank;
+}
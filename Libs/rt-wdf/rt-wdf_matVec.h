@@ -0,0 +1,167 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_matVec.h
+ Created: 18 Oct 2026 6:30:00pm
+
+ ==============================================================================
+ */
+
+#ifndef RTWDF_MATVEC_H_INCLUDED
+#define RTWDF_MATVEC_H_INCLUDED
+
+//==============================================================================
+#include <vector>
+
+#include "rt-wdf_types.h"
+
+
+//==============================================================================
+// Mat-vec kernel config parameters
+
+/** Sparse or low-rank storage is only used if it needs less than this
+    fraction of the multiply-adds of the dense product */
+#define MATVEC_DENSE_RATIO  0.5
+/** Relative tolerance below which residual entries count as zero in the
+    low-rank decomposition */
+#define MATVEC_RANK_TOL     1.0e-12
+
+
+//==============================================================================
+/** Storage types of wdfMatVec */
+typedef enum matVecType {
+    denseMatVec,
+    sparseMatVec,
+    lowRankMatVec
+} matVecType;
+
+
+//==============================================================================
+class wdfMatVec {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Allocation-free matrix-vector product for root matrices.
+
+     setMatrix() analyzes a matrix once and picks the cheapest of three
+     representations:
+
+     - sparse: compressed rows, for matrices with many structural zeros
+       (typical for roots where many ports only see a few others).
+     - low-rank: A = d*I + U*V^T with d = 0, -1 or 1 and a rank r much
+       smaller than the size. R-type scattering matrices are an identity
+       plus a correction whose rank is limited by the number of circuit
+       nodes inside the root, so large roots often have r << n.
+     - dense: a row-major copy of the matrix.
+
+     The cost per product scales with the nonzeros or with n*r instead of
+     n^2. multiply() works on contiguous raw arrays without temporaries, so
+     it is safe to call from the audio thread.
+     */
+    wdfMatVec( );
+
+    //----------------------------------------------------------------------
+    /**
+     Analyzes and stores a matrix. Allocates memory, don't call this from
+     the audio thread.
+
+     @param A                   the matrix to multiply with
+     */
+    void setMatrix( const mat& A );
+
+    //----------------------------------------------------------------------
+    /**
+     Calculates y = A * x.
+
+     @param *x                  is a pointer to numCols input values
+     @param *y                  is a pointer to store numRows output values,
+                                must not overlap with x
+     */
+    void multiply( const double* x,
+                   double* y ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Calculates y = y + A * x.
+
+     @param *x                  is a pointer to numCols input values
+     @param *y                  is a pointer to numRows values to add to,
+                                must not overlap with x
+     */
+    void multiplyAdd( const double* x,
+                      double* y ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the representation that was chosen by setMatrix().
+
+     @returns                   denseMatVec, sparseMatVec or lowRankMatVec
+     */
+    matVecType getType( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the rank of U*V^T of the low-rank representation.
+
+     @returns                   the rank r, 0 for other representations
+     */
+    size_t getRank( ) const;
+
+private:
+    //----------------------------------------------------------------------
+    /**
+     Tries to decompose A - shift*I into U*V^T by Gaussian elimination with
+     complete pivoting. Stops as soon as the rank exceeds maxRank.
+
+     @returns                   true if a decomposition with rank <= maxRank
+                                was found
+     */
+    bool decompose( const mat& A,
+                    double shift,
+                    size_t maxRank );
+
+    //----------------------------------------------------------------------
+    /** Number of rows of the matrix */
+    size_t numRows;
+    /** Number of columns of the matrix */
+    size_t numCols;
+    /** Chosen representation */
+    matVecType type;
+    /** Nonzero values row by row (sparse), all values row-major (dense)
+        or U row-major (low-rank) */
+    std::vector<double> values;
+    /** Column of each nonzero value (sparse only) */
+    std::vector<size_t> colIndex;
+    /** Start of each row in values, numRows+1 entries (sparse only) */
+    std::vector<size_t> rowStart;
+    /** Rank of the low-rank representation */
+    size_t rank;
+    /** Diagonal shift D of the low-rank representation */
+    double shift;
+    /** V^T row-major, rank x numCols (low-rank only) */
+    std::vector<double> vt;
+    /** Scratch space for V^T * x (low-rank only) */
+    mutable std::vector<double> temp;
+
+};
+
+#endif  // RTWDF_MATVEC_H_INCLUDED
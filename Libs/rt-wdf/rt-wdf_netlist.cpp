@@ -0,0 +1,955 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_netlist.cpp
+ Created: 18 Oct 2026 10:12:00am
+
+ ==============================================================================
+ */
+
+#include "rt-wdf_netlist.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+
+
+//==============================================================================
+// Netlist parsing helpers
+//==============================================================================
+static std::string toLower( std::string str ) {
+    std::transform( str.begin(), str.end(), str.begin(), ::tolower );
+    return str;
+}
+
+//----------------------------------------------------------------------
+static bool parseValue( const std::string& token,
+                        double* value ) {
+    const char* start = token.c_str();
+    char* end;
+    double v = strtod( start, &end );
+    if( end == start ) {
+        return false;
+    }
+
+    // SPICE scale suffixes, any trailing unit is ignored
+    const std::string suffix = toLower( end );
+    if( suffix.compare( 0, 3, "meg" ) == 0 ) {
+        v *= 1.0e6;
+    }
+    else if( !suffix.empty() ) {
+        switch( suffix[0] ) {
+            case 't': v *= 1.0e12;  break;
+            case 'g': v *= 1.0e9;   break;
+            case 'k': v *= 1.0e3;   break;
+            case 'm': v *= 1.0e-3;  break;
+            case 'u': v *= 1.0e-6;  break;
+            case 'n': v *= 1.0e-9;  break;
+            case 'p': v *= 1.0e-12; break;
+            case 'f': v *= 1.0e-15; break;
+            default:                break;
+        }
+    }
+
+    *value = v;
+    return true;
+}
+
+
+//==============================================================================
+//                          N E T L I S T   T R E E
+//==============================================================================
+wdfNetlistTree::wdfNetlistTree( ) : wdfTree( ),
+                                    inputVSource( NULL ),
+                                    inputCSource( NULL ),
+                                    outputElement( NULL ),
+                                    treeIdentifier( "Netlist" ),
+                                    solverType( NEWTON_SOLVER ),
+                                    fixedIterations( 0 ) {
+    subtreeEntryNodes = NULL;
+    subtreeCount = 0;
+    Rp = NULL;
+}
+
+wdfNetlistTree::~wdfNetlistTree( ) {
+    clear( );
+}
+
+//----------------------------------------------------------------------
+void wdfNetlistTree::clear( ) {
+    root.reset( );
+    rootTopology.reset( );
+    delete[] subtreeEntryNodes;
+    delete[] Rp;
+    subtreeEntryNodes = NULL;
+    Rp = NULL;
+    subtreeCount = 0;
+
+    treeNodes.clear( );
+    elements.clear( );
+    nodeIndices.clear( );
+    branches.clear( );
+    nlBranches.clear( );
+    nlList.clear( );
+    nlDevices.clear( );
+    paramLeafs.clear( );
+    switchResistances.clear( );
+    params.clear( );
+    inputVSource = NULL;
+    inputCSource = NULL;
+    outputElement = NULL;
+    treeIdentifier = "Netlist";
+    solverType = NEWTON_SOLVER;
+    fixedIterations = 0;
+}
+
+//----------------------------------------------------------------------
+int wdfNetlistTree::loadNetlist( const std::string& fileName ) {
+    std::ifstream file( fileName.c_str() );
+    if( !file.is_open() ) {
+        errorMessage = "Can't open netlist file " + fileName;
+        return -1;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return parseNetlist( buffer.str() );
+}
+
+//----------------------------------------------------------------------
+int wdfNetlistTree::parseNetlist( const std::string& netlist ) {
+    clear( );
+    errorMessage.clear( );
+
+    // join continuation lines and strip comments
+    std::vector<std::vector<std::string>> lines;
+    std::istringstream input( netlist );
+    std::string line;
+    while( std::getline( input, line ) ) {
+        line = line.substr( 0, line.find( ';' ) );
+        std::istringstream lineStream( line );
+        std::vector<std::string> tokens;
+        std::string token;
+        while( lineStream >> token ) {
+            tokens.push_back( toLower( token ) );
+        }
+        if( tokens.empty() || tokens[0][0] == '*' ) {
+            continue;
+        }
+        if( tokens[0][0] == '+' && !lines.empty() ) {
+            tokens[0].erase( 0, 1 );
+            for( const std::string& t : tokens ) {
+                if( !t.empty() ) {
+                    lines.back().push_back( t );
+                }
+            }
+            continue;
+        }
+        lines.push_back( tokens );
+    }
+
+    // elements first, directives may refer to elements defined later
+    std::vector<std::vector<std::string>> directives;
+    for( const std::vector<std::string>& tokens : lines ) {
+        const std::string& name = tokens[0];
+
+        if( name[0] == '.' ) {
+            if( name == ".end" ) {
+                break;
+            }
+            directives.push_back( tokens );
+            continue;
+        }
+
+        if( elements.count( name ) ) {
+            errorMessage = "Element " + name + " is defined twice";
+            return -1;
+        }
+
+        switch( name[0] ) {
+            case 'r':
+            case 'c':
+            case 'l':
+            case 'v':
+            case 'i':
+            case 's':
+            {
+                if( tokens.size() < 3 ) {
+                    errorMessage = "Missing nodes for element " + name;
+                    return -1;
+                }
+                size_t nPlus  = getNodeIndex( tokens[1] );
+                size_t nMinus = getNodeIndex( tokens[2] );
+                if( nPlus == nMinus ) {
+                    errorMessage = "Element " + name + " is shorted";
+                    return -1;
+                }
+
+                double value = 0;
+                if( name[0] != 's' ) {
+                    if( tokens.size() < 4 || !parseValue( tokens[3], &value ) ) {
+                        errorMessage = "Missing or invalid value for element " + name;
+                        return -1;
+                    }
+                }
+
+                wdfTreeNode* leaf = NULL;
+                netlistBranch branch = { nPlus, nMinus, NULL };
+                switch( name[0] ) {
+                    case 'r':
+                    case 'c':
+                    case 'l':
+                    {
+                        if( value <= 0 ) {
+                            errorMessage = "Value of element " + name + " must be positive";
+                            return -1;
+                        }
+                        if( name[0] == 'r' ) {
+                            leaf = new wdfTerminatedRes( value );
+                        }
+                        else if( name[0] == 'c' ) {
+                            leaf = new wdfTerminatedCap( value, treeSampleRate );
+                        }
+                        else {
+                            leaf = new wdfTerminatedInd( value, treeSampleRate );
+                        }
+                        break;
+                    }
+                    case 'v':
+                    {
+                        double RSer = NETLIST_VSOURCE_RSER;
+                        if( tokens.size() > 4 && !parseValue( tokens[4], &RSer ) ) {
+                            errorMessage = "Invalid series resistance for " + name;
+                            return -1;
+                        }
+                        leaf = new wdfTerminatedResVSource( value, RSer );
+                        break;
+                    }
+                    case 'i':
+                    {
+                        double RPar = NETLIST_CSOURCE_RPAR;
+                        if( tokens.size() > 4 && !parseValue( tokens[4], &RPar ) ) {
+                            errorMessage = "Invalid parallel resistance for " + name;
+                            return -1;
+                        }
+                        leaf = new wdfTerminatedResCSource( value, RPar );
+                        // SPICE current flows from n+ through the source to n-
+                        branch.from = nMinus;
+                        branch.to   = nPlus;
+                        break;
+                    }
+                    case 's':
+                    {
+                        bool closed = false;
+                        double Ron  = NETLIST_SWITCH_RON;
+                        double Roff = NETLIST_SWITCH_ROFF;
+                        size_t t = 3;
+                        if( tokens.size() > t && ( tokens[t] == "on" || tokens[t] == "off" ) ) {
+                            closed = ( tokens[t] == "on" );
+                            t++;
+                        }
+                        if( ( tokens.size() > t && !parseValue( tokens[t], &Ron ) ) ||
+                            ( tokens.size() > t+1 && !parseValue( tokens[t+1], &Roff ) ) ) {
+                            errorMessage = "Invalid resistances for switch " + name;
+                            return -1;
+                        }
+                        wdfTerminatedRes* swLeaf = new wdfTerminatedRes( closed ? Ron : Roff );
+                        leaf = swLeaf;
+
+                        paramData param;
+                        param.name    = name;
+                        param.ID      = params.size();
+                        param.type    = boolParam;
+                        param.value   = closed ? 1 : 0;
+                        param.units   = "";
+                        param.lowLim  = 0;
+                        param.highLim = 1;
+                        params.push_back( param );
+                        paramLeafs.push_back( swLeaf );
+                        switchResistances.push_back( std::make_pair( Ron, Roff ) );
+                        break;
+                    }
+                    default:
+                        break;
+                }
+
+                branch.node = addTreeNode( leaf );
+                branches.push_back( branch );
+                elements[name] = leaf;
+                break;
+            }
+
+            case 'd':
+            case 'q':
+            case 'j':
+            case 'm':
+            case 't':
+            case 'p':
+            case 'u':
+            {
+                size_t numTerminals = 3;
+                if( name[0] == 'd' ) {
+                    numTerminals = 2;
+                }
+                else if( name[0] == 'p' ) {
+                    numTerminals = 4;
+                }
+                if( tokens.size() < numTerminals+1 ) {
+                    errorMessage = "Missing nodes for element " + name;
+                    return -1;
+                }
+                std::vector<size_t> terminals;
+                for( size_t t = 1; t <= numTerminals; t++ ) {
+                    terminals.push_back( getNodeIndex( tokens[t] ) );
+                }
+                size_t t = numTerminals+1;
+                std::string model;
+                if( tokens.size() > t && tokens[t].find( '=' ) == std::string::npos ) {
+                    model = tokens[t];
+                    t++;
+                }
+
+                if( name[0] == 'd' ) {
+                    // port: anode -> cathode
+                    if( model.empty() || model == "diode" ) {
+                        nlList.push_back( DIODE );
+                    }
+                    else if( model == "diode_ap" ) {
+                        nlList.push_back( DIODE_AP );
+                    }
+                    else {
+                        errorMessage = "Unknown diode model " + model;
+                        return -1;
+                    }
+                    nlBranches.push_back( { terminals[0], terminals[1], NULL } );
+                }
+                else if( name[0] == 'q' ) {
+                    // ports: base -> collector, base -> emitter
+                    if( model.empty() || model == "npn" ) {
+                        nlList.push_back( NPN_EM );
+                    }
+                    else if( model == "pnp" ) {
+                        nlList.push_back( PNP_EM );
+                    }
+                    else {
+                        errorMessage = "Unknown transistor model " + model;
+                        return -1;
+                    }
+                    nlBranches.push_back( { terminals[1], terminals[0], NULL } );
+                    nlBranches.push_back( { terminals[1], terminals[2], NULL } );
+                }
+                else if( name[0] == 'j' || name[0] == 'm' ) {
+                    // ports: drain -> source, gate -> source
+                    const bool jfet = ( name[0] == 'j' );
+                    if( model.empty() || model == ( jfet ? "njf" : "nmos" ) ) {
+                        nlList.push_back( jfet ? NJF_SH : NMOS_SH );
+                    }
+                    else if( model == ( jfet ? "pjf" : "pmos" ) ) {
+                        nlList.push_back( jfet ? PJF_SH : PMOS_SH );
+                    }
+                    else {
+                        errorMessage = "Unknown transistor model " + model;
+                        return -1;
+                    }
+                    nlBranches.push_back( { terminals[0], terminals[2], NULL } );
+                    nlBranches.push_back( { terminals[1], terminals[2], NULL } );
+                }
+                else if( name[0] == 't' ) {
+                    // ports: anode -> cathode, grid -> cathode
+                    if( !model.empty() && model != "triode" ) {
+                        errorMessage = "Unknown tube model " + model;
+                        return -1;
+                    }
+                    nlList.push_back( TRI_DW );
+                    nlBranches.push_back( { terminals[0], terminals[2], NULL } );
+                    nlBranches.push_back( { terminals[1], terminals[2], NULL } );
+                }
+                else if( name[0] == 'p' ) {
+                    // ports: anode -> cathode, grid -> cathode, screen -> cathode
+                    if( !model.empty() && model != "pentode" ) {
+                        errorMessage = "Unknown tube model " + model;
+                        return -1;
+                    }
+                    nlList.push_back( PEN_KOREN );
+                    nlBranches.push_back( { terminals[0], terminals[3], NULL } );
+                    nlBranches.push_back( { terminals[1], terminals[3], NULL } );
+                    nlBranches.push_back( { terminals[2], terminals[3], NULL } );
+                }
+                else {
+                    // ports: in+ -> in-, out -> ground
+                    if( !model.empty() && model != "opamp" ) {
+                        errorMessage = "Unknown op-amp model " + model;
+                        return -1;
+                    }
+                    nlList.push_back( OPAMP_SAT );
+                    nlBranches.push_back( { terminals[0], terminals[1], NULL } );
+                    nlBranches.push_back( { terminals[2], getNodeIndex( "0" ), NULL } );
+                }
+                for( const netlistBranch& nlBranch : nlBranches ) {
+                    if( nlBranch.from == nlBranch.to ) {
+                        errorMessage = "Element " + name + " is shorted";
+                        return -1;
+                    }
+                }
+
+                netlistDevice device;
+                device.name = name;
+                double emission = 1.0;
+                for( ; t < tokens.size(); t++ ) {
+                    if( !parseDeviceParam( tokens[t], nlList.back(), &device, &emission ) ) {
+                        errorMessage = "Invalid parameter " + tokens[t] + " for element " + name;
+                        return -1;
+                    }
+                }
+                if( device.opamp.Vpos <= device.opamp.Vneg ) {
+                    errorMessage = "Invalid supply rails for element " + name;
+                    return -1;
+                }
+                device.diode.VT *= emission;
+                nlDevices.push_back( device );
+                elements[name] = NULL;
+                break;
+            }
+
+            default:
+            {
+                errorMessage = "Unknown element " + name;
+                return -1;
+            }
+        }
+    }
+
+    for( const std::vector<std::string>& tokens : directives ) {
+        const std::string& directive = tokens[0];
+        if( directive == ".title" ) {
+            treeIdentifier.clear( );
+            for( size_t t = 1; t < tokens.size(); t++ ) {
+                treeIdentifier += ( t > 1 ? " " : "" ) + tokens[t];
+            }
+            continue;
+        }
+        if( directive == ".solver" ) {
+            const std::string type = ( tokens.size() > 1 ) ? tokens[1] : "";
+            if( type == "newton" ) {
+                solverType = NEWTON_SOLVER;
+            }
+            else if( type == "broyden" ) {
+                solverType = BROYDEN_SOLVER;
+            }
+            else if( type == "chord" ) {
+                solverType = CHORD_SOLVER;
+            }
+            else if( type == "mlp" ) {
+                solverType = MLP_SOLVER;
+            }
+            else {
+                errorMessage = "Unknown solver " + type;
+                return -1;
+            }
+            continue;
+        }
+        if( directive == ".iterations" ) {
+            double iterations;
+            if( tokens.size() < 2 || !parseValue( tokens[1], &iterations ) ||
+                iterations < 0 || iterations != (int)iterations ) {
+                errorMessage = "Directive .iterations needs a number of iterations";
+                return -1;
+            }
+            fixedIterations = (int)iterations;
+            continue;
+        }
+        if( directive == ".table" ) {
+            netlistDevice* device = NULL;
+            for( netlistDevice& nlDevice : nlDevices ) {
+                if( tokens.size() > 1 && nlDevice.name == tokens[1] ) {
+                    device = &nlDevice;
+                    break;
+                }
+            }
+            if( !device ) {
+                errorMessage = "Directive .table needs a non-linear element";
+                return -1;
+            }
+            if( tokens.size() < 5 || ( tokens.size() - 2 ) % 3 != 0 ) {
+                errorMessage = "Invalid table range for element " + tokens[1];
+                return -1;
+            }
+            device->tableMin.clear( );
+            device->tableMax.clear( );
+            device->tablePoints.clear( );
+            for( size_t t = 2; t < tokens.size(); t += 3 ) {
+                double lowLim;
+                double highLim;
+                double points;
+                if( !parseValue( tokens[t], &lowLim ) ||
+                    !parseValue( tokens[t+1], &highLim ) ||
+                    !parseValue( tokens[t+2], &points ) ||
+                    !( highLim > lowLim ) || points < 2 || points != (int)points ) {
+                    errorMessage = "Invalid table range for element " + tokens[1];
+                    return -1;
+                }
+                device->tableMin.push_back( lowLim );
+                device->tableMax.push_back( highLim );
+                device->tablePoints.push_back( (int)points );
+            }
+            continue;
+        }
+
+        if( tokens.size() < 2 || !getElement( tokens[1] ) ) {
+            errorMessage = "Directive " + directive + " needs a linear element";
+            return -1;
+        }
+        wdfTreeNode* element = getElement( tokens[1] );
+
+        if( directive == ".input" ) {
+            inputVSource = dynamic_cast<wdfTerminatedResVSource*>( element );
+            inputCSource = dynamic_cast<wdfTerminatedResCSource*>( element );
+            if( !inputVSource && !inputCSource ) {
+                errorMessage = "Input " + tokens[1] + " is not a source";
+                return -1;
+            }
+        }
+        else if( directive == ".output" ) {
+            outputElement = element;
+        }
+        else if( directive == ".pot" ) {
+            wdfTerminatedRes* potLeaf = dynamic_cast<wdfTerminatedRes*>( element );
+            paramData param;
+            if( !potLeaf || tokens[1][0] != 'r' || tokens.size() < 4 ||
+                !parseValue( tokens[2], &param.lowLim ) ||
+                !parseValue( tokens[3], &param.highLim ) ) {
+                errorMessage = "Invalid potentiometer " + tokens[1];
+                return -1;
+            }
+            param.name  = tokens[1];
+            param.ID    = params.size();
+            param.type  = doubleParam;
+            param.value = potLeaf->R;
+            param.units = "Ohm";
+            params.push_back( param );
+            paramLeafs.push_back( potLeaf );
+            switchResistances.push_back( std::make_pair( 0.0, 0.0 ) );
+        }
+        else {
+            errorMessage = "Unknown directive " + directive;
+            return -1;
+        }
+    }
+
+    if( !inputVSource && !inputCSource ) {
+        for( const netlistBranch& branch : branches ) {
+            inputVSource = dynamic_cast<wdfTerminatedResVSource*>( branch.node );
+            if( inputVSource ) {
+                break;
+            }
+        }
+    }
+
+    reduceBranches( );
+    return createRoot( );
+}
+
+//----------------------------------------------------------------------
+const std::string& wdfNetlistTree::getErrorMessage( ) const {
+    return errorMessage;
+}
+
+//----------------------------------------------------------------------
+void wdfNetlistTree::setTableCacheDirectory( const std::string& directory ) {
+    tableCacheDirectory = directory;
+}
+
+//----------------------------------------------------------------------
+wdfTreeNode* wdfNetlistTree::getElement( const std::string& name ) {
+    std::map<std::string, wdfTreeNode*>::iterator it = elements.find( toLower( name ) );
+    if( it == elements.end() ) {
+        return NULL;
+    }
+    return it->second;
+}
+
+//----------------------------------------------------------------------
+size_t wdfNetlistTree::getNodeIndex( const std::string& nodeName ) {
+    // "0" and "gnd" are the same node
+    const std::string name = ( nodeName == "gnd" ) ? "0" : nodeName;
+    std::map<std::string, size_t>::iterator it = nodeIndices.find( name );
+    if( it != nodeIndices.end() ) {
+        return it->second;
+    }
+    const size_t index = nodeIndices.size();
+    nodeIndices[name] = index;
+    return index;
+}
+
+//----------------------------------------------------------------------
+wdfTreeNode* wdfNetlistTree::addTreeNode( wdfTreeNode* node ) {
+    treeNodes.push_back( std::unique_ptr<wdfTreeNode>( node ) );
+    return node;
+}
+
+//----------------------------------------------------------------------
+void wdfNetlistTree::reduceBranches( ) {
+    bool reduced = true;
+    while( reduced ) {
+        reduced = false;
+
+        // a purely linear circuit keeps two branches for the R-type root
+        if( nlBranches.empty() && branches.size() <= 2 ) {
+            break;
+        }
+
+        // parallel reduction: two branches between the same nodes
+        for( size_t i = 0; i < branches.size() && !reduced; i++ ) {
+            for( size_t j = i+1; j < branches.size() && !reduced; j++ ) {
+                netlistBranch& bi = branches[i];
+                netlistBranch& bj = branches[j];
+                const bool sameDir = ( bi.from == bj.from && bi.to == bj.to );
+                const bool flipDir = ( bi.from == bj.to && bi.to == bj.from );
+                if( !sameDir && !flipDir ) {
+                    continue;
+                }
+                wdfTreeNode* right = bj.node;
+                if( flipDir ) {
+                    right = addTreeNode( new wdfInverter( right ) );
+                }
+                bi.node = addTreeNode( new wdfTerminatedParallel( bi.node, right ) );
+                branches.erase( branches.begin() + j );
+                reduced = true;
+            }
+        }
+        if( reduced ) {
+            continue;
+        }
+
+        // series reduction: a node that only connects two subtree branches
+        std::vector<size_t> degree( nodeIndices.size(), 0 );
+        for( const netlistBranch& b : branches ) {
+            degree[b.from]++;
+            degree[b.to]++;
+        }
+        for( const netlistBranch& b : nlBranches ) {
+            // never eliminate nodes of non-linear devices
+            degree[b.from] += 3;
+            degree[b.to] += 3;
+        }
+        for( size_t n = 0; n < degree.size() && !reduced; n++ ) {
+            if( degree[n] != 2 ) {
+                continue;
+            }
+            std::vector<size_t> incident;
+            for( size_t i = 0; i < branches.size(); i++ ) {
+                if( branches[i].from == n || branches[i].to == n ) {
+                    incident.push_back( i );
+                }
+            }
+
+            // orient left branch as x -> n and right branch as n -> y
+            netlistBranch& bl = branches[incident[0]];
+            netlistBranch& br = branches[incident[1]];
+            wdfTreeNode* left  = bl.node;
+            wdfTreeNode* right = br.node;
+            const size_t x = ( bl.to == n ) ? bl.from : bl.to;
+            const size_t y = ( br.from == n ) ? br.to : br.from;
+            if( bl.to != n ) {
+                left = addTreeNode( new wdfInverter( left ) );
+            }
+            if( br.from != n ) {
+                right = addTreeNode( new wdfInverter( right ) );
+            }
+
+            // the series adapter's port voltage is -(v_left + v_right)
+            bl.node = addTreeNode( new wdfTerminatedSeries( left, right ) );
+            bl.from = y;
+            bl.to   = x;
+            branches.erase( branches.begin() + incident[1] );
+            reduced = true;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+bool wdfNetlistTree::parseDeviceParam( const std::string& token,
+                                       int type,
+                                       netlistDevice* device,
+                                       double* emission ) {
+    const size_t eq = token.find( '=' );
+    double value;
+    if( eq == std::string::npos || !parseValue( token.substr( eq+1 ), &value ) ) {
+        return false;
+    }
+    const std::string key = token.substr( 0, eq );
+
+    if( ( type == DIODE || type == DIODE_AP ) && key == "series" ) {
+        if( value < 1 || value != (int)value ) {
+            return false;
+        }
+        device->diode.numSeries = (int)value;
+        return true;
+    }
+
+    std::map<std::string, double*> keys;
+    if( type == DIODE || type == DIODE_AP ) {
+        keys["is"] = &device->diode.Is;
+        keys["vt"] = &device->diode.VT;
+        keys["n"]  = emission;
+    }
+    else if( type == NPN_EM || type == PNP_EM ) {
+        keys["is"] = &device->bjt.Is;
+        keys["vt"] = &device->bjt.VT;
+        keys["bf"] = &device->bjt.betaF;
+        keys["br"] = &device->bjt.betaR;
+    }
+    else if( type == TRI_DW ) {
+        keys["g"]     = &device->triode.G;
+        keys["c"]     = &device->triode.C;
+        keys["mu"]    = &device->triode.mu;
+        keys["gamma"] = &device->triode.gamma;
+        keys["gg"]    = &device->triode.Gg;
+        keys["cg"]    = &device->triode.Cg;
+        keys["xi"]    = &device->triode.xi;
+        keys["ig0"]   = &device->triode.Ig0;
+    }
+    else if( type == PEN_KOREN ) {
+        keys["mu"]    = &device->pentode.mu;
+        keys["ex"]    = &device->pentode.ex;
+        keys["kg1"]   = &device->pentode.kg1;
+        keys["kg2"]   = &device->pentode.kg2;
+        keys["kp"]    = &device->pentode.kp;
+        keys["kvb"]   = &device->pentode.kvb;
+        keys["gg"]    = &device->pentode.Gg;
+        keys["cg"]    = &device->pentode.Cg;
+        keys["xi"]    = &device->pentode.xi;
+        keys["ig0"]   = &device->pentode.Ig0;
+    }
+    else if( type == NJF_SH || type == PJF_SH ) {
+        keys["vto"]    = &device->jfet.VTO;
+        keys["beta"]   = &device->jfet.beta;
+        keys["lambda"] = &device->jfet.lambda;
+        keys["is"]     = &device->jfet.Is;
+        keys["vt"]     = &device->jfet.VT;
+    }
+    else if( type == NMOS_SH || type == PMOS_SH ) {
+        keys["vto"]    = &device->mosfet.VTO;
+        keys["beta"]   = &device->mosfet.beta;
+        keys["lambda"] = &device->mosfet.lambda;
+    }
+    else if( type == OPAMP_SAT ) {
+        keys["a"]    = &device->opamp.A;
+        keys["vpos"] = &device->opamp.Vpos;
+        keys["vneg"] = &device->opamp.Vneg;
+        keys["rout"] = &device->opamp.Rout;
+        keys["rin"]  = &device->opamp.Rin;
+    }
+
+    std::map<std::string, double*>::iterator it = keys.find( key );
+    if( it == keys.end() ) {
+        return false;
+    }
+    // offsets, thresholds and supply rails take any sign, channel length
+    // modulation may be switched off, all other parameters are positive
+    const bool isSigned = ( key == "ig0" || key == "vto" ||
+                            key == "vpos" || key == "vneg" );
+    if( ( key == "lambda" && value < 0 ) ||
+        ( key != "lambda" && !isSigned && value <= 0 ) ) {
+        return false;
+    }
+    *it->second = value;
+    return true;
+}
+
+//----------------------------------------------------------------------
+int wdfNetlistTree::createRoot( ) {
+    if( branches.empty() ) {
+        errorMessage = "Netlist contains no linear elements";
+        return -1;
+    }
+
+    subtreeCount = branches.size();
+    subtreeEntryNodes = new wdfTreeNode*[subtreeCount];
+    Rp = new double[subtreeCount];
+    for( size_t i = 0; i < subtreeCount; i++ ) {
+        subtreeEntryNodes[i] = branches[i].node;
+        Rp[i] = 0;
+    }
+
+    // renumber the nodes of the root, ground is the reference node unless
+    // it was removed by the reduction
+    std::vector<size_t> rootNode( nodeIndices.size(), 0 );
+    for( const std::vector<netlistBranch>* list : { &branches, &nlBranches } ) {
+        for( const netlistBranch& b : *list ) {
+            rootNode[b.from] = 1;
+            rootNode[b.to]   = 1;
+        }
+    }
+    size_t refNode = branches[0].from;
+    std::map<std::string, size_t>::iterator gnd = nodeIndices.find( "0" );
+    if( gnd != nodeIndices.end() && rootNode[gnd->second] ) {
+        refNode = gnd->second;
+    }
+    size_t numNodes = 1;
+    for( size_t n = 0; n < rootNode.size(); n++ ) {
+        if( rootNode[n] ) {
+            rootNode[n] = ( n == refNode ) ? 0 : numNodes++;
+        }
+    }
+
+    // a node that only non-linear ports touch has no conductance in the
+    // nodal matrix of the root, which would make it singular
+    std::vector<bool> linearNode( nodeIndices.size(), false );
+    for( const netlistBranch& b : branches ) {
+        linearNode[b.from] = true;
+        linearNode[b.to]   = true;
+    }
+    for( const netlistBranch& b : nlBranches ) {
+        for( size_t n : { b.from, b.to } ) {
+            if( n == refNode || linearNode[n] ) {
+                continue;
+            }
+            std::string nodeName;
+            for( const std::pair<const std::string, size_t>& node : nodeIndices ) {
+                if( node.second == n ) {
+                    nodeName = node.first;
+                }
+            }
+            std::string deviceNames;
+            size_t port = 0;
+            for( size_t m = 0; m < nlDevices.size(); m++ ) {
+                const size_t endPort = port + nlModel::getNumPorts( nlList[m] );
+                bool touches = false;
+                for( ; port < endPort; port++ ) {
+                    touches = touches || nlBranches[port].from == n || nlBranches[port].to == n;
+                }
+                if( touches ) {
+                    deviceNames += ( deviceNames.empty() ? "" : ", " ) + nlDevices[m].name;
+                }
+            }
+            errorMessage = "Node " + nodeName + " is only connected to non-linear elements (" +
+                           deviceNames + "), connect a linear element to it";
+            return -1;
+        }
+    }
+
+    std::vector<std::pair<size_t,size_t>> subtreePorts;
+    std::vector<std::pair<size_t,size_t>> nlPorts;
+    for( const netlistBranch& b : branches ) {
+        subtreePorts.push_back( std::make_pair( rootNode[b.from], rootNode[b.to] ) );
+    }
+    for( const netlistBranch& b : nlBranches ) {
+        nlPorts.push_back( std::make_pair( rootNode[b.from], rootNode[b.to] ) );
+    }
+    rootTopology.reset( new wdfRootTopology( subtreePorts, nlPorts ) );
+
+    if( nlList.empty() ) {
+        root.reset( new wdfRootRtype( (int)subtreeCount ) );
+    }
+    else {
+        wdfRootMixed* mixedRoot = new wdfRootMixed( (int)subtreeCount, nlList, solverType );
+        nlNewtonSolver* solver = mixedRoot->getNlSolver( );
+        solver->setFixedIterations( fixedIterations );
+        for( size_t m = 0; m < solver->nlModels.size(); m++ ) {
+            nlModel* model = solver->nlModels[m];
+            if( diodeModel* diode = dynamic_cast<diodeModel*>( model ) ) {
+                diode->setParams( nlDevices[m].diode );
+            }
+            else if( npnEmModel* bjt = dynamic_cast<npnEmModel*>( model ) ) {
+                bjt->setParams( nlDevices[m].bjt );
+            }
+            else if( triDwModel* triode = dynamic_cast<triDwModel*>( model ) ) {
+                triode->setParams( nlDevices[m].triode );
+            }
+            else if( pentodeKorenModel* pentode = dynamic_cast<pentodeKorenModel*>( model ) ) {
+                pentode->setParams( nlDevices[m].pentode );
+            }
+            else if( jfetShModel* jfet = dynamic_cast<jfetShModel*>( model ) ) {
+                jfet->setParams( nlDevices[m].jfet );
+            }
+            else if( mosfetShModel* mosfet = dynamic_cast<mosfetShModel*>( model ) ) {
+                mosfet->setParams( nlDevices[m].mosfet );
+            }
+            else if( opampSatModel* opamp = dynamic_cast<opampSatModel*>( model ) ) {
+                opamp->setParams( nlDevices[m].opamp );
+            }
+        }
+        for( size_t m = 0; m < nlDevices.size(); m++ ) {
+            const netlistDevice& device = nlDevices[m];
+            if( !device.tablePoints.empty() &&
+                solver->tabulateModel( m, device.tableMin, device.tableMax,
+                                       device.tablePoints, tableCacheDirectory ) != 0 ) {
+                delete mixedRoot;
+                errorMessage = "Table of element " + device.name + " needs one range per port";
+                return -1;
+            }
+        }
+        root.reset( mixedRoot );
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+int wdfNetlistTree::setRootMatrData( matData* rootMatrixData,
+                                     double *Rp ) {
+    if( rootTopology->setRootMatrData( rootMatrixData, Rp ) != 0 ) {
+        errorMessage = "Root of the netlist is singular (floating node?)";
+        return -1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void wdfNetlistTree::setInputValue( double signalIn ) {
+    if( inputVSource ) {
+        inputVSource->Vs = signalIn;
+    }
+    else if( inputCSource ) {
+        inputCSource->Is = signalIn;
+    }
+}
+
+//----------------------------------------------------------------------
+double wdfNetlistTree::getOutputValue( ) {
+    if( outputElement ) {
+        return outputElement->upPort->getPortVoltage( );
+    }
+    return 0.0;
+}
+
+//----------------------------------------------------------------------
+const char* wdfNetlistTree::getTreeIdentifier( ) {
+    return treeIdentifier.c_str( );
+}
+
+//----------------------------------------------------------------------
+void wdfNetlistTree::setParam( size_t paramID,
+                               double paramValue ) {
+    if( paramID >= params.size() ) {
+        return;
+    }
+    params[paramID].value = paramValue;
+
+    if( params[paramID].type == boolParam ) {
+        const std::pair<double,double>& Rsw = switchResistances[paramID];
+        paramLeafs[paramID]->R = ( paramValue > 0.5 ) ? Rsw.first : Rsw.second;
+    }
+    else {
+        paramLeafs[paramID]->R = paramValue;
+    }
+    adaptTree( );
+}
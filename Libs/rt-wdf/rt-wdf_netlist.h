@@ -0,0 +1,350 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_netlist.h
+ Created: 18 Oct 2026 10:12:00am
+
+ ==============================================================================
+ */
+
+#ifndef RTWDF_NETLIST_H_INCLUDED
+#define RTWDF_NETLIST_H_INCLUDED
+
+//==============================================================================
+#include <string>
+#include <vector>
+#include <map>
+
+#include "rt-wdf.h"
+#include "rt-wdf_rootTopology.h"
+
+
+//==============================================================================
+// Netlist importer config parameters
+
+/** Series resistance of a voltage source if the netlist doesn't specify one */
+#define NETLIST_VSOURCE_RSER    1.0e-3
+/** Parallel resistance of a current source if the netlist doesn't specify one */
+#define NETLIST_CSOURCE_RPAR    1.0e+9
+/** Default resistance of a closed switch */
+#define NETLIST_SWITCH_RON      1.0e-3
+/** Default resistance of an open switch */
+#define NETLIST_SWITCH_ROFF     1.0e+9
+
+
+//==============================================================================
+class wdfNetlistTree : public wdfTree {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     WDF tree that is built from a SPICE-like netlist.
+
+     Instead of hand-writing a wdfTree subclass, the structure is derived
+     from a netlist: all adaptable elements are combined into series/parallel
+     subtrees (wdfTerminatedSeries, wdfTerminatedParallel, wdfInverter) by
+     repeated series-parallel reduction of the circuit graph. Whatever is left
+     after the reduction together with all non-linear ports forms an R-type
+     (wdfRootRtype) or non-linear (wdfRootMixed) root. The root matrices are
+     derived from the remaining graph by a wdfRootTopology, so
+     setRootMatrData() needs no hand-derived implementation.
+
+     Supported netlist lines (one element per line, case-insensitive, values
+     accept SPICE suffixes like k, m, u, n, p, meg):
+
+         * comment
+         Rname n+ n- R
+         Cname n+ n- C
+         Lname n+ n- L
+         Vname n+ n- Vs [Rser]
+         Iname n+ n- Is [Rpar]
+         Dname anode cathode [DIODE|DIODE_AP] [IS= N= VT= SERIES=]
+         Qname collector base emitter [NPN|PNP] [IS= VT= BF= BR=]
+         Jname drain gate source [NJF|PJF] [VTO= BETA= LAMBDA= IS= VT=]
+         Mname drain gate source [NMOS|PMOS] [VTO= BETA= LAMBDA=]
+         Tname anode grid cathode [TRIODE] [G= C= MU= GAMMA= GG= CG= XI= IG0=]
+         Pname anode grid screen cathode [PENTODE]
+               [MU= EX= KG1= KG2= KP= KVB= GG= CG= XI= IG0=]
+         Uname in+ in- out [OPAMP] [A= VPOS= VNEG= ROUT= RIN=]
+         Sname n+ n- [ON|OFF] [Ron] [Roff]
+         .title identifier
+         .input Vname|Iname
+         .output name
+         .pot Rname lowLim highLim
+         .solver NEWTON|BROYDEN|CHORD|MLP
+         .iterations K
+         .table Dname|Qname|... min max points [min max points ...]
+         .end
+
+     Device parameters that are not given keep the defaults of
+     rt-wdf_nlModels.h. For diodes, the emission coefficient N scales the
+     thermal voltage VT and SERIES folds a string of identical diodes into
+     the port. FET parameters are given in the n-channel convention for
+     both polarities. The op-amp output is referenced to node 0.
+
+     Every node except the reference node must be connected to at least
+     one linear element. The non-linear ports are solved as currents into
+     the linear network, so a node that only non-linear ports touch (two
+     diodes in series, a diode between two tube terminals) leaves the root
+     singular. parseNetlist() rejects such a netlist and names the node;
+     add a resistor (e.g. a large one to ground) or merge the devices, for
+     example a diode string with SERIES=.
+
+     ".solver MLP" selects an nlMlpSolver. It iterates like the Newton
+     solver until a network is loaded into the getNlSolver() of the root
+     with nlMlpSolver::loadNetwork().
+
+     ".table" replaces the model of a non-linear device by an nlTableModel
+     with one range and number of grid points per port, in the order of the
+     ports of the model (e.g. anode -> cathode and grid -> cathode for
+     triodes). The tables are generated on all cores and can be cached on
+     disk with setTableCacheDirectory().
+
+     Use it like any other tree: call loadNetlist() or parseNetlist(), then
+     initTree(), setSamplerate() and adaptTree().
+     */
+    wdfNetlistTree( );
+
+    //----------------------------------------------------------------------
+    /**
+     Deconstructor
+     */
+    virtual ~wdfNetlistTree( );
+
+    //----------------------------------------------------------------------
+    /**
+     Reads a netlist from a file and builds the tree from it.
+
+     @param fileName            path to the netlist file
+
+     @returns                   0 for success, -1 for error. See
+                                getErrorMessage() for details.
+     */
+    int loadNetlist( const std::string& fileName );
+
+    //----------------------------------------------------------------------
+    /**
+     Builds the tree from a netlist string.
+
+     @param netlist             netlist text as described in the class
+                                documentation
+
+     @returns                   0 for success, -1 for error. See
+                                getErrorMessage() for details.
+     */
+    int parseNetlist( const std::string& netlist );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns a human readable description of the last error.
+
+     @returns                   the error message of the last failed call
+     */
+    const std::string& getErrorMessage( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Sets the directory where the tables of ".table" are cached, see
+     nlTableModel. Applies to the netlists parsed afterwards.
+
+     @param directory           existing directory for the cache files,
+                                empty (default) to generate the tables
+                                without cache
+     */
+    void setTableCacheDirectory( const std::string& directory );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the leaf which implements a netlist element.
+
+     @param name                name of the element as used in the netlist
+     @returns                   a pointer to the leaf or NULL if no linear
+                                element with that name exists
+     */
+    wdfTreeNode* getElement( const std::string& name );
+
+    //----------------------------------------------------------------------
+    /**
+     Derives the root matrices from the port resistances of the subtrees.
+
+     For an R-type root Smat is filled, for a non-linear root E,F,M and N.
+
+     @param rootMatrixData      is a pointer to the matData object of the
+                                root
+     @param Rp                  is a vector of port resistances of all
+                                subtrees of the root.
+
+     @returns                   0 for success, -1 for error
+     */
+    virtual int setRootMatrData( matData* rootMatrixData,
+                                 double *Rp );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets the value of the source that was selected by ".input".
+
+     @param signalIn            voltage or current of the input source
+     */
+    virtual void setInputValue( double signalIn );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the voltage across the element that was selected by ".output".
+
+     @returns                   a double type output value
+     */
+    virtual double getOutputValue( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the identifier that was set by ".title".
+
+     @returns                   a const char* as an identifier string for the
+                                tree
+     */
+    virtual const char* getTreeIdentifier( );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets a potentiometer (".pot") or switch parameter and re-adapts the
+     tree.
+
+     @param paramID             parameter ID as listed in getParams()
+     @param paramValue          value to set the parameter to.
+     */
+    virtual void setParam( size_t paramID,
+                           double paramValue );
+
+private:
+    //----------------------------------------------------------------------
+    /**
+     A two-terminal branch of the circuit graph. A branch either carries a
+     subtree (node != NULL) or a single port of a non-linearity.
+     */
+    typedef struct netlistBranch {
+        size_t from;
+        size_t to;
+        wdfTreeNode* node;
+    } netlistBranch;
+
+    //----------------------------------------------------------------------
+    /**
+     Parameters of a non-linear device. Only the set that matches the
+     model of the device is used.
+     */
+    typedef struct netlistDevice {
+        std::string name;
+        diodeParams diode;
+        bjtParams bjt;
+        triodeParams triode;
+        pentodeParams pentode;
+        jfetParams jfet;
+        mosfetParams mosfet;
+        opampParams opamp;
+        /** table range selected by ".table", empty for the exact model */
+        std::vector<double> tableMin;
+        std::vector<double> tableMax;
+        std::vector<int> tablePoints;
+    } netlistDevice;
+
+    //----------------------------------------------------------------------
+    /**
+     Sets a "key=value" device parameter for the model type of a non-linear
+     device. Returns false for unknown keys or invalid values.
+     */
+    static bool parseDeviceParam( const std::string& token,
+                                  int type,
+                                  netlistDevice* device,
+                                  double* emission );
+
+    //----------------------------------------------------------------------
+    /**
+     Removes all elements and resets the tree to an empty state.
+     */
+    void clear( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the index of a circuit node, creating it if necessary.
+     */
+    size_t getNodeIndex( const std::string& nodeName );
+
+    //----------------------------------------------------------------------
+    /**
+     Takes ownership of a tree node and returns it.
+     */
+    wdfTreeNode* addTreeNode( wdfTreeNode* node );
+
+    //----------------------------------------------------------------------
+    /**
+     Combines branches in series and in parallel until no further reduction
+     is possible. The remaining branches are connected to the root.
+     */
+    void reduceBranches( );
+
+    //----------------------------------------------------------------------
+    /**
+     Creates the root and the subtree arrays after reduceBranches().
+     */
+    int createRoot( );
+
+    //----------------------------------------------------------------------
+    /** Connection topology of the root, derives the root matrices */
+    std::unique_ptr<wdfRootTopology> rootTopology;
+    /** Owner of all tree nodes created from the netlist */
+    std::vector<std::unique_ptr<wdfTreeNode>> treeNodes;
+    /** Linear elements by netlist name */
+    std::map<std::string, wdfTreeNode*> elements;
+    /** Circuit node indices by netlist name */
+    std::map<std::string, size_t> nodeIndices;
+    /** Subtree branches, reduced to the ones connected to the root */
+    std::vector<netlistBranch> branches;
+    /** Non-linear ports, ordered like the ports of the NL solver */
+    std::vector<netlistBranch> nlBranches;
+    /** NL model enums of all non-linear devices for wdfRootNL */
+    std::vector<int> nlList;
+    /** Model parameters of all non-linear devices, ordered like nlList */
+    std::vector<netlistDevice> nlDevices;
+    /** Leafs that are controlled by parameters, indexed by paramID */
+    std::vector<wdfTerminatedRes*> paramLeafs;
+    /** On/off resistances for switch parameters (0 for potentiometers) */
+    std::vector<std::pair<double,double>> switchResistances;
+    /** Voltage source selected by ".input" */
+    wdfTerminatedResVSource* inputVSource;
+    /** Current source selected by ".input" */
+    wdfTerminatedResCSource* inputCSource;
+    /** Element selected by ".output" */
+    wdfTreeNode* outputElement;
+    /** Identifier selected by ".title" */
+    std::string treeIdentifier;
+    /** NL solver selected by ".solver" */
+    int solverType;
+    /** Fixed number of NL solver iterations selected by ".iterations",
+        0 to iterate until convergence */
+    int fixedIterations;
+    /** Directory of the table cache files, empty for no cache */
+    std::string tableCacheDirectory;
+    /** Description of the last error */
+    std::string errorMessage;
+
+};
+
+#endif  // RTWDF_NETLIST_H_INCLUDED
@@ -27,6 +27,26 @@
 */
 
 #include "rt-wdf_nlModels.h"
+#include "rt-wdf_threadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define TABLE_USE_MMAP 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #define TABLE_USE_MMAP 0
+#endif
+
+/** First 8 bytes of a table cache file, "RTWDFTBL" on little-endian machines */
+#define TABLE_CACHE_MAGIC   0x4c42544644575452ULL
 
 
 //==============================================================================
@@ -45,16 +65,58 @@ int nlModel::getNumPorts( ) {
     return numPorts;
 }
 
+//----------------------------------------------------------------------
+int nlModel::getNumPorts( int modelType ) {
+    switch( modelType ) {
+        case DIODE:
+        case DIODE_AP:
+            return 1;
+        case NPN_EM:
+        case PNP_EM:
+        case TRI_DW:
+        case NJF_SH:
+        case PJF_SH:
+        case NMOS_SH:
+        case PMOS_SH:
+        case OPAMP_SAT:
+            return 2;
+        case PEN_KOREN:
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+//----------------------------------------------------------------------
+std::vector<double> nlModel::getSignature( ) {
+    return std::vector<double>( );
+}
+
 
 //==============================================================================
 // Diode Models according to Kurt Werner et al
 // ("An Improved and Generalized Diode Clipper Model for Wave Digital Filters")
 //==============================================================================
-#define Is_DIODE    2.52e-9
-#define VT_DIODE    0.02585
+diodeModel::diodeModel( const diodeParams& params ) : nlModel( 1 ) {
+    setParams( params );
+}
 
-diodeModel::diodeModel() : nlModel( 1 ) {
+//----------------------------------------------------------------------
+void diodeModel::setParams( const diodeParams& params ) {
+    this->params = params;
+    const double VT = params.numSeries * params.VT;
+    oneOverVT = 1.0 / VT;
+    IsOverVT = params.Is / VT;
+}
 
+//----------------------------------------------------------------------
+const diodeParams& diodeModel::getParams( ) const {
+    return params;
+}
+
+//----------------------------------------------------------------------
+std::vector<double> diodeModel::getSignature( ) {
+    return { DIODE, params.Is, params.VT, (double)params.numSeries };
 }
 
 //----------------------------------------------------------------------
@@ -64,17 +126,22 @@ void diodeModel::calculate( vec* fNL,
                             int* currentPort ) {
 
     const double vd = (*x)(*currentPort);
-    const double arg1 = vd/VT_DIODE;
+    const double exp_arg1 = exp( vd * oneOverVT );
 
-    (*fNL)(*currentPort) = Is_DIODE*(exp(arg1)-1);
-    (*JNL)(*currentPort,*currentPort) = (Is_DIODE/VT_DIODE)*exp(arg1);
+    (*fNL)(*currentPort) = params.Is*(exp_arg1-1);
+    (*JNL)(*currentPort,*currentPort) = IsOverVT*exp_arg1;
 
     (*currentPort) = (*currentPort)+getNumPorts();
 }
 
 //==============================================================================
-diodeApModel::diodeApModel( ) : nlModel( 1 ) {
+diodeApModel::diodeApModel( const diodeParams& params ) : diodeModel( params ) {
+
+}
 
+//----------------------------------------------------------------------
+std::vector<double> diodeApModel::getSignature( ) {
+    return { DIODE_AP, params.Is, params.VT, (double)params.numSeries };
 }
 
 //----------------------------------------------------------------------
@@ -84,10 +151,12 @@ void diodeApModel::calculate( vec* fNL,
                               int* currentPort) {
 
     const double vd = (*x)(*currentPort);
-    const double arg1 = vd/VT_DIODE;
+    const double arg1 = vd * oneOverVT;
+    const double exp_arg1 = exp( arg1 );
+    const double exp_m_arg1 = exp( -arg1 );
 
-    (*fNL)(*currentPort) = Is_DIODE*(exp(arg1)-1)-Is_DIODE*(exp(-arg1)-1);
-    (*JNL)(*currentPort,*currentPort) = (Is_DIODE/VT_DIODE)*(exp(arg1)+exp(-arg1));
+    (*fNL)(*currentPort) = params.Is*(exp_arg1-exp_m_arg1);
+    (*JNL)(*currentPort,*currentPort) = IsOverVT*(exp_arg1+exp_m_arg1);
 
     (*currentPort) = (*currentPort)+getNumPorts();
 }
@@ -97,16 +166,38 @@ void diodeApModel::calculate( vec* fNL,
 // Transistor Models using Ebers-Moll equations
 // ("Large-signal behavior of junction transistors")
 //==============================================================================
-#define Is_BJT      5.911e-15
-#define VT_BJT      0.02585
-#define BETAF       1.434e3
-#define BETAR       1.262
-#define ALPHAF      (BETAF/(1.0+BETAF))     //TAKE CARE OF ( ) TO COMPILE CORRECTLY!!!!!! ARGHH!!
-#define ALPHAR      (BETAR/(1.0+BETAR))     //TAKE CARE OF ( ) TO COMPILE CORRECTLY!!!!!!
+npnEmModel::npnEmModel( const bjtParams& params ) : nlModel( 2 ),
+                                                     polarity( 1.0 ) {
+    setParams( params );
+}
 
+//----------------------------------------------------------------------
+void npnEmModel::setParams( const bjtParams& params ) {
+    this->params = params;
+    const double alphaF = params.betaF / ( 1.0 + params.betaF );
+    const double alphaR = params.betaR / ( 1.0 + params.betaR );
+    oneOverVT = 1.0 / params.VT;
+    IsOverVT = params.Is / params.VT;
+    IsOverAlphaR = params.Is / alphaR;
+    IsOverAlphaF = params.Is / alphaF;
+    IsOverAlphaRVT = IsOverAlphaR / params.VT;
+    IsOverAlphaFVT = IsOverAlphaF / params.VT;
+}
 
-npnEmModel::npnEmModel() : nlModel( 2 ) {
+//----------------------------------------------------------------------
+const bjtParams& npnEmModel::getParams( ) const {
+    return params;
+}
+
+//----------------------------------------------------------------------
+double npnEmModel::getPolarity( ) const {
+    return polarity;
+}
 
+//----------------------------------------------------------------------
+std::vector<double> npnEmModel::getSignature( ) {
+    return { (double)( ( polarity > 0 ) ? NPN_EM : PNP_EM ),
+             params.Is, params.VT, params.betaF, params.betaR };
 }
 
 //----------------------------------------------------------------------
@@ -115,35 +206,58 @@ void npnEmModel::calculate( vec* fNL,
                             vec* x,
                             int* currentPort) {
 
-    const double vBC = (*x)(*currentPort);
-    const double vBE = (*x)((*currentPort)+1);
+    const double vBC = polarity * (*x)(*currentPort);
+    const double vBE = polarity * (*x)((*currentPort)+1);
 
-    const double vBC_o_VT_BJT = vBC/VT_BJT;
-    const double vBE_o_VT_BJT = vBE/VT_BJT;
-    const double Is_BJT_o_VT_BJT = Is_BJT/VT_BJT;
-    const double Is_BJT_o_ALPHAR = Is_BJT/ALPHAR;
-    const double Is_BJT_o_ALPHAF = Is_BJT/ALPHAF;
+    const double exp_vBC_o_VT = exp( vBC * oneOverVT );
+    const double exp_vBE_o_VT = exp( vBE * oneOverVT );
+    const double Is = params.Is;
 
+    (*fNL)(*currentPort) = polarity*(-Is*(exp_vBE_o_VT-1)+IsOverAlphaR*(exp_vBC_o_VT-1));
+    (*JNL)((*currentPort),(*currentPort)) = IsOverAlphaRVT*exp_vBC_o_VT;
+    (*JNL)((*currentPort),((*currentPort)+1)) = -IsOverVT*exp_vBE_o_VT;
 
-    (*fNL)(*currentPort) = -Is_BJT*(exp(vBE_o_VT_BJT )-1)+(Is_BJT_o_ALPHAR)*(exp(vBC_o_VT_BJT)-1);
-    (*JNL)((*currentPort),(*currentPort)) = (Is_BJT_o_ALPHAR/VT_BJT)*exp(vBC_o_VT_BJT);
-    (*JNL)((*currentPort),((*currentPort)+1)) = (-Is_BJT_o_VT_BJT)*exp(vBE_o_VT_BJT );
-
-    (*fNL)((*currentPort)+1) = (Is_BJT_o_ALPHAF)*(exp(vBE_o_VT_BJT )-1)-Is_BJT*(exp(vBC_o_VT_BJT)-1);
-    (*JNL)(((*currentPort)+1),(*currentPort)) = (-Is_BJT_o_VT_BJT)*exp(vBC_o_VT_BJT);
-    (*JNL)(((*currentPort)+1),((*currentPort)+1)) = (Is_BJT_o_ALPHAF/VT_BJT)*exp(vBE_o_VT_BJT );
+    (*fNL)((*currentPort)+1) = polarity*(IsOverAlphaF*(exp_vBE_o_VT-1)-Is*(exp_vBC_o_VT-1));
+    (*JNL)(((*currentPort)+1),(*currentPort)) = -IsOverVT*exp_vBC_o_VT;
+    (*JNL)(((*currentPort)+1),((*currentPort)+1)) = IsOverAlphaFVT*exp_vBE_o_VT;
 
     (*currentPort) = (*currentPort)+getNumPorts();
 }
 
+//----------------------------------------------------------------------
+pnpEmModel::pnpEmModel( const bjtParams& params ) : npnEmModel( params ) {
+    polarity = -1.0;
+}
+
 
 //==============================================================================
 // Triode model according to Dempwolf et al
 // ("A physically-motivated triode model for circuit simulations")
 //==============================================================================
-triDwModel::triDwModel() : nlModel( 2 ) {
+triDwModel::triDwModel( const triodeParams& params ) : nlModel( 2 ) {
+    setParams( params );
+}
+
+//----------------------------------------------------------------------
+void triDwModel::setParams( const triodeParams& params ) {
+    this->params = params;
+    oneOverMu = 1.0 / params.mu;
+    oneOverC = 1.0 / params.C;
+    oneOverCg = 1.0 / params.Cg;
+    Ggamma = params.G * params.gamma;
+    GgammaOverMu = Ggamma / params.mu;
+    GgXi = params.Gg * params.xi;
+}
 
+//----------------------------------------------------------------------
+const triodeParams& triDwModel::getParams( ) const {
+    return params;
+}
 
+//----------------------------------------------------------------------
+std::vector<double> triDwModel::getSignature( ) {
+    return { TRI_DW, params.G, params.C, params.mu, params.gamma,
+             params.Gg, params.Cg, params.xi, params.Ig0 };
 }
 
 //----------------------------------------------------------------------
@@ -152,51 +266,827 @@ void triDwModel::calculate( vec* fNL,
                             vec* x,
                             int* currentPort) {
 
-    const double G = 2.242E-3;
-    const double C = 3.40;
-    const double mu = 103.2;
-    const double y = 1.26;
-
-    const double Gg = 6.177E-4;
-    const double Cg = 9.901;
-    const double E = 1.314;
-    const double Ig0 = 8.025E-8;
-
-    const double vAC_mu = (*x)(*currentPort) / mu;
+    const double vAC_mu = (*x)(*currentPort) * oneOverMu;
     const double vGC = (*x)((*currentPort)+1);
 
 
-    const double exp_Cg_vGC = exp( Cg * vGC );
-    const double log_1_exp_Cg_vGC_Cg = (log( 1 + exp_Cg_vGC ) / Cg);
+    const double exp_Cg_vGC = exp( params.Cg * vGC );
+    const double log_1_exp_Cg_vGC_Cg = log( 1 + exp_Cg_vGC ) * oneOverCg;
+    const double pow_log_1_exp_Cg_vGC_Cg_E_1 = pow( log_1_exp_Cg_vGC_Cg, (params.xi-1) );
 
 
     // Ig
-    (*fNL)((*currentPort)+1) = Gg * pow( log_1_exp_Cg_vGC_Cg, E ) + Ig0;
+    (*fNL)((*currentPort)+1) = params.Gg * pow_log_1_exp_Cg_vGC_Cg_E_1 * log_1_exp_Cg_vGC_Cg + params.Ig0;
 
     // dIg / dvAC
     (*JNL)(((*currentPort)+1),(*currentPort)) = 0;
     // dIg / dvGC
-    (*JNL)(((*currentPort)+1),((*currentPort)+1)) = ( Gg * E * exp_Cg_vGC *
-                                                      pow( log_1_exp_Cg_vGC_Cg, (E-1)) ) /
+    (*JNL)(((*currentPort)+1),((*currentPort)+1)) = ( GgXi * exp_Cg_vGC *
+                                                      pow_log_1_exp_Cg_vGC_Cg_E_1 ) /
                                                     (1 + exp_Cg_vGC);
 
 
-    const double exp_C_vAC_mu_vGC = exp( C * ( vAC_mu + vGC ));
-    const double pow_log_1_exp_C_vAC_mu_vGC_C_y_1 = pow( (log(1 + exp_C_vAC_mu_vGC) / C), (y-1));
+    const double exp_C_vAC_mu_vGC = exp( params.C * ( vAC_mu + vGC ));
+    const double log_1_exp_C_vAC_mu_vGC_C = log( 1 + exp_C_vAC_mu_vGC ) * oneOverC;
+    const double pow_log_1_exp_C_vAC_mu_vGC_C_y_1 = pow( log_1_exp_C_vAC_mu_vGC_C, (params.gamma-1) );
+    const double dIk_common = ( exp_C_vAC_mu_vGC * pow_log_1_exp_C_vAC_mu_vGC_C_y_1 ) /
+                              (1 + exp_C_vAC_mu_vGC);
 
     // Ik
-    (*fNL)(*currentPort) = G * pow( log( 1 + exp_C_vAC_mu_vGC ) / C , y ) - (*fNL)((*currentPort)+1);
+    (*fNL)(*currentPort) = params.G * pow_log_1_exp_C_vAC_mu_vGC_C_y_1 * log_1_exp_C_vAC_mu_vGC_C - (*fNL)((*currentPort)+1);
 
     // dIk / dvAC
-    (*JNL)((*currentPort),(*currentPort)) = ( G * y * exp_C_vAC_mu_vGC *
-                                              pow_log_1_exp_C_vAC_mu_vGC_C_y_1 ) /
-                                            (mu * (1 + exp_C_vAC_mu_vGC));
+    (*JNL)((*currentPort),(*currentPort)) = GgammaOverMu * dIk_common;
     // dIk / dvGC
-    (*JNL)((*currentPort),((*currentPort)+1)) = ( G * y * exp_C_vAC_mu_vGC *
-                                                  pow_log_1_exp_C_vAC_mu_vGC_C_y_1 ) /
-                                                (1 + exp_C_vAC_mu_vGC) - (*JNL)(((*currentPort)+1),((*currentPort)+1));
+    (*JNL)((*currentPort),((*currentPort)+1)) = Ggamma * dIk_common - (*JNL)(((*currentPort)+1),((*currentPort)+1));
+
+
+    (*currentPort) = (*currentPort)+getNumPorts();
+
+}
+
+
+//==============================================================================
+// Pentode model according to Koren
+// ("Improved VT models for SPICE simulations")
+// with the grid current of Dempwolf et al
+//==============================================================================
+pentodeKorenModel::pentodeKorenModel( const pentodeParams& params ) : nlModel( 3 ) {
+    setParams( params );
+}
+
+//----------------------------------------------------------------------
+void pentodeKorenModel::setParams( const pentodeParams& params ) {
+    this->params = params;
+    oneOverMu = 1.0 / params.mu;
+    oneOverKp = 1.0 / params.kp;
+    oneOverKvb = 1.0 / params.kvb;
+    oneOverCg = 1.0 / params.Cg;
+    twoOverKg1 = 2.0 / params.kg1;
+    oneOverKg2 = 1.0 / params.kg2;
+    GgXi = params.Gg * params.xi;
+}
+
+//----------------------------------------------------------------------
+const pentodeParams& pentodeKorenModel::getParams( ) const {
+    return params;
+}
+
+//----------------------------------------------------------------------
+std::vector<double> pentodeKorenModel::getSignature( ) {
+    return { PEN_KOREN, params.mu, params.ex, params.kg1, params.kg2,
+             params.kp, params.kvb, params.Gg, params.Cg, params.xi, params.Ig0 };
+}
+
+//----------------------------------------------------------------------
+void pentodeKorenModel::calculate( vec* fNL,
+                                   mat* JNL,
+                                   vec* x,
+                                   int* currentPort) {
+
+    const int pA = (*currentPort);
+    const int pG = (*currentPort)+1;
+    const int pS = (*currentPort)+2;
+
+    const double vAK = (*x)(pA);
+    const double vGK = (*x)(pG);
+    const double vSK = (*x)(pS);
+
+
+    // Ig, same as triDwModel
+    const double exp_Cg_vGK = exp( params.Cg * vGK );
+    const double log_1_exp_Cg_vGK_Cg = log( 1 + exp_Cg_vGK ) * oneOverCg;
+    const double pow_log_1_exp_Cg_vGK_Cg_E_1 = pow( log_1_exp_Cg_vGK_Cg, (params.xi-1) );
+
+    (*fNL)(pG) = params.Gg * pow_log_1_exp_Cg_vGK_Cg_E_1 * log_1_exp_Cg_vGK_Cg + params.Ig0;
+
+    (*JNL)(pG,pA) = 0;
+    (*JNL)(pG,pG) = ( GgXi * exp_Cg_vGK * pow_log_1_exp_Cg_vGK_Cg_E_1 ) /
+                    (1 + exp_Cg_vGK);
+    (*JNL)(pG,pS) = 0;
+
+
+    // Ia = 2 / kg1 * E1^ex * atan( vAK / kvb ), with
+    // E1 = vSK / kp * log( 1 + exp( kp * ( 1 / mu + vGK / vSK ) ) ).
+    // vSK is replaced by sqrt( kvb + vSK^2 ) inside the exponent, which
+    // keeps E1 smooth around vSK = 0 like Koren's triode equation does.
+    const double sqrt_kvb_vSK2 = sqrt( params.kvb + vSK * vSK );
+    const double exp_u = exp( params.kp * ( oneOverMu + vGK / sqrt_kvb_vSK2 ) );
+    const double log_1_exp_u = log( 1 + exp_u );
+    const double sigma_u = exp_u / ( 1 + exp_u );
+    const double E1 = vSK * oneOverKp * log_1_exp_u;
+
+    if( E1 > 0 ) {
+        const double atan_vAK = atan( vAK * oneOverKvb );
+        const double pow_E1_ex_1 = pow( E1, (params.ex-1) );
+        const double dIa_dE1 = twoOverKg1 * params.ex * pow_E1_ex_1 * atan_vAK;
+        const double dE1_dvGK = vSK * sigma_u / sqrt_kvb_vSK2;
+        const double dE1_dvSK = oneOverKp * log_1_exp_u -
+                                sigma_u * vGK * vSK * vSK /
+                                ( sqrt_kvb_vSK2 * sqrt_kvb_vSK2 * sqrt_kvb_vSK2 );
+
+        (*fNL)(pA) = twoOverKg1 * pow_E1_ex_1 * E1 * atan_vAK;
+        (*JNL)(pA,pA) = twoOverKg1 * pow_E1_ex_1 * E1 * oneOverKvb /
+                        ( 1 + vAK * vAK * oneOverKvb * oneOverKvb );
+        (*JNL)(pA,pG) = dIa_dE1 * dE1_dvGK;
+        (*JNL)(pA,pS) = dIa_dE1 * dE1_dvSK;
+    }
+    else {
+        (*fNL)(pA) = 0;
+        (*JNL)(pA,pA) = 0;
+        (*JNL)(pA,pG) = 0;
+        (*JNL)(pA,pS) = 0;
+    }
+
+
+    // Ig2 = ( vSK / mu + vGK )^ex / kg2
+    const double vS_eff = vSK * oneOverMu + vGK;
+
+    if( vS_eff > 0 ) {
+        const double pow_vS_eff_ex_1 = pow( vS_eff, (params.ex-1) );
+        const double dIg2_common = params.ex * pow_vS_eff_ex_1 * oneOverKg2;
+
+        (*fNL)(pS) = pow_vS_eff_ex_1 * vS_eff * oneOverKg2;
+        (*JNL)(pS,pA) = 0;
+        (*JNL)(pS,pG) = dIg2_common;
+        (*JNL)(pS,pS) = dIg2_common * oneOverMu;
+    }
+    else {
+        (*fNL)(pS) = 0;
+        (*JNL)(pS,pA) = 0;
+        (*JNL)(pS,pG) = 0;
+        (*JNL)(pS,pS) = 0;
+    }
+
+
+    (*currentPort) = (*currentPort)+getNumPorts();
+
+}
+
+
+//==============================================================================
+// Field effect transistor models according to Shichman and Hodges
+// ("Modeling and simulation of insulated-gate field-effect transistor
+// switching circuits")
+//==============================================================================
+fetShModel::fetShModel( double polarity ) : nlModel( 2 ),
+                                            polarity( polarity ),
+                                            VTO( 0 ),
+                                            k( 0 ),
+                                            lambda( 0 ),
+                                            IsGate( 0 ),
+                                            oneOverVT( 0 ),
+                                            IsOverVT( 0 ) {
+
+}
+
+//----------------------------------------------------------------------
+double fetShModel::getPolarity( ) const {
+    return polarity;
+}
+
+//----------------------------------------------------------------------
+void fetShModel::drainCurrent( double vDS,
+                               double vGS,
+                               double* id,
+                               double* gDS,
+                               double* gGS ) {
+
+    const double vGST = vGS - VTO;
+
+    if( vGST <= 0 ) {
+        // cutoff
+        *id = 0;
+        *gDS = 0;
+        *gGS = 0;
+    }
+    else if( vDS < vGST ) {
+        // linear region
+        const double clm = 1 + lambda * vDS;
+        const double vDS_2vGST_vDS = vDS * ( 2 * vGST - vDS );
+        *id = k * vDS_2vGST_vDS * clm;
+        *gDS = k * ( 2 * ( vGST - vDS ) * clm + lambda * vDS_2vGST_vDS );
+        *gGS = 2 * k * vDS * clm;
+    }
+    else {
+        // saturation
+        const double clm = 1 + lambda * vDS;
+        *id = k * vGST * vGST * clm;
+        *gDS = k * lambda * vGST * vGST;
+        *gGS = 2 * k * vGST * clm;
+    }
+}
+
+//----------------------------------------------------------------------
+void fetShModel::calculate( vec* fNL,
+                            mat* JNL,
+                            vec* x,
+                            int* currentPort) {
+
+    const double vDS = polarity * (*x)(*currentPort);
+    const double vGS = polarity * (*x)((*currentPort)+1);
+    const double vGD = vGS - vDS;
+
+    double iD;
+    double dID_dvDS;
+    double dID_dvGS;
+    if( vDS >= 0 ) {
+        drainCurrent( vDS, vGS, &iD, &dID_dvDS, &dID_dvGS );
+    }
+    else {
+        // source and drain swap roles
+        double gDS;
+        double gGS;
+        drainCurrent( -vDS, vGD, &iD, &gDS, &gGS );
+        iD = -iD;
+        dID_dvDS = gDS + gGS;
+        dID_dvGS = -gGS;
+    }
+
+    // gate junctions
+    const double exp_vGS_o_VT = exp( vGS * oneOverVT );
+    const double exp_vGD_o_VT = exp( vGD * oneOverVT );
+    const double iGS = IsGate * ( exp_vGS_o_VT - 1 );
+    const double iGD = IsGate * ( exp_vGD_o_VT - 1 );
+
+    // drain current
+    (*fNL)(*currentPort) = polarity * ( iD - iGD );
+    (*JNL)((*currentPort),(*currentPort)) = dID_dvDS + IsOverVT * exp_vGD_o_VT;
+    (*JNL)((*currentPort),((*currentPort)+1)) = dID_dvGS - IsOverVT * exp_vGD_o_VT;
+
+    // gate current
+    (*fNL)((*currentPort)+1) = polarity * ( iGS + iGD );
+    (*JNL)(((*currentPort)+1),(*currentPort)) = -IsOverVT * exp_vGD_o_VT;
+    (*JNL)(((*currentPort)+1),((*currentPort)+1)) = IsOverVT * ( exp_vGS_o_VT + exp_vGD_o_VT );
+
+    (*currentPort) = (*currentPort)+getNumPorts();
+}
 
+//----------------------------------------------------------------------
+jfetShModel::jfetShModel( double polarity,
+                          const jfetParams& params ) : fetShModel( polarity ) {
+    setParams( params );
+}
+
+//----------------------------------------------------------------------
+void jfetShModel::setParams( const jfetParams& params ) {
+    this->params = params;
+    VTO = params.VTO;
+    k = params.beta;
+    lambda = params.lambda;
+    IsGate = params.Is;
+    oneOverVT = 1.0 / params.VT;
+    IsOverVT = params.Is / params.VT;
+}
+
+//----------------------------------------------------------------------
+const jfetParams& jfetShModel::getParams( ) const {
+    return params;
+}
+
+//----------------------------------------------------------------------
+std::vector<double> jfetShModel::getSignature( ) {
+    return { (double)( ( polarity > 0 ) ? NJF_SH : PJF_SH ),
+             params.VTO, params.beta, params.lambda, params.Is, params.VT };
+}
+
+//----------------------------------------------------------------------
+mosfetShModel::mosfetShModel( double polarity,
+                              const mosfetParams& params ) : fetShModel( polarity ) {
+    setParams( params );
+}
+
+//----------------------------------------------------------------------
+void mosfetShModel::setParams( const mosfetParams& params ) {
+    this->params = params;
+    VTO = params.VTO;
+    k = 0.5 * params.beta;
+    lambda = params.lambda;
+}
+
+//----------------------------------------------------------------------
+const mosfetParams& mosfetShModel::getParams( ) const {
+    return params;
+}
+
+//----------------------------------------------------------------------
+std::vector<double> mosfetShModel::getSignature( ) {
+    return { (double)( ( polarity > 0 ) ? NMOS_SH : PMOS_SH ),
+             params.VTO, params.beta, params.lambda };
+}
+
+
+//==============================================================================
+// Op-amp macro model with a smoothly saturating output stage
+//==============================================================================
+opampSatModel::opampSatModel( const opampParams& params ) : nlModel( 2 ) {
+    setParams( params );
+}
+
+//----------------------------------------------------------------------
+void opampSatModel::setParams( const opampParams& params ) {
+    this->params = params;
+    center = 0.5 * ( params.Vpos + params.Vneg );
+    swing = 0.5 * ( params.Vpos - params.Vneg );
+    gainOverSwing = params.A / swing;
+    oneOverRout = 1.0 / params.Rout;
+    oneOverRin = 1.0 / params.Rin;
+}
+
+//----------------------------------------------------------------------
+const opampParams& opampSatModel::getParams( ) const {
+    return params;
+}
+
+//----------------------------------------------------------------------
+std::vector<double> opampSatModel::getSignature( ) {
+    return { OPAMP_SAT, params.A, params.Vpos, params.Vneg, params.Rout, params.Rin };
+}
+
+//----------------------------------------------------------------------
+void opampSatModel::calculate( vec* fNL,
+                               mat* JNL,
+                               vec* x,
+                               int* currentPort) {
+
+    const double vIn = (*x)(*currentPort);
+    const double vOut = (*x)((*currentPort)+1);
+
+    const double tanh_vIn = tanh( gainOverSwing * vIn );
+
+    // input current
+    (*fNL)(*currentPort) = vIn * oneOverRin;
+    (*JNL)((*currentPort),(*currentPort)) = oneOverRin;
+    (*JNL)((*currentPort),((*currentPort)+1)) = 0;
+
+    // output current
+    (*fNL)((*currentPort)+1) = ( vOut - center - swing * tanh_vIn ) * oneOverRout;
+    (*JNL)(((*currentPort)+1),(*currentPort)) = -params.A * ( 1 - tanh_vIn * tanh_vIn ) * oneOverRout;
+    (*JNL)(((*currentPort)+1),((*currentPort)+1)) = oneOverRout;
 
     (*currentPort) = (*currentPort)+getNumPorts();
+}
+
+
+//==============================================================================
+// Table-backed approximation of a non-linear model
+//==============================================================================
+nlTableModel::nlTableModel( nlModel* model,
+                            const std::vector<double>& xMin,
+                            const std::vector<double>& xMax,
+                            const std::vector<int>& numPoints,
+                            const std::string& cacheDirectory ) : nlModel( model->getNumPorts() ),
+                                                                  model( model ),
+                                                                  tableData( NULL ),
+                                                                  mappedData( NULL ),
+                                                                  mappedSize( 0 ),
+                                                                  numBuildThreads( 1 ) {
+    const int numPorts = getNumPorts( );
+    size_t nextStride = 1;
+    for( int d = 0; d < numPorts; d++ ) {
+        this->xMin[d] = xMin[d];
+        this->xMax[d] = xMax[d];
+        this->numPoints[d] = numPoints[d];
+        h[d] = ( xMax[d] - xMin[d] ) / ( numPoints[d] - 1 );
+        oneOverH[d] = 1.0 / h[d];
+        stride[d] = nextStride;
+        nextStride *= numPoints[d];
+    }
+    numDerivatives = 1 << numPorts;
 
+    // offsets of the table entries of a cell as they are used by
+    // interpolate(), relative to the first grid point of the cell
+    offsets[0] = 0;
+    int numWeights = 1;
+    for( int d = 0; d < numPorts; d++ ) {
+        for( int q = 3; q >= 0; q-- ) {
+            const size_t corner = ( q & 1 ) ? stride[d] * numDerivatives * numPorts : 0;
+            const size_t derivative = ( q & 2 ) ? ( 1 << d ) * numPorts : 0;
+            for( int j = 0; j < numWeights; j++ ) {
+                offsets[q*numWeights + j] = offsets[j] + corner + derivative;
+            }
+        }
+        numWeights *= 4;
+    }
+
+    const std::vector<double> signature = model->getSignature( );
+    if( cacheDirectory.empty() || signature.empty() ) {
+        buildTable( );
+        return;
+    }
+
+    // the file name is a hash of the description, the file holds the
+    // description itself so a collision is detected on loading
+    const std::vector<double> description = describeTable( signature );
+    uint64_t hash = 14695981039346656037ULL;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>( description.data() );
+    for( size_t i = 0; i < description.size() * sizeof( double ); i++ ) {
+        hash = ( hash ^ bytes[i] ) * 1099511628211ULL;
+    }
+    char name[64];
+    snprintf( name, sizeof( name ), "rtwdf-table-%016llx.bin", (unsigned long long)hash );
+    const std::string fileName = cacheDirectory + "/" + name;
+
+    if( loadCache( fileName, description ) == 0 ) {
+        return;
+    }
+    buildTable( );
+#if TABLE_USE_MMAP
+    if( storeCache( fileName, description ) == 0 && loadCache( fileName, description ) == 0 ) {
+        // share the new table with the instances that will map it later
+        std::vector<double>( ).swap( table );
+    }
+#else
+    storeCache( fileName, description );
+#endif
+}
+
+nlTableModel::~nlTableModel( ) {
+#if TABLE_USE_MMAP
+    if( mappedData != NULL ) {
+        munmap( mappedData, mappedSize );
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+nlModel* nlTableModel::getModel( ) {
+    return model.get( );
+}
+
+//----------------------------------------------------------------------
+bool nlTableModel::isMapped( ) const {
+    return mappedData != NULL;
+}
+
+//----------------------------------------------------------------------
+void nlTableModel::buildTable( ) {
+    const int numPorts = getNumPorts( );
+    size_t numNodes = 1;
+    for( int d = 0; d < numPorts; d++ ) {
+        numNodes *= numPoints[d];
+    }
+    table.assign( numNodes * numDerivatives * numPorts, 0.0 );
+    tableData = table.data( );
+
+    numBuildThreads = std::max( std::thread::hardware_concurrency(), 1u );
+    numBuildThreads = std::min( numBuildThreads, std::max( numNodes / TABLE_MIN_NODES_PER_THREAD, (size_t)1 ) );
+    if( numBuildThreads > 1 ) {
+        wdfThreadPool threadPool( numBuildThreads );
+        threadPool.run( &nlTableModel::buildTask, this );
+    }
+    else {
+        buildTask( this, 0 );
+    }
+
+    if( numPorts == 1 ) {
+        // Fritsch-Carlson limiting of the slopes, layout is f, df/dx per point
+        for( int k = 0; k + 1 < numPoints[0]; k++ ) {
+            double& mLeft = table[2*k + 1];
+            double& mRight = table[2*k + 3];
+            const double secant = ( table[2*k + 2] - table[2*k] ) * oneOverH[0];
+            if( secant == 0 ) {
+                mLeft = 0;
+                mRight = 0;
+                continue;
+            }
+            double alpha = mLeft / secant;
+            double beta = mRight / secant;
+            if( alpha < 0 ) {
+                mLeft = 0;
+                alpha = 0;
+            }
+            if( beta < 0 ) {
+                mRight = 0;
+                beta = 0;
+            }
+            const double radius2 = alpha * alpha + beta * beta;
+            if( radius2 > 9 ) {
+                const double tau = 3.0 / sqrt( radius2 );
+                mLeft = tau * alpha * secant;
+                mRight = tau * beta * secant;
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+//----------------------------------------------------------------------
+void nlTableModel::buildTask( void* context,
+                              size_t threadIndex ) {
+    nlTableModel* self = static_cast<nlTableModel*>( context );
+    const int numPorts = self->getNumPorts( );
+    size_t numNodes = 1;
+    for( int d = 0; d < numPorts; d++ ) {
+        numNodes *= self->numPoints[d];
+    }
+    const size_t firstNode = numNodes * threadIndex / self->numBuildThreads;
+    const size_t endNode = numNodes * ( threadIndex+1 ) / self->numBuildThreads;
+
+    vec x( numPorts );
+    vec xs( numPorts );
+    vec f( numPorts );
+    mat J( numPorts, numPorts );
+    for( size_t node = firstNode; node < endNode; node++ ) {
+        size_t rest = node;
+        for( int d = 0; d < numPorts; d++ ) {
+            x( d ) = self->xMin[d] + ( rest % self->numPoints[d] ) * self->h[d];
+            rest /= self->numPoints[d];
+        }
+        double* values = &self->table[node * self->numDerivatives * numPorts];
+
+        int port = 0;
+        self->model->calculate( &f, &J, &x, &port );
+        for( int i = 0; i < numPorts; i++ ) {
+            values[i] = f( i );
+        }
+
+        for( int mask = 1; mask < self->numDerivatives; mask++ ) {
+            // the lowest port of the subset is differentiated exactly by
+            // the Jacobian, the others by central differences of it
+            int first = 0;
+            while( !( mask & ( 1 << first ) ) ) {
+                first++;
+            }
+            const int others = mask & ~( 1 << first );
+            double* derivative = &values[mask * numPorts];
+
+            if( others == 0 ) {
+                for( int i = 0; i < numPorts; i++ ) {
+                    derivative[i] = J( i, first );
+                }
+                continue;
+            }
+
+            int numOthers = 0;
+            double divisor = 1.0;
+            for( int d = 0; d < numPorts; d++ ) {
+                if( others & ( 1 << d ) ) {
+                    numOthers++;
+                    divisor *= 2.0 * TABLE_FD_STEP * self->h[d];
+                }
+            }
+            for( int signs = 0; signs < ( 1 << numOthers ); signs++ ) {
+                double weight = 1.0;
+                int bit = 0;
+                for( int d = 0; d < numPorts; d++ ) {
+                    xs( d ) = x( d );
+                    if( others & ( 1 << d ) ) {
+                        if( signs & ( 1 << bit ) ) {
+                            xs( d ) += TABLE_FD_STEP * self->h[d];
+                        }
+                        else {
+                            xs( d ) -= TABLE_FD_STEP * self->h[d];
+                            weight = -weight;
+                        }
+                        bit++;
+                    }
+                }
+                port = 0;
+                self->model->calculate( &f, &J, &xs, &port );
+                for( int i = 0; i < numPorts; i++ ) {
+                    derivative[i] += weight * J( i, first ) / divisor;
+                }
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+std::vector<double> nlTableModel::describeTable( const std::vector<double>& signature ) {
+    const int numPorts = getNumPorts( );
+    std::vector<double> description;
+    description.push_back( TABLE_CACHE_VERSION );
+    description.push_back( TABLE_FD_STEP );
+    description.push_back( numPorts );
+    for( int d = 0; d < numPorts; d++ ) {
+        description.push_back( xMin[d] );
+        description.push_back( xMax[d] );
+        description.push_back( numPoints[d] );
+    }
+    description.insert( description.end(), signature.begin(), signature.end() );
+    return description;
+}
+
+//----------------------------------------------------------------------
+int nlTableModel::loadCache( const std::string& fileName,
+                             const std::vector<double>& description ) {
+    // layout: magic, number of description values, number of table
+    // values, description, table
+    const int numPorts = getNumPorts( );
+    size_t numValues = numDerivatives * numPorts;
+    for( int d = 0; d < numPorts; d++ ) {
+        numValues *= numPoints[d];
+    }
+    const size_t headerSize = 3 * sizeof( uint64_t );
+    const size_t descriptionSize = description.size() * sizeof( double );
+    const size_t fileSize = headerSize + descriptionSize + numValues * sizeof( double );
+
+#if TABLE_USE_MMAP
+    const int fd = open( fileName.c_str(), O_RDONLY );
+    if( fd < 0 ) {
+        return -1;
+    }
+    struct stat info;
+    if( fstat( fd, &info ) != 0 || (size_t)info.st_size != fileSize ) {
+        close( fd );
+        return -1;
+    }
+    void* mapped = mmap( NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+    if( mapped == MAP_FAILED ) {
+        return -1;
+    }
+    const unsigned char* data = static_cast<const unsigned char*>( mapped );
+#else
+    std::ifstream stream( fileName.c_str(), std::ios::binary | std::ios::ate );
+    if( !stream || (size_t)stream.tellg() != fileSize ) {
+        return -1;
+    }
+    stream.seekg( 0 );
+    std::vector<unsigned char> buffer( headerSize + descriptionSize );
+    stream.read( reinterpret_cast<char*>( buffer.data() ), buffer.size() );
+    const unsigned char* data = buffer.data( );
+#endif
+
+    uint64_t header[3];
+    memcpy( header, data, headerSize );
+    if( header[0] != TABLE_CACHE_MAGIC || header[1] != description.size() ||
+        header[2] != numValues ||
+        memcmp( data + headerSize, description.data(), descriptionSize ) != 0 ) {
+#if TABLE_USE_MMAP
+        munmap( mapped, fileSize );
+#endif
+        return -1;
+    }
+
+#if TABLE_USE_MMAP
+    if( mappedData != NULL ) {
+        munmap( mappedData, mappedSize );
+    }
+    mappedData = mapped;
+    mappedSize = fileSize;
+    tableData = reinterpret_cast<const double*>( data + headerSize + descriptionSize );
+#else
+    table.resize( numValues );
+    stream.read( reinterpret_cast<char*>( table.data() ), numValues * sizeof( double ) );
+    if( !stream ) {
+        return -1;
+    }
+    tableData = table.data( );
+#endif
+    return 0;
+}
+
+//----------------------------------------------------------------------
+int nlTableModel::storeCache( const std::string& fileName,
+                              const std::vector<double>& description ) {
+    // unique per instance and time, so concurrent writers don't collide
+    const std::string tempName = fileName + "." +
+        std::to_string( (unsigned long long)(uintptr_t)this ) + "-" +
+        std::to_string( (long long)std::chrono::steady_clock::now().time_since_epoch().count() ) + ".tmp";
+
+    const uint64_t header[3] = { TABLE_CACHE_MAGIC, description.size(), table.size() };
+    std::ofstream stream( tempName.c_str(), std::ios::binary );
+    stream.write( reinterpret_cast<const char*>( header ), sizeof( header ) );
+    stream.write( reinterpret_cast<const char*>( description.data() ), description.size() * sizeof( double ) );
+    stream.write( reinterpret_cast<const char*>( table.data() ), table.size() * sizeof( double ) );
+    stream.close( );
+    if( !stream ) {
+        std::remove( tempName.c_str() );
+        return -1;
+    }
+
+    // another process may have stored the same table in the meantime,
+    // both files are identical then
+    if( std::rename( tempName.c_str(), fileName.c_str() ) != 0 ) {
+        std::remove( tempName.c_str() );
+        std::ifstream existing( fileName.c_str() );
+        return existing.is_open() ? 0 : -1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+template<int N>
+void nlTableModel::interpolate( const double* xIn,
+                                double* f,
+                                double J[][TABLE_MAX_PORTS] ) {
+
+    // cubic Hermite basis functions of each port and their derivatives,
+    // ordered (corner, derivative) = (0,0), (1,0), (0,1), (1,1)
+    double b[N][4];
+    double db[N][4];
+    size_t base = 0;
+    for( int d = 0; d < N; d++ ) {
+        const double u = ( xIn[d] - xMin[d] ) * oneOverH[d];
+        int cell = (int)u;
+        if( cell > numPoints[d] - 2 ) {
+            cell = numPoints[d] - 2;
+        }
+        base += cell * stride[d];
+
+        const double t = u - cell;
+        const double t2 = t * t;
+        const double t3 = t2 * t;
+        const double h00 = 2*t3 - 3*t2 + 1;
+        const double dh00 = ( 6*t2 - 6*t ) * oneOverH[d];
+        b[d][0] = h00;
+        b[d][1] = 1 - h00;
+        b[d][2] = ( t3 - 2*t2 + t ) * h[d];
+        b[d][3] = ( t3 - t2 ) * h[d];
+        db[d][0] = dh00;
+        db[d][1] = -dh00;
+        db[d][2] = 3*t2 - 4*t + 1;
+        db[d][3] = 3*t2 - 2*t;
+    }
+
+    // the table entries of the cell are indexed by the base-4 digits of
+    // their position in offsets[], one digit per port. The ports are
+    // interpolated one after the other starting with the last one, which
+    // reduces the entries to a quarter each time. Derivatives with respect
+    // to the ports that are already interpolated are carried along.
+    const double* cell = tableData + base * ( 1 << N ) * N;
+    const int numFirst = 1 << 2*(N-1);
+    double val[1 << 2*(N-1)][N];
+    double grad[1 << 2*(N-1)][N][N];
+    for( int j = 0; j < numFirst; j++ ) {
+        const double* v0 = cell + offsets[j];
+        const double* v1 = cell + offsets[j + numFirst];
+        const double* v2 = cell + offsets[j + 2*numFirst];
+        const double* v3 = cell + offsets[j + 3*numFirst];
+        for( int i = 0; i < N; i++ ) {
+            val[j][i] = b[N-1][0] * v0[i] + b[N-1][1] * v1[i] +
+                        b[N-1][2] * v2[i] + b[N-1][3] * v3[i];
+            grad[j][i][N-1] = db[N-1][0] * v0[i] + db[N-1][1] * v1[i] +
+                              db[N-1][2] * v2[i] + db[N-1][3] * v3[i];
+        }
+    }
+
+    int numEntries = numFirst;
+    for( int d = N-2; d >= 0; d-- ) {
+        numEntries /= 4;
+        for( int j = 0; j < numEntries; j++ ) {
+            const int j1 = j + numEntries;
+            const int j2 = j + 2*numEntries;
+            const int j3 = j + 3*numEntries;
+            for( int i = 0; i < N; i++ ) {
+                for( int k = d+1; k < N; k++ ) {
+                    grad[j][i][k] = b[d][0] * grad[j][i][k] + b[d][1] * grad[j1][i][k] +
+                                    b[d][2] * grad[j2][i][k] + b[d][3] * grad[j3][i][k];
+                }
+                grad[j][i][d] = db[d][0] * val[j][i] + db[d][1] * val[j1][i] +
+                                db[d][2] * val[j2][i] + db[d][3] * val[j3][i];
+                val[j][i] = b[d][0] * val[j][i] + b[d][1] * val[j1][i] +
+                            b[d][2] * val[j2][i] + b[d][3] * val[j3][i];
+            }
+        }
+    }
+
+    for( int i = 0; i < N; i++ ) {
+        f[i] = val[0][i];
+        for( int k = 0; k < N; k++ ) {
+            J[i][k] = grad[0][i][k];
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+void nlTableModel::calculate( vec* fNL,
+                              mat* JNL,
+                              vec* x,
+                              int* currentPort) {
+
+    const int numPorts = getNumPorts( );
+    const int firstPort = (*currentPort);
+
+    double xIn[TABLE_MAX_PORTS] = { 0 };
+    for( int d = 0; d < numPorts; d++ ) {
+        xIn[d] = (*x)( firstPort + d );
+        if( !( xIn[d] >= xMin[d] && xIn[d] <= xMax[d] ) ) {
+            model->calculate( fNL, JNL, x, currentPort );
+            return;
+        }
+    }
+
+    double f[TABLE_MAX_PORTS];
+    double J[TABLE_MAX_PORTS][TABLE_MAX_PORTS];
+    if( numPorts == 1 ) {
+        interpolate<1>( xIn, f, J );
+    }
+    else if( numPorts == 2 ) {
+        interpolate<2>( xIn, f, J );
+    }
+    else {
+        interpolate<3>( xIn, f, J );
+    }
+
+    for( int i = 0; i < numPorts; i++ ) {
+        (*fNL)( firstPort + i ) = f[i];
+        for( int k = 0; k < numPorts; k++ ) {
+            (*JNL)( firstPort + i, firstPort + k ) = J[i][k];
+        }
+    }
+
+    (*currentPort) = (*currentPort)+getNumPorts();
 }
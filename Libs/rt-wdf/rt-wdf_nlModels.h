@@ -30,6 +30,10 @@
 #define RTWDF_NLMODELS_H_INCLUDED
 
 //==============================================================================
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "rt-wdf_types.h"
 
 //==============================================================================
@@ -46,10 +50,238 @@
 // Bipolar Transistors:
 /** Enum to specify Ebers-Moll bipolar npn-transistor model in wdfRootNL */
 #define NPN_EM      10
+/** Enum to specify Ebers-Moll bipolar pnp-transistor model in wdfRootNL */
+#define PNP_EM      11
 
-// Triode Tubes:
+// Tubes:
 /** Enum to specify Dempwolf triode tube model in wdfRootNL */
 #define TRI_DW      20
+/** Enum to specify Koren pentode tube model in wdfRootNL */
+#define PEN_KOREN   21
+
+// Field Effect Transistors:
+/** Enum to specify Shichman-Hodges n-channel JFET model in wdfRootNL */
+#define NJF_SH      30
+/** Enum to specify Shichman-Hodges p-channel JFET model in wdfRootNL */
+#define PJF_SH      31
+/** Enum to specify Shichman-Hodges n-channel MOSFET model in wdfRootNL */
+#define NMOS_SH     40
+/** Enum to specify Shichman-Hodges p-channel MOSFET model in wdfRootNL */
+#define PMOS_SH     41
+
+// Operational Amplifiers:
+/** Enum to specify saturating op-amp macro model in wdfRootNL */
+#define OPAMP_SAT   50
+
+
+//==============================================================================
+// Model parameters
+
+// Diode model according to Kurt Werner et al:
+/** Saturation current of the diode models */
+#define Is_DIODE    2.52e-9
+/** Thermal voltage of the diode models */
+#define VT_DIODE    0.02585
+
+// Ebers-Moll transistor model:
+/** Saturation current of the npn-transistor model */
+#define Is_BJT      5.911e-15
+/** Thermal voltage of the npn-transistor model */
+#define VT_BJT      0.02585
+/** Forward current gain of the npn-transistor model */
+#define BETAF       1.434e3
+/** Reverse current gain of the npn-transistor model */
+#define BETAR       1.262
+#define ALPHAF      (BETAF/(1.0+BETAF))     //TAKE CARE OF ( ) TO COMPILE CORRECTLY!!!!!! ARGHH!!
+#define ALPHAR      (BETAR/(1.0+BETAR))     //TAKE CARE OF ( ) TO COMPILE CORRECTLY!!!!!!
+
+// Dempwolf triode model:
+/** Plate current: perveance G */
+#define G_TRI       2.242E-3
+/** Plate current: adaption factor C */
+#define C_TRI       3.40
+/** Plate current: amplification factor mu */
+#define MU_TRI      103.2
+/** Plate current: exponent gamma */
+#define Y_TRI       1.26
+/** Grid current: perveance Gg */
+#define GG_TRI      6.177E-4
+/** Grid current: adaption factor Cg */
+#define CG_TRI      9.901
+/** Grid current: exponent xi */
+#define E_TRI       1.314
+/** Grid current: offset current Ig0 */
+#define IG0_TRI     8.025E-8
+
+// Koren pentode model (EL34):
+/** Amplification factor mu */
+#define MU_PEN      11.0
+/** Exponent x */
+#define EX_PEN      1.35
+/** Plate current divisor kg1 */
+#define KG1_PEN     650.0
+/** Screen current divisor kg2 */
+#define KG2_PEN     4200.0
+/** Adaption factor kp */
+#define KP_PEN      60.0
+/** Knee voltage kvb */
+#define KVB_PEN     24.0
+
+// Shichman-Hodges JFET model (2N5457), n-channel convention:
+/** Threshold (pinch-off) voltage */
+#define VTO_JFET    -1.372
+/** Transconductance parameter beta */
+#define BETA_JFET   1.125e-3
+/** Channel length modulation lambda */
+#define LAMBDA_JFET 2.3e-3
+/** Saturation current of the gate junctions */
+#define Is_JFET     181.3e-15
+/** Thermal voltage of the gate junctions */
+#define VT_JFET     0.02585
+
+// Shichman-Hodges (level 1) MOSFET model, n-channel convention:
+/** Threshold voltage */
+#define VTO_MOS     2.0
+/** Transconductance parameter beta = KP * W / L */
+#define BETA_MOS    0.1
+/** Channel length modulation lambda */
+#define LAMBDA_MOS  0.01
+
+// Op-amp macro model:
+/** Open loop gain */
+#define A_OPAMP     1.0e5
+/** Positive and negative output saturation voltage */
+#define VPOS_OPAMP  13.5
+#define VNEG_OPAMP  -13.5
+/** Output resistance */
+#define ROUT_OPAMP  75.0
+/** Input resistance */
+#define RIN_OPAMP   1.0e12
+
+
+//==============================================================================
+// Table model config parameters
+
+/** maximum number of ports of a model that nlTableModel can tabulate */
+#define TABLE_MAX_PORTS     3
+/** number of table entries that contribute to a point, 4^TABLE_MAX_PORTS */
+#define TABLE_NUM_WEIGHTS   64
+/** step of the finite differences for the mixed derivatives of nlTableModel,
+    relative to the grid spacing */
+#define TABLE_FD_STEP       1.0e-3
+/** minimum number of grid points per thread when a table is generated */
+#define TABLE_MIN_NODES_PER_THREAD  4096
+/** version of the table cache files, increment if the table layout or its
+    generation changes */
+#define TABLE_CACHE_VERSION 1
+
+
+//==============================================================================
+// Per-instance model parameters, initialized with the defaults above
+
+/** Parameters of diodeModel and diodeApModel */
+typedef struct diodeParams {
+    /** saturation current Is */
+    double Is = Is_DIODE;
+    /** emission coefficient times thermal voltage n*VT */
+    double VT = VT_DIODE;
+    /** number of identical diodes in series (per direction) in the port */
+    int numSeries = 1;
+} diodeParams;
+
+/** Parameters of npnEmModel */
+typedef struct bjtParams {
+    /** saturation current Is */
+    double Is = Is_BJT;
+    /** thermal voltage VT */
+    double VT = VT_BJT;
+    /** forward current gain betaF */
+    double betaF = BETAF;
+    /** reverse current gain betaR */
+    double betaR = BETAR;
+} bjtParams;
+
+/** Parameters of triDwModel */
+typedef struct triodeParams {
+    /** plate current: perveance G */
+    double G = G_TRI;
+    /** plate current: adaption factor C */
+    double C = C_TRI;
+    /** plate current: amplification factor mu */
+    double mu = MU_TRI;
+    /** plate current: exponent gamma */
+    double gamma = Y_TRI;
+    /** grid current: perveance Gg */
+    double Gg = GG_TRI;
+    /** grid current: adaption factor Cg */
+    double Cg = CG_TRI;
+    /** grid current: exponent xi */
+    double xi = E_TRI;
+    /** grid current: offset current Ig0 */
+    double Ig0 = IG0_TRI;
+} triodeParams;
+
+/** Parameters of pentodeKorenModel */
+typedef struct pentodeParams {
+    /** plate current: amplification factor mu */
+    double mu = MU_PEN;
+    /** plate and screen current: exponent x */
+    double ex = EX_PEN;
+    /** plate current: divisor kg1 */
+    double kg1 = KG1_PEN;
+    /** screen current: divisor kg2 */
+    double kg2 = KG2_PEN;
+    /** plate current: adaption factor kp */
+    double kp = KP_PEN;
+    /** plate current: knee voltage kvb */
+    double kvb = KVB_PEN;
+    /** grid current: perveance Gg (Dempwolf) */
+    double Gg = GG_TRI;
+    /** grid current: adaption factor Cg (Dempwolf) */
+    double Cg = CG_TRI;
+    /** grid current: exponent xi (Dempwolf) */
+    double xi = E_TRI;
+    /** grid current: offset current Ig0 (Dempwolf) */
+    double Ig0 = IG0_TRI;
+} pentodeParams;
+
+/** Parameters of jfetShModel in the n-channel convention */
+typedef struct jfetParams {
+    /** threshold (pinch-off) voltage VTO, negative for depletion devices */
+    double VTO = VTO_JFET;
+    /** transconductance parameter beta */
+    double beta = BETA_JFET;
+    /** channel length modulation lambda */
+    double lambda = LAMBDA_JFET;
+    /** saturation current Is of the gate junctions */
+    double Is = Is_JFET;
+    /** thermal voltage VT of the gate junctions */
+    double VT = VT_JFET;
+} jfetParams;
+
+/** Parameters of mosfetShModel in the n-channel convention */
+typedef struct mosfetParams {
+    /** threshold voltage VTO, positive for enhancement devices */
+    double VTO = VTO_MOS;
+    /** transconductance parameter beta = KP * W / L */
+    double beta = BETA_MOS;
+    /** channel length modulation lambda */
+    double lambda = LAMBDA_MOS;
+} mosfetParams;
+
+/** Parameters of opampSatModel */
+typedef struct opampParams {
+    /** open loop gain A */
+    double A = A_OPAMP;
+    /** positive output saturation voltage */
+    double Vpos = VPOS_OPAMP;
+    /** negative output saturation voltage */
+    double Vneg = VNEG_OPAMP;
+    /** output resistance Rout */
+    double Rout = ROUT_OPAMP;
+    /** input resistance Rin */
+    double Rin = RIN_OPAMP;
+} opampParams;
 
 
 
@@ -58,8 +290,15 @@
 class nlModel;
 class diodeModel;
 class diodeApModel;
-class bjtEmModel;
+class npnEmModel;
+class pnpEmModel;
 class triDwModel;
+class pentodeKorenModel;
+class fetShModel;
+class jfetShModel;
+class mosfetShModel;
+class opampSatModel;
+class nlTableModel;
 
 
 
@@ -111,6 +350,28 @@ public:
     */
     int getNumPorts( );
 
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of ports of a model enum without creating the
+     model, e.g. to size a solver before it is set up.
+
+     @param modelType           model enum as defined above (DIODE, NPN_EM..)
+     @returns                   the number of ports of that model, 0 for
+                                unknown enums
+    */
+    static int getNumPorts( int modelType );
+
+    //----------------------------------------------------------------------
+    /**
+     Describes the model by its enum and its parameters, e.g. to find a
+     cached table of it (see nlTableModel). Returns an empty vector if not
+     overwritten by a method in a subclass: the model can't be identified
+     and its tables are never cached.
+
+     @returns                   the model enum followed by all parameters
+    */
+    virtual std::vector<double> getSignature( );
+
 private:
     //----------------------------------------------------------------------
     /** Stores the number of ports of a model */
@@ -122,6 +383,15 @@ private:
 //==============================================================================
 class diodeModel : public nlModel {
 
+protected:
+    //----------------------------------------------------------------------
+    /** Parameters of the diode */
+    diodeParams params;
+    /** 1 / (numSeries * n*VT) */
+    double oneOverVT;
+    /** Is / (numSeries * n*VT) */
+    double IsOverVT;
+
 public:
     //----------------------------------------------------------------------
     /**
@@ -129,8 +399,38 @@ public:
 
      Single Diode Model according to Kurt Werner et al
      ("An Improved and Generalized Diode Clipper Model for Wave Digital Filters")
+
+     A string of numSeries identical diodes carries the same current and
+     splits the port voltage evenly, so it is folded into the one port by
+     scaling n*VT.
+
+     @param params              parameters of the diode
+    */
+    diodeModel( const diodeParams& params = diodeParams( ) );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets new parameters and precomputes the derived constants.
+
+     @param params              parameters of the diode
     */
-    diodeModel( );
+    void setParams( const diodeParams& params );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the parameters of the diode.
+
+     @returns                   the current parameters
+    */
+    const diodeParams& getParams( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the model enum and the parameters, see nlModel::getSignature().
+
+     @returns                   DIODE followed by the parameters
+    */
+    std::vector<double> getSignature( );
 
     //----------------------------------------------------------------------
     /**
@@ -155,7 +455,7 @@ public:
 
 
 //==============================================================================
-class diodeApModel : public nlModel {
+class diodeApModel : public diodeModel {
 
 public:
     //----------------------------------------------------------------------
@@ -164,8 +464,21 @@ public:
 
      Anti-Parallel Diode Model according to Kurt Werner et al
      ("An Improved and Generalized Diode Clipper Model for Wave Digital Filters")
+
+     Both directions use the same parameters, numSeries counts the diodes
+     in series per direction.
+
+     @param params              parameters of each diode
+    */
+    diodeApModel( const diodeParams& params = diodeParams( ) );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the model enum and the parameters, see nlModel::getSignature().
+
+     @returns                   DIODE_AP followed by the parameters
     */
-    diodeApModel();
+    std::vector<double> getSignature( );
 
     //----------------------------------------------------------------------
     /**
@@ -192,6 +505,23 @@ public:
 //==============================================================================
 class npnEmModel : public nlModel {
 
+protected:
+    //----------------------------------------------------------------------
+    /** Parameters of the transistor */
+    bjtParams params;
+    /** 1 / VT */
+    double oneOverVT;
+    /** Is / VT */
+    double IsOverVT;
+    /** Is / alphaR and Is / alphaF */
+    double IsOverAlphaR;
+    double IsOverAlphaF;
+    /** Is / (alphaR * VT) and Is / (alphaF * VT) */
+    double IsOverAlphaRVT;
+    double IsOverAlphaFVT;
+    /** 1 for npn, -1 for pnp: all voltages and currents are mirrored */
+    double polarity;
+
 public:
     //----------------------------------------------------------------------
     /**
@@ -199,8 +529,42 @@ public:
 
      Transistor Models using Ebers-Moll equations
      ("Large-signal behavior of junction transistors")
+
+     @param params              parameters of the transistor
+    */
+    npnEmModel( const bjtParams& params = bjtParams( ) );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets new parameters and precomputes the derived constants.
+
+     @param params              parameters of the transistor
     */
-    npnEmModel();
+    void setParams( const bjtParams& params );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the parameters of the transistor.
+
+     @returns                   the current parameters
+    */
+    const bjtParams& getParams( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the model enum and the parameters, see nlModel::getSignature().
+
+     @returns                   NPN_EM or PNP_EM followed by the parameters
+    */
+    std::vector<double> getSignature( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the polarity of the transistor.
+
+     @returns                   1 for npn, -1 for pnp
+    */
+    double getPolarity( ) const;
 
     //----------------------------------------------------------------------
     /**
@@ -224,9 +588,42 @@ public:
 };
 
 
+//==============================================================================
+class pnpEmModel : public npnEmModel {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Ebers-Moll pnp-transistor model class.
+
+     Mirrors the npn model: the ports are the same (base -> collector,
+     base -> emitter) and the parameters are the ones of the equivalent npn
+     transistor, all port voltages and currents change their sign.
+
+     @param params              parameters of the transistor
+    */
+    pnpEmModel( const bjtParams& params = bjtParams( ) );
+
+};
+
+
 //==============================================================================
 class triDwModel : public nlModel {
 
+protected:
+    //----------------------------------------------------------------------
+    /** Parameters of the triode */
+    triodeParams params;
+    /** 1 / mu, 1 / C and 1 / Cg */
+    double oneOverMu;
+    double oneOverC;
+    double oneOverCg;
+    /** G * gamma and G * gamma / mu */
+    double Ggamma;
+    double GgammaOverMu;
+    /** Gg * xi */
+    double GgXi;
+
 public:
     //----------------------------------------------------------------------
     /**
@@ -234,8 +631,561 @@ public:
 
      Triode model according to Dempwolf et al
      ("A physically-motivated triode model for circuit simulations")
+
+     @param params              parameters of the triode
+    */
+    triDwModel( const triodeParams& params = triodeParams( ) );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets new parameters and precomputes the derived constants.
+
+     @param params              parameters of the triode
+    */
+    void setParams( const triodeParams& params );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the parameters of the triode.
+
+     @returns                   the current parameters
+    */
+    const triodeParams& getParams( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the model enum and the parameters, see nlModel::getSignature().
+
+     @returns                   TRI_DW followed by the parameters
+    */
+    std::vector<double> getSignature( );
+
+    //----------------------------------------------------------------------
+    /**
+     Calculate the non-linear current and it's Jacobian according to an
+     input voltage.
+
+     @param *fNL             is a pointer to store result of fNL(x).
+                             This is a current.
+     @param *JNL             is a pointer to store the result of the
+                             Jacobian of fNL(x).
+     @param *x               is a pointer to read the input value x.
+                             This is a voltage.
+     @param *currentPort     is a pointer to the first reading /
+                             writing position in fNL, JNL and x.
+    */
+    void calculate( vec* fNL,
+                    mat* JNL,
+                    vec* x,
+                    int* currentPort );
+
+};
+
+
+
+//==============================================================================
+class pentodeKorenModel : public nlModel {
+
+protected:
+    //----------------------------------------------------------------------
+    /** Parameters of the pentode */
+    pentodeParams params;
+    /** 1 / mu, 1 / kp, 1 / kvb and 1 / Cg */
+    double oneOverMu;
+    double oneOverKp;
+    double oneOverKvb;
+    double oneOverCg;
+    /** 2 / kg1 and 1 / kg2 */
+    double twoOverKg1;
+    double oneOverKg2;
+    /** Gg * xi */
+    double GgXi;
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Pentode tube model class.
+
+     Plate and screen current according to Koren
+     ("Improved VT models for SPICE simulations"), grid current like
+     triDwModel according to Dempwolf et al. The ports are
+     anode -> cathode, grid -> cathode and screen -> cathode.
+
+     @param params              parameters of the pentode
+    */
+    pentodeKorenModel( const pentodeParams& params = pentodeParams( ) );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets new parameters and precomputes the derived constants.
+
+     @param params              parameters of the pentode
+    */
+    void setParams( const pentodeParams& params );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the parameters of the pentode.
+
+     @returns                   the current parameters
+    */
+    const pentodeParams& getParams( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the model enum and the parameters, see nlModel::getSignature().
+
+     @returns                   PEN_KOREN followed by the parameters
+    */
+    std::vector<double> getSignature( );
+
+    //----------------------------------------------------------------------
+    /**
+     Calculate the non-linear current and it's Jacobian according to an
+     input voltage.
+
+     @param *fNL             is a pointer to store result of fNL(x).
+                             This is a current.
+     @param *JNL             is a pointer to store the result of the
+                             Jacobian of fNL(x).
+     @param *x               is a pointer to read the input value x.
+                             This is a voltage.
+     @param *currentPort     is a pointer to the first reading /
+                             writing position in fNL, JNL and x.
+    */
+    void calculate( vec* fNL,
+                    mat* JNL,
+                    vec* x,
+                    int* currentPort );
+
+};
+
+
+//==============================================================================
+class fetShModel : public nlModel {
+
+protected:
+    //----------------------------------------------------------------------
+    /** 1 for n-channel, -1 for p-channel devices */
+    double polarity;
+    /** threshold voltage in the n-channel convention */
+    double VTO;
+    /** beta for JFETs, beta / 2 for MOSFETs */
+    double k;
+    /** channel length modulation */
+    double lambda;
+    /** saturation current of the gate junctions, 0 for an insulated gate */
+    double IsGate;
+    /** 1 / VT and Is / VT of the gate junctions */
+    double oneOverVT;
+    double IsOverVT;
+
+    //----------------------------------------------------------------------
+    /**
+     Drain current of the n-channel device for vDS >= 0 and its
+     derivatives.
+
+     @param vDS                 drain source voltage, >= 0
+     @param vGS                 gate source voltage
+     @param *id                 is a pointer to store the drain current
+     @param *gDS                is a pointer to store d id / d vDS
+     @param *gGS                is a pointer to store d id / d vGS
+    */
+    void drainCurrent( double vDS,
+                       double vGS,
+                       double* id,
+                       double* gDS,
+                       double* gGS );
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Shichman-Hodges field effect transistor base class.
+
+     Square law drain current in the triode (linear) and saturation regions
+     with channel length modulation, and an exponential gate junction
+     current between gate and source and gate and drain. The device is
+     symmetric, source and drain swap for vDS < 0. The ports are
+     drain -> source and gate -> source.
+
+     @param polarity            1 for n-channel, -1 for p-channel devices
+    */
+    fetShModel( double polarity );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the polarity of the transistor.
+
+     @returns                   1 for n-channel, -1 for p-channel devices
+    */
+    double getPolarity( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Calculate the non-linear current and it's Jacobian according to an
+     input voltage.
+
+     @param *fNL             is a pointer to store result of fNL(x).
+                             This is a current.
+     @param *JNL             is a pointer to store the result of the
+                             Jacobian of fNL(x).
+     @param *x               is a pointer to read the input value x.
+                             This is a voltage.
+     @param *currentPort     is a pointer to the first reading /
+                             writing position in fNL, JNL and x.
+    */
+    void calculate( vec* fNL,
+                    mat* JNL,
+                    vec* x,
+                    int* currentPort );
+
+};
+
+
+//==============================================================================
+class jfetShModel : public fetShModel {
+
+protected:
+    //----------------------------------------------------------------------
+    /** Parameters of the JFET */
+    jfetParams params;
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Shichman-Hodges JFET model class.
+
+     Drain current as in SPICE: beta * vDS * (2 * vGST - vDS) in the
+     linear region and beta * vGST^2 in saturation, times (1 + lambda * vDS).
+     The gate is a pn junction to the channel.
+
+     @param polarity            1 for n-channel, -1 for p-channel devices
+     @param params              parameters of the JFET in the n-channel
+                                convention
+    */
+    jfetShModel( double polarity = 1.0,
+                 const jfetParams& params = jfetParams( ) );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets new parameters and precomputes the derived constants.
+
+     @param params              parameters of the JFET
+    */
+    void setParams( const jfetParams& params );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the parameters of the JFET.
+
+     @returns                   the current parameters
+    */
+    const jfetParams& getParams( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the model enum and the parameters, see nlModel::getSignature().
+
+     @returns                   NJF_SH or PJF_SH followed by the parameters
+    */
+    std::vector<double> getSignature( );
+
+};
+
+
+//==============================================================================
+class mosfetShModel : public fetShModel {
+
+protected:
+    //----------------------------------------------------------------------
+    /** Parameters of the MOSFET */
+    mosfetParams params;
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Shichman-Hodges (SPICE level 1) MOSFET model class.
+
+     Drain current beta * (vGST * vDS - vDS^2 / 2) in the linear region and
+     beta / 2 * vGST^2 in saturation, times (1 + lambda * vDS). The gate is
+     insulated, so the gate port carries no current and only senses vGS.
+     The body is connected to the source, there is no body diode.
+
+     @param polarity            1 for n-channel, -1 for p-channel devices
+     @param params              parameters of the MOSFET in the n-channel
+                                convention
+    */
+    mosfetShModel( double polarity = 1.0,
+                   const mosfetParams& params = mosfetParams( ) );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets new parameters and precomputes the derived constants.
+
+     @param params              parameters of the MOSFET
+    */
+    void setParams( const mosfetParams& params );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the parameters of the MOSFET.
+
+     @returns                   the current parameters
+    */
+    const mosfetParams& getParams( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the model enum and the parameters, see nlModel::getSignature().
+
+     @returns                   NMOS_SH or PMOS_SH followed by the parameters
+    */
+    std::vector<double> getSignature( );
+
+};
+
+
+//==============================================================================
+class opampSatModel : public nlModel {
+
+protected:
+    //----------------------------------------------------------------------
+    /** Parameters of the op-amp */
+    opampParams params;
+    /** center and half of the output swing */
+    double center;
+    double swing;
+    /** A / swing, 1 / Rout and 1 / Rin */
+    double gainOverSwing;
+    double oneOverRout;
+    double oneOverRin;
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Saturating op-amp macro model class.
+
+     A differential input resistance Rin and an output voltage source
+     center + swing * tanh( A * vIn / swing ) behind Rout, which
+     saturates smoothly at Vpos and Vneg. The ports are in+ -> in- and
+     out -> reference (ground), the output current is the current into
+     the output terminal.
+
+     @param params              parameters of the op-amp
+    */
+    opampSatModel( const opampParams& params = opampParams( ) );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets new parameters and precomputes the derived constants.
+
+     @param params              parameters of the op-amp
+    */
+    void setParams( const opampParams& params );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the parameters of the op-amp.
+
+     @returns                   the current parameters
+    */
+    const opampParams& getParams( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the model enum and the parameters, see nlModel::getSignature().
+
+     @returns                   OPAMP_SAT followed by the parameters
+    */
+    std::vector<double> getSignature( );
+
+    //----------------------------------------------------------------------
+    /**
+     Calculate the non-linear current and it's Jacobian according to an
+     input voltage.
+
+     @param *fNL             is a pointer to store result of fNL(x).
+                             This is a current.
+     @param *JNL             is a pointer to store the result of the
+                             Jacobian of fNL(x).
+     @param *x               is a pointer to read the input value x.
+                             This is a voltage.
+     @param *currentPort     is a pointer to the first reading /
+                             writing position in fNL, JNL and x.
+    */
+    void calculate( vec* fNL,
+                    mat* JNL,
+                    vec* x,
+                    int* currentPort );
+
+};
+
+
+
+//==============================================================================
+class nlTableModel : public nlModel {
+
+protected:
+    //----------------------------------------------------------------------
+    /** Exact model, evaluated outside the table range */
+    std::unique_ptr<nlModel> model;
+    /** Lower and upper limit of the table range of every port */
+    double xMin[TABLE_MAX_PORTS];
+    double xMax[TABLE_MAX_PORTS];
+    /** Number of grid points of every port */
+    int numPoints[TABLE_MAX_PORTS];
+    /** Grid spacing and its inverse of every port */
+    double h[TABLE_MAX_PORTS];
+    double oneOverH[TABLE_MAX_PORTS];
+    /** Distance between neighbouring grid points of every port in table */
+    size_t stride[TABLE_MAX_PORTS];
+    /** Number of mixed derivatives stored per grid point and port, 2^numPorts */
+    int numDerivatives;
+    /** Offsets of the entries of a cell in table, see interpolate() */
+    size_t offsets[TABLE_NUM_WEIGHTS];
+    /** Hermite data: for every grid point and every subset of ports, the
+        derivative of all port currents with respect to the ports of the
+        subset. The empty subset holds the currents themselves. Points into
+        table or into a mapped cache file. */
+    const double* tableData;
+    /** Storage of the Hermite data if it isn't mapped from a cache file */
+    std::vector<double> table;
+    /** Mapped cache file, NULL if none is mapped */
+    void* mappedData;
+    /** Size of the mapped cache file in bytes */
+    size_t mappedSize;
+    /** Number of threads that run buildTask() */
+    size_t numBuildThreads;
+
+    //----------------------------------------------------------------------
+    /**
+     Fills the table from the exact model, split across all cores.
+    */
+    void buildTable( );
+
+    //----------------------------------------------------------------------
+    /**
+     Fills the table entries of one thread's share of the grid points.
+
+     @param context             pointer to the nlTableModel
+     @param threadIndex         index of the executing thread
+    */
+    static void buildTask( void* context,
+                           size_t threadIndex );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns everything the table depends on: TABLE_CACHE_VERSION, the
+     range, the grid and the signature of the model.
+
+     @param signature           signature of the model
+     @returns                   the description of the table
+    */
+    std::vector<double> describeTable( const std::vector<double>& signature );
+
+    //----------------------------------------------------------------------
+    /**
+     Maps a cache file and points tableData into it. On platforms without
+     mmap the file is read into table instead.
+
+     @param fileName            path to the cache file
+     @param description         expected description of the table
+     @returns                   0 for success, -1 if the file doesn't exist
+                                or doesn't match the description
+    */
+    int loadCache( const std::string& fileName,
+                   const std::vector<double>& description );
+
+    //----------------------------------------------------------------------
+    /**
+     Writes table to a cache file. The file is written under a temporary
+     name and then renamed, so other processes never see a partial file.
+
+     @param fileName            path to the cache file
+     @param description         description of the table
+     @returns                   0 for success, -1 if the file can't be written
+    */
+    int storeCache( const std::string& fileName,
+                    const std::vector<double>& description );
+
+    //----------------------------------------------------------------------
+    /**
+     Interpolates the currents and their Jacobian inside the table range.
+     N is the number of ports, a template parameter so the loops over the
+     ports unroll.
+
+     @param *xIn                port voltages
+     @param *f                  is a pointer to store the currents
+     @param J                   is an array to store the Jacobian
+    */
+    template<int N>
+    void interpolate( const double* xIn,
+                      double* f,
+                      double J[][TABLE_MAX_PORTS] );
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Table-backed approximation of another non-linear model.
+
+     Samples the currents of the model and their derivatives on a uniform
+     grid over the given range of port voltages and interpolates them with
+     tensor-product cubic Hermite polynomials. fNL is continuously
+     differentiable and JNL is its exact derivative, so the Newton solvers
+     work unchanged while each evaluation needs no exp/log/pow calls. The
+     mixed derivatives of multi-port models are taken by finite differences
+     of the Jacobian of the model. For single port models the slopes are
+     limited like Fritsch and Carlson ("Monotone piecewise cubic
+     interpolation"), so a monotone I-V curve gives a monotone spline.
+
+     Outside the table range the exact model is evaluated.
+
+     The grid points are generated in parallel on all cores, so calculate()
+     of the model must not modify the model. With a cache directory, the
+     table is stored in a file named by a hash of the model signature (see
+     nlModel::getSignature()), the range and the grid. Later instances, also
+     in other processes, map that file read-only instead of generating the
+     table again, so all of them share one physical copy of it.
+
+     @param model               model to approximate with at most
+                                TABLE_MAX_PORTS ports. The table model takes
+                                ownership of it.
+     @param xMin                lower limit of the table range of every port
+     @param xMax                upper limit of the table range of every
+                                port, greater than xMin
+     @param numPoints           number of grid points of every port, at
+                                least 2
+     @param cacheDirectory      directory of the table cache files, empty
+                                (default) to generate the table without cache
+    */
+    nlTableModel( nlModel* model,
+                  const std::vector<double>& xMin,
+                  const std::vector<double>& xMax,
+                  const std::vector<int>& numPoints,
+                  const std::string& cacheDirectory = std::string( ) );
+
+    //----------------------------------------------------------------------
+    /**
+     Deconstructor. Unmaps the cache file.
+    */
+    ~nlTableModel( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns whether the table is mapped from a cache file.
+
+     @returns                   true if the table is shared through a
+                                mapped cache file
+    */
+    bool isMapped( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the approximated model.
+
+     @returns                   a pointer to the exact model
     */
-    triDwModel();
+    nlModel* getModel( );
 
     //----------------------------------------------------------------------
     /**
@@ -27,6 +27,9 @@
  */
 
 #include "rt-wdf_nlSolvers.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
 
 //==============================================================================
 // Parent class for nlSolvers
@@ -44,6 +47,31 @@ int nlSolver::getNumPorts( ) {
     return numNLPorts;
 }
 
+//----------------------------------------------------------------------
+void nlSolver::prepareMatrData( ) {
+    //do nothing here, might be implemented by a subclass of nlSolver..
+}
+
+//----------------------------------------------------------------------
+void nlSolver::resetState( ) {
+    //do nothing here, might be implemented by a subclass of nlSolver..
+}
+
+//----------------------------------------------------------------------
+size_t nlSolver::getNumStates( ) {
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void nlSolver::getState( double* /*state*/ ) {
+    //do nothing here, might be implemented by a subclass of nlSolver..
+}
+
+//----------------------------------------------------------------------
+void nlSolver::setState( const double* /*state*/ ) {
+    //do nothing here, might be implemented by a subclass of nlSolver..
+}
+
 
 //==============================================================================
 // Newton Solver
@@ -72,12 +100,49 @@ nlNewtonSolver::nlNewtonSolver( std::vector<int> nlList,
                 nlModels.push_back(new npnEmModel);
                 break;
             }
-            // Triode Tubes:
+            case PNP_EM:            // Ebers-Moll pnp BJT
+            {
+                nlModels.push_back(new pnpEmModel);
+                break;
+            }
+            // Tubes:
             case TRI_DW:            // Dempwolf triode model
             {
                 nlModels.push_back(new triDwModel);
                 break;
             }
+            case PEN_KOREN:         // Koren pentode model
+            {
+                nlModels.push_back(new pentodeKorenModel);
+                break;
+            }
+            // Field Effect Transistors:
+            case NJF_SH:            // Shichman-Hodges n-channel JFET
+            {
+                nlModels.push_back(new jfetShModel( 1.0 ));
+                break;
+            }
+            case PJF_SH:            // Shichman-Hodges p-channel JFET
+            {
+                nlModels.push_back(new jfetShModel( -1.0 ));
+                break;
+            }
+            case NMOS_SH:           // Shichman-Hodges n-channel MOSFET
+            {
+                nlModels.push_back(new mosfetShModel( 1.0 ));
+                break;
+            }
+            case PMOS_SH:           // Shichman-Hodges p-channel MOSFET
+            {
+                nlModels.push_back(new mosfetShModel( -1.0 ));
+                break;
+            }
+            // Operational Amplifiers:
+            case OPAMP_SAT:         // saturating op-amp macro model
+            {
+                nlModels.push_back(new opampSatModel);
+                break;
+            }
             default:
             {
                 break;
@@ -96,6 +161,24 @@ nlNewtonSolver::nlNewtonSolver( std::vector<int> nlList,
     fNL      = new vec(numNLPorts, fill::zeros);
     JNL      = new mat(numNLPorts,numNLPorts, fill::zeros);
     Fmat_fNL = new vec(numNLPorts, fill::zeros);
+    p.zeros( numNLPorts );
+    xPrev.zeros( numNLPorts );
+    xLast.zeros( numNLPorts );
+
+    modelFirstPort.resize( numNLPorts );
+    modelEndPort.resize( numNLPorts );
+    int firstPort = 0;
+    for ( nlModel* model : nlModels ) {
+        const int endPort = firstPort + model->getNumPorts();
+        for( int i = firstPort; i < endPort; i++ ) {
+            modelFirstPort[i] = firstPort;
+            modelEndPort[i] = endPort;
+        }
+        firstPort = endPort;
+    }
+    prepared = false;
+    fixedIterations = 0;
+    residual = 0;
 
 }
 
@@ -116,45 +199,315 @@ nlNewtonSolver::~nlNewtonSolver( ) {
 void nlNewtonSolver::nlSolve( vec* inWaves,
                           vec* outWaves ) {
 
-    double iter = 0;            // # of iteration
-    double alpha = 0;
-
-    (*J).zeros();
+    if( fixedIterations > 0 ) {
+        // solution of the last sample for the tangent predictor
+        p = (*x0);
+        const bool predict = !firstRun;
+        projectInputs( inWaves );
+        solveFixed( predict );
+        projectOutputs( outWaves );
+        return;
+    }
 
-    if ( firstRun ) {
-        firstRun = false;
+    // solution of the last sample to restart from if the iteration
+    // from the prediction stagnates
+    const bool canRestart = !firstRun;
+    for( int i = 0; i < numNLPorts; i++ ) {
+        xLast.at( i ) = x0->at( i );
     }
-    else {
-        (*x0) = (*Fmat_fNL) + (myMatData->Emat)*(*inWaves);
+    projectInputs( inWaves );
+
+    if( blocks.size() > 1 ) {
+        double sumF2 = 0;
+        for( nlBlock& block : blocks ) {
+            const double normF = solveBlock( block, canRestart );
+            sumF2 += normF * normF;
+        }
+        residual = std::sqrt( sumF2 );
+
+        fmatKernel.multiply( fNL->memptr(), Fmat_fNL->memptr() );
+        projectOutputs( outWaves );
+        return;
     }
 
-    evalNlModels( inWaves, myMatData, x0 );
+    residual = solveNewton( canRestart );
+
+    projectOutputs( outWaves );
 
+}
+
+//----------------------------------------------------------------------
+double nlNewtonSolver::solveNewton( bool canRestart ) {
+    double iter = 0;            // # of iteration
+    bool restarted = !canRestart;
+
+    evalModels( x0 );
+    assembleJacobian( );
 
     double normF = norm(*F);
     //printf("iter alpha         ||F||_2\n");
     //printf(" %3g %9.2e %14.7e\n", iter, alpha, normF);
 
-    vec xnew;
-    double normFnew;
-
     while ( (normF >= TOL) && (iter < ITMAX) )
     {
-        vec p = - (*J).i() * (*F);
-        alpha = 1;
-        xnew = (*x0) + alpha * p;
-        evalNlModels(inWaves, myMatData, &xnew);
-        normFnew = norm(*F);
-
-        (*x0) = xnew;
-        normF = normFnew;
+        for( int i = 0; i < numNLPorts; i++ ) {
+            p.at( i ) = - F->at( i );
+        }
+        solveLinear( J->memptr(), p.memptr(), numNLPorts );
+        for( int i = 0; i < numNLPorts; i++ ) {
+            xPrev.at( i ) = x0->at( i );
+            x0->at( i ) += p.at( i );
+        }
+        evalModels( x0 );
+        double normFnew = norm(*F);
+
+        // halve steps that overshoot, e.g. into the exponential region of
+        // a junction or across the linear range of a high-gain stage
+        int backtrack = 0;
+        while( !( normFnew < normF ) && ( backtrack < BACKTRACK_MAX ) ) {
+            for( int i = 0; i < numNLPorts; i++ ) {
+                p.at( i ) *= 0.5;
+                x0->at( i ) = xPrev.at( i ) + p.at( i );
+            }
+            evalModels( x0 );
+            normFnew = norm(*F);
+            backtrack++;
+        }
+
+        if( !( normFnew < normF ) && !restarted ) {
+            // stagnation, e.g. because the prediction landed in the
+            // saturation of a high-gain stage where JNL carries no
+            // information. Start over from the last solution once.
+            for( int i = 0; i < numNLPorts; i++ ) {
+                x0->at( i ) = xLast.at( i );
+            }
+            evalModels( x0 );
+            normFnew = norm(*F);
+            restarted = true;
+        }
+
+        assembleJacobian( );
+        normF = normFnew;
         iter++;
 
     //        printf(" %3g %9.2e %14.7e\n", iter, alpha, normF);
     }
+    return normF;
+}
+
+//----------------------------------------------------------------------
+void nlNewtonSolver::solveFixed( bool predict ) {
+    if( blocks.size() > 1 ) {
+        // no predictor, the blocks start from the prediction of
+        // projectInputs()
+        double sumF2 = 0;
+        for( nlBlock& block : blocks ) {
+            const int size = (int)block.ports.size();
+            evalBlock( block );
+            for( int iter = 0; iter < fixedIterations; iter++ ) {
+                if( size == 1 ) {
+                    x0->at( block.ports[0] ) += limitStep( block.F.at( 0 ), block.J.at( 0, 0 ) );
+                }
+                else {
+                    for( int r = 0; r < size; r++ ) {
+                        block.p.at( r ) = - block.F.at( r );
+                    }
+                    solveLinear( block.J.memptr(), block.p.memptr(), size );
+                    for( int r = 0; r < size; r++ ) {
+                        x0->at( block.ports[r] ) += block.p.at( r );
+                    }
+                }
+                evalBlock( block );
+            }
+            sumF2 += dot( block.F, block.F );
+        }
+        residual = std::sqrt( sumF2 );
+
+        fmatKernel.multiply( fNL->memptr(), Fmat_fNL->memptr() );
+        return;
+    }
+
+    if( predict ) {
+        // projectInputs() evaluated the residual at the last solution p
+        // with its currents: F = x0 - p. JNL still belongs to p, so a
+        // Newton step from p needs no model evaluation.
+        assembleJacobian( );
+        for( int i = 0; i < numNLPorts; i++ ) {
+            F->at( i ) = x0->at( i ) - p.at( i );
+            p.at( i ) = - F->at( i );
+        }
+        solveLinear( J->memptr(), p.memptr(), numNLPorts );
+        for( int i = 0; i < numNLPorts; i++ ) {
+            x0->at( i ) += p.at( i ) - F->at( i );
+        }
+    }
+
+    evalModels( x0 );
+    for( int iter = 0; iter < fixedIterations; iter++ ) {
+        assembleJacobian( );
+        if( numNLPorts == 1 ) {
+            x0->at( 0 ) += limitStep( F->at( 0 ), J->at( 0, 0 ) );
+        }
+        else {
+            for( int i = 0; i < numNLPorts; i++ ) {
+                p.at( i ) = - F->at( i );
+            }
+            solveLinear( J->memptr(), p.memptr(), numNLPorts );
+            for( int i = 0; i < numNLPorts; i++ ) {
+                x0->at( i ) += p.at( i );
+            }
+        }
+        evalModels( x0 );
+    }
+    residual = norm(*F);
+}
 
-    (*outWaves) = (myMatData->Mmat) * (*inWaves) + (myMatData->Nmat) * (*fNL);
+//----------------------------------------------------------------------
+void nlNewtonSolver::projectInputs( vec* inWaves ) {
+    if( !prepared ) {
+        prepareMatrData( );
+    }
+
+    inputKernel.multiply( inWaves->memptr(), EMa.memptr() );
+
+    if ( firstRun ) {
+        firstRun = false;
+    }
+    else {
+        for( int i = 0; i < numNLPorts; i++ ) {
+            x0->at( i ) = Fmat_fNL->at( i ) + EMa.at( i );
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+void nlNewtonSolver::evalModels( vec* x ) {
+    int currentPort = 0;
+    for ( nlModel* model : nlModels ) {
+        model->calculate( fNL, JNL, x, &currentPort );
+    }
+
+    fmatKernel.multiply( fNL->memptr(), Fmat_fNL->memptr() );
+    for( int i = 0; i < numNLPorts; i++ ) {
+        F->at( i ) = EMa.at( i ) + Fmat_fNL->at( i ) - x->at( i );
+    }
+}
+
+//----------------------------------------------------------------------
+void nlNewtonSolver::assembleJacobian( ) {
+    // JNL is block diagonal with one block per model, so only the rows of
+    // the model of port k contribute to column k of Fmat * JNL
+    const mat& Fmat = myMatData->Fmat;
+    for( int k = 0; k < numNLPorts; k++ ) {
+        for( int i = 0; i < numNLPorts; i++ ) {
+            double jac = ( i == k ) ? -1.0 : 0.0;
+            for( int j = modelFirstPort[k]; j < modelEndPort[k]; j++ ) {
+                jac += Fmat.at( i, j ) * JNL->at( j, k );
+            }
+            J->at( i, k ) = jac;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+void nlNewtonSolver::projectOutputs( vec* outWaves ) {
+    const size_t numOutputs = myMatData->Mmat.n_rows;
+    outWaves->set_size( numOutputs );
+    for( size_t r = 0; r < numOutputs; r++ ) {
+        outWaves->at( r ) = EMa.at( numNLPorts + r );
+    }
+    nmatKernel.multiplyAdd( fNL->memptr(), outWaves->memptr() );
+}
+
+//----------------------------------------------------------------------
+void nlNewtonSolver::solveLinear( double* A,
+                                  double* b,
+                                  int n ) {
+    // Gaussian elimination with partial pivoting on the column-major A.
+    // The pivot is selected without a branch and rows k and pivot are
+    // always swapped, so the control flow only depends on n.
+    for( int k = 0; k < n; k++ ) {
+        int pivot = k;
+        for( int i = k + 1; i < n; i++ ) {
+            pivot = ( std::fabs( A[k * n + i] ) > std::fabs( A[k * n + pivot] ) ) ? i : pivot;
+        }
+        for( int j = k; j < n; j++ ) {
+            std::swap( A[j * n + k], A[j * n + pivot] );
+        }
+        std::swap( b[k], b[pivot] );
+        for( int i = k + 1; i < n; i++ ) {
+            const double factor = A[k * n + i] / A[k * n + k];
+            for( int j = k + 1; j < n; j++ ) {
+                A[j * n + i] -= factor * A[j * n + k];
+            }
+            b[i] -= factor * b[k];
+        }
+    }
+    for( int k = n - 1; k >= 0; k-- ) {
+        double sum = b[k];
+        for( int j = k + 1; j < n; j++ ) {
+            sum -= A[j * n + k] * b[j];
+        }
+        b[k] = sum / A[k * n + k];
+    }
+}
 
+//----------------------------------------------------------------------
+void nlNewtonSolver::factorLU( double* A,
+                               int* pivots,
+                               int n ) {
+    // Doolittle elimination with partial pivoting on the column-major A,
+    // the multipliers are kept below the diagonal
+    for( int k = 0; k < n; k++ ) {
+        int pivot = k;
+        for( int i = k + 1; i < n; i++ ) {
+            if( std::fabs( A[k * n + i] ) > std::fabs( A[k * n + pivot] ) ) {
+                pivot = i;
+            }
+        }
+        pivots[k] = pivot;
+        if( pivot != k ) {
+            for( int j = 0; j < n; j++ ) {
+                std::swap( A[j * n + k], A[j * n + pivot] );
+            }
+        }
+        for( int i = k + 1; i < n; i++ ) {
+            A[k * n + i] /= A[k * n + k];
+            const double factor = A[k * n + i];
+            for( int j = k + 1; j < n; j++ ) {
+                A[j * n + i] -= factor * A[j * n + k];
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+void nlNewtonSolver::solveLU( const double* LU,
+                              const int* pivots,
+                              double* b,
+                              int n ) {
+    for( int k = 0; k < n; k++ ) {
+        std::swap( b[k], b[pivots[k]] );
+        for( int i = k + 1; i < n; i++ ) {
+            b[i] -= LU[k * n + i] * b[k];
+        }
+    }
+    for( int k = n - 1; k >= 0; k-- ) {
+        double sum = b[k];
+        for( int j = k + 1; j < n; j++ ) {
+            sum -= LU[j * n + k] * b[j];
+        }
+        b[k] = sum / LU[k * n + k];
+    }
+}
+
+//----------------------------------------------------------------------
+double nlNewtonSolver::limitStep( double F,
+                                  double dF ) {
+    // Newton step for asinh( F ) = 0, clamped to the bracket without a branch
+    const double bound = std::fabs( F );
+    const double step = - std::asinh( F ) * std::sqrt( 1.0 + F * F ) / dF;
+    return std::max( -bound, std::min( bound, step ) );
 }
 
 //----------------------------------------------------------------------
@@ -175,3 +528,1081 @@ void nlNewtonSolver::evalNlModels( vec* inWaves,
 
 }
 
+//----------------------------------------------------------------------
+void nlNewtonSolver::evalBlock( nlBlock& block ) {
+    for( size_t m = 0; m < block.models.size(); m++ ) {
+        int currentPort = block.modelPorts[m];
+        block.models[m]->calculate( fNL, JNL, x0, &currentPort );
+    }
+
+    const mat& Fmat = myMatData->Fmat;
+    const size_t size = block.ports.size();
+    for( size_t r = 0; r < size; r++ ) {
+        const int i = block.ports[r];
+        double f = EMa.at( i ) - x0->at( i );
+        for( int j : block.inputPorts ) {
+            f += Fmat.at( i, j ) * fNL->at( j );
+        }
+        block.F.at( r ) = f;
+
+        for( size_t c = 0; c < size; c++ ) {
+            const int k = block.ports[c];
+            double jac = ( r == c ) ? -1.0 : 0.0;
+            for( int j : block.ports ) {
+                jac += Fmat.at( i, j ) * JNL->at( j, k );
+            }
+            block.J.at( r, c ) = jac;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+double nlNewtonSolver::solveBlock( nlBlock& block,
+                                   bool canRestart ) {
+    double iter = 0;            // # of iteration
+    bool restarted = !canRestart;
+
+    evalBlock( block );
+    double normF = norm( block.F );
+
+    while ( (normF >= TOL) && (iter < ITMAX) )
+    {
+        for( size_t r = 0; r < block.ports.size(); r++ ) {
+            block.p.at( r ) = - block.F.at( r );
+        }
+        solveLinear( block.J.memptr(), block.p.memptr(), (int)block.ports.size() );
+        for( size_t r = 0; r < block.ports.size(); r++ ) {
+            xPrev.at( block.ports[r] ) = x0->at( block.ports[r] );
+            x0->at( block.ports[r] ) += block.p.at( r );
+        }
+        evalBlock( block );
+        double normFnew = norm( block.F );
+
+        // halve overshooting steps like nlSolve()
+        int backtrack = 0;
+        while( !( normFnew < normF ) && ( backtrack < BACKTRACK_MAX ) ) {
+            for( size_t r = 0; r < block.ports.size(); r++ ) {
+                block.p.at( r ) *= 0.5;
+                x0->at( block.ports[r] ) = xPrev.at( block.ports[r] ) + block.p.at( r );
+            }
+            evalBlock( block );
+            normFnew = norm( block.F );
+            backtrack++;
+        }
+
+        if( !( normFnew < normF ) && !restarted ) {
+            // stagnation, start over from the last solution like nlSolve()
+            for( size_t r = 0; r < block.ports.size(); r++ ) {
+                x0->at( block.ports[r] ) = xLast.at( block.ports[r] );
+            }
+            evalBlock( block );
+            normFnew = norm( block.F );
+            restarted = true;
+        }
+
+        normF = normFnew;
+        iter++;
+    }
+    return normF;
+}
+
+//----------------------------------------------------------------------
+/**
+ Tarjan's algorithm on the dependency graph of the models. Appends the
+ strongly connected components to components in reverse topological order,
+ i.e. every component after all components it depends on.
+ */
+static void strongConnect( size_t model,
+                           const std::vector<std::vector<size_t>>& dependencies,
+                           std::vector<int>& index,
+                           std::vector<int>& lowLink,
+                           std::vector<bool>& onStack,
+                           std::vector<size_t>& stack,
+                           int& nextIndex,
+                           std::vector<std::vector<size_t>>& components ) {
+    index[model] = nextIndex;
+    lowLink[model] = nextIndex;
+    nextIndex++;
+    stack.push_back( model );
+    onStack[model] = true;
+
+    for( size_t dependency : dependencies[model] ) {
+        if( index[dependency] < 0 ) {
+            strongConnect( dependency, dependencies, index, lowLink, onStack,
+                           stack, nextIndex, components );
+            lowLink[model] = std::min( lowLink[model], lowLink[dependency] );
+        }
+        else if( onStack[dependency] ) {
+            lowLink[model] = std::min( lowLink[model], index[dependency] );
+        }
+    }
+
+    if( lowLink[model] == index[model] ) {
+        std::vector<size_t> component;
+        size_t member;
+        do {
+            member = stack.back( );
+            stack.pop_back( );
+            onStack[member] = false;
+            component.push_back( member );
+        } while( member != model );
+        std::sort( component.begin(), component.end() );
+        components.push_back( component );
+    }
+}
+
+//----------------------------------------------------------------------
+void nlNewtonSolver::prepareMatrData( ) {
+    const mat& Emat = myMatData->Emat;
+    const mat& Mmat = myMatData->Mmat;
+    mat EMmat( Emat.n_rows + Mmat.n_rows, Emat.n_cols );
+    for( size_t c = 0; c < Emat.n_cols; c++ ) {
+        for( size_t r = 0; r < Emat.n_rows; r++ ) {
+            EMmat.at( r, c ) = Emat.at( r, c );
+        }
+        for( size_t r = 0; r < Mmat.n_rows; r++ ) {
+            EMmat.at( Emat.n_rows + r, c ) = Mmat.at( r, c );
+        }
+    }
+    inputKernel.setMatrix( EMmat );
+    fmatKernel.setMatrix( myMatData->Fmat );
+    nmatKernel.setMatrix( myMatData->Nmat );
+    EMa.zeros( EMmat.n_rows );
+    prepared = true;
+
+    blocks.clear( );
+
+    const mat& Fmat = myMatData->Fmat;
+    const size_t numModels = nlModels.size( );
+    std::vector<int> firstPort( numModels + 1, 0 );
+    std::vector<size_t> portModel( numNLPorts );
+    for( size_t m = 0; m < numModels; m++ ) {
+        firstPort[m+1] = firstPort[m] + nlModels[m]->getNumPorts( );
+        for( int i = firstPort[m]; i < firstPort[m+1]; i++ ) {
+            portModel[i] = m;
+        }
+    }
+
+    std::vector<std::vector<size_t>> dependencies( numModels );
+    for( int i = 0; i < numNLPorts; i++ ) {
+        for( int j = 0; j < numNLPorts; j++ ) {
+            const size_t from = portModel[i];
+            const size_t to = portModel[j];
+            if( Fmat.at( i, j ) != 0.0 && from != to &&
+                std::find( dependencies[from].begin(), dependencies[from].end(), to ) == dependencies[from].end() ) {
+                dependencies[from].push_back( to );
+            }
+        }
+    }
+
+    std::vector<int> index( numModels, -1 );
+    std::vector<int> lowLink( numModels, 0 );
+    std::vector<bool> onStack( numModels, false );
+    std::vector<size_t> stack;
+    std::vector<std::vector<size_t>> components;
+    int nextIndex = 0;
+    for( size_t m = 0; m < numModels; m++ ) {
+        if( index[m] < 0 ) {
+            strongConnect( m, dependencies, index, lowLink, onStack, stack,
+                           nextIndex, components );
+        }
+    }
+
+    if( components.size() <= 1 ) {
+        return;
+    }
+
+    for( const std::vector<size_t>& component : components ) {
+        nlBlock block;
+        for( size_t m : component ) {
+            block.models.push_back( nlModels[m] );
+            block.modelPorts.push_back( firstPort[m] );
+            for( int i = firstPort[m]; i < firstPort[m+1]; i++ ) {
+                block.ports.push_back( i );
+            }
+        }
+        for( int j = 0; j < numNLPorts; j++ ) {
+            for( int i : block.ports ) {
+                if( Fmat.at( i, j ) != 0.0 ) {
+                    block.inputPorts.push_back( j );
+                    break;
+                }
+            }
+        }
+        block.J.zeros( block.ports.size(), block.ports.size() );
+        block.F.zeros( block.ports.size() );
+        block.p.zeros( block.ports.size() );
+        blocks.push_back( block );
+    }
+}
+
+//----------------------------------------------------------------------
+size_t nlNewtonSolver::getNumBlocks( ) const {
+    return blocks.empty() ? 1 : blocks.size();
+}
+
+//----------------------------------------------------------------------
+void nlNewtonSolver::setFixedIterations( int iterations ) {
+    fixedIterations = ( iterations > 0 ) ? iterations : 0;
+}
+
+//----------------------------------------------------------------------
+int nlNewtonSolver::getFixedIterations( ) const {
+    return fixedIterations;
+}
+
+//----------------------------------------------------------------------
+double nlNewtonSolver::getResidual( ) const {
+    return residual;
+}
+
+//----------------------------------------------------------------------
+int nlNewtonSolver::tabulateModel( size_t modelIndex,
+                                   const std::vector<double>& xMin,
+                                   const std::vector<double>& xMax,
+                                   const std::vector<int>& numPoints,
+                                   const std::string& cacheDirectory ) {
+    if( modelIndex >= nlModels.size() ) {
+        return -1;
+    }
+    const size_t numPorts = nlModels[modelIndex]->getNumPorts( );
+    if( numPorts > TABLE_MAX_PORTS || xMin.size() != numPorts ||
+        xMax.size() != numPorts || numPoints.size() != numPorts ) {
+        return -1;
+    }
+    for( size_t d = 0; d < numPorts; d++ ) {
+        if( !( xMax[d] > xMin[d] ) || numPoints[d] < 2 ) {
+            return -1;
+        }
+    }
+
+    nlModels[modelIndex] = new nlTableModel( nlModels[modelIndex], xMin, xMax,
+                                             numPoints, cacheDirectory );
+    // the blocks hold pointers to the models
+    prepared = false;
+    return 0;
+}
+
+//----------------------------------------------------------------------
+const vec* nlNewtonSolver::getCurrents( ) const {
+    return fNL;
+}
+
+//----------------------------------------------------------------------
+void nlNewtonSolver::resetState( ) {
+    x0->zeros( );
+    fNL->zeros( );
+    Fmat_fNL->zeros( );
+    firstRun = true;
+}
+
+//----------------------------------------------------------------------
+size_t nlNewtonSolver::getNumStates( ) {
+    return 3 * numNLPorts + 1;
+}
+
+//----------------------------------------------------------------------
+void nlNewtonSolver::getState( double* state ) {
+    for( int i = 0; i < numNLPorts; i++ ) {
+        state[i] = x0->at( i );
+        state[numNLPorts + i] = fNL->at( i );
+        state[2 * numNLPorts + i] = Fmat_fNL->at( i );
+    }
+    state[3 * numNLPorts] = firstRun ? 1.0 : 0.0;
+}
+
+//----------------------------------------------------------------------
+void nlNewtonSolver::setState( const double* state ) {
+    for( int i = 0; i < numNLPorts; i++ ) {
+        x0->at( i ) = state[i];
+        fNL->at( i ) = state[numNLPorts + i];
+        Fmat_fNL->at( i ) = state[2 * numNLPorts + i];
+    }
+    firstRun = ( state[3 * numNLPorts] != 0.0 );
+}
+
+
+//==============================================================================
+// Quasi-Newton Solver
+//==============================================================================
+nlQuasiNewtonSolver::nlQuasiNewtonSolver( std::vector<int> nlList,
+                                          matData* myMatData,
+                                          int solverType ) : nlNewtonSolver( nlList,
+                                                                             myMatData ),
+                                                             solverType( solverType ),
+                                                             numFactorizations( 0 ) {
+    xstart.zeros( numNLPorts );
+}
+
+nlQuasiNewtonSolver::~nlQuasiNewtonSolver( ) {
+
+}
+
+//----------------------------------------------------------------------
+void nlQuasiNewtonSolver::nlSolve( vec* inWaves,
+                                   vec* outWaves ) {
+
+    if( fixedIterations > 0 ) {
+        nlNewtonSolver::nlSolve( inWaves, outWaves );
+        return;
+    }
+
+    const bool canRestart = !firstRun;
+    for( int i = 0; i < numNLPorts; i++ ) {
+        xLast.at( i ) = x0->at( i );
+    }
+    projectInputs( inWaves );
+    for( int i = 0; i < numNLPorts; i++ ) {
+        xstart.at( i ) = x0->at( i );
+    }
+
+    if( blocks.size() > 1 ) {
+        double sumF2 = 0;
+        for( size_t b = 0; b < blocks.size(); b++ ) {
+            nlBlock& block = blocks[b];
+            double normF = solveSystem( systems[b], &block );
+            if( !( normF < TOL ) ) {
+                // an outdated Jacobian led the iteration astray, solve this
+                // block with plain Newton from the predicted guess
+                for( int i : block.ports ) {
+                    x0->at( i ) = xstart.at( i );
+                }
+                systems[b].valid = false;
+                normF = solveBlock( block, canRestart );
+            }
+            sumF2 += normF * normF;
+        }
+        residual = std::sqrt( sumF2 );
+
+        fmatKernel.multiply( fNL->memptr(), Fmat_fNL->memptr() );
+        projectOutputs( outWaves );
+        return;
+    }
+
+    double normF = solveSystem( systems[0], NULL );
+    if( !( normF < TOL ) ) {
+        // an outdated Jacobian led the iteration astray, solve this sample
+        // with plain Newton from the predicted guess
+        for( int i = 0; i < numNLPorts; i++ ) {
+            x0->at( i ) = xstart.at( i );
+        }
+        systems[0].valid = false;
+        normF = solveNewton( canRestart );
+    }
+    residual = normF;
+
+    projectOutputs( outWaves );
+
+}
+
+//----------------------------------------------------------------------
+double nlQuasiNewtonSolver::solveSystem( qnSystem& system,
+                                         nlBlock* block ) {
+    const int size = system.size;
+    const vec& Fsys = block ? block->F : *F;
+
+    double iter = 0;            // # of iteration
+
+    double normF = evalSystem( block );
+
+    // true if the factorization is the exact Jacobian at x0
+    bool exact = false;
+    if( !system.valid && normF >= TOL ) {
+        factorize( system, block );
+        exact = true;
+    }
+
+    while ( (normF >= TOL) && (iter < ITMAX) )
+    {
+        for( int r = 0; r < size; r++ ) {
+            system.Fprev.at( r ) = Fsys.at( r );
+            system.step.at( r ) = - Fsys.at( r );
+        }
+        applyInverse( system, system.step.memptr() );
+        for( int r = 0; r < size; r++ ) {
+            const int i = block ? block->ports[r] : r;
+            xPrev.at( i ) = x0->at( i );
+            x0->at( i ) += system.step.at( r );
+        }
+        const double normFnew = evalSystem( block );
+        iter++;
+
+        if( !( normFnew <= QN_CONTRACTION * normF ) ) {
+            // convergence slowed down
+            if( !exact ) {
+                // the step was based on an outdated Jacobian, discard it and
+                // retry with the exact Jacobian at x0
+                for( int r = 0; r < size; r++ ) {
+                    const int i = block ? block->ports[r] : r;
+                    x0->at( i ) = xPrev.at( i );
+                }
+                evalSystem( block );
+                factorize( system, block );
+                exact = true;
+                continue;
+            }
+            // plain Newton step, keep it and start over at the new guess
+            factorize( system, block );
+            exact = true;
+        }
+        else if( solverType == BROYDEN_SOLVER && system.numUpdates == QN_UPDATE_MAX ) {
+            factorize( system, block );
+            exact = true;
+        }
+        else if( solverType == BROYDEN_SOLVER ) {
+            // good Broyden update of the inverse (Sherman-Morrison), stored
+            // as the factor I + u * s^T with s = step, u = (step - Hy) / s^T Hy
+            for( int r = 0; r < size; r++ ) {
+                system.Hy.at( r ) = Fsys.at( r ) - system.Fprev.at( r );
+            }
+            applyInverse( system, system.Hy.memptr() );
+            double denominator = 0;
+            for( int r = 0; r < size; r++ ) {
+                denominator += system.step.at( r ) * system.Hy.at( r );
+            }
+            if( denominator != 0 ) {
+                const int k = system.numUpdates;
+                for( int r = 0; r < size; r++ ) {
+                    system.U.at( r, k ) = ( system.step.at( r ) - system.Hy.at( r ) ) / denominator;
+                    system.S.at( r, k ) = system.step.at( r );
+                }
+                system.numUpdates++;
+            }
+            exact = false;
+        }
+        else {
+            exact = false;
+        }
+
+        normF = normFnew;
+    }
+    return normF;
+}
+
+//----------------------------------------------------------------------
+double nlQuasiNewtonSolver::evalSystem( nlBlock* block ) {
+    if( block ) {
+        evalBlock( *block );
+        return norm( block->F );
+    }
+    evalModels( x0 );
+    return norm(*F);
+}
+
+//----------------------------------------------------------------------
+void nlQuasiNewtonSolver::factorize( qnSystem& system,
+                                     nlBlock* block ) {
+    const int size = system.size;
+    if( !block ) {
+        assembleJacobian( );
+    }
+    const mat& Jsys = block ? block->J : *J;
+    for( int c = 0; c < size; c++ ) {
+        for( int r = 0; r < size; r++ ) {
+            system.LU.at( r, c ) = Jsys.at( r, c );
+        }
+    }
+    factorLU( system.LU.memptr(), system.pivots.data(), size );
+    system.numUpdates = 0;
+    system.valid = true;
+    numFactorizations++;
+}
+
+//----------------------------------------------------------------------
+void nlQuasiNewtonSolver::applyInverse( const qnSystem& system,
+                                        double* v ) const {
+    const int size = system.size;
+    solveLU( system.LU.memptr(), system.pivots.data(), v, size );
+    for( int k = 0; k < system.numUpdates; k++ ) {
+        double sv = 0;
+        for( int r = 0; r < size; r++ ) {
+            sv += system.S.at( r, k ) * v[r];
+        }
+        for( int r = 0; r < size; r++ ) {
+            v[r] += system.U.at( r, k ) * sv;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+size_t nlQuasiNewtonSolver::getNumFactorizations( ) const {
+    return numFactorizations;
+}
+
+//----------------------------------------------------------------------
+void nlQuasiNewtonSolver::prepareMatrData( ) {
+    nlNewtonSolver::prepareMatrData( );
+
+    systems.clear( );
+    const size_t numSystems = blocks.empty() ? 1 : blocks.size();
+    for( size_t b = 0; b < numSystems; b++ ) {
+        const int size = blocks.empty() ? numNLPorts : (int)blocks[b].ports.size();
+        qnSystem system;
+        system.size = size;
+        system.LU.zeros( size, size );
+        system.pivots.assign( size, 0 );
+        system.U.zeros( size, QN_UPDATE_MAX );
+        system.S.zeros( size, QN_UPDATE_MAX );
+        system.numUpdates = 0;
+        system.valid = false;
+        system.step.zeros( size );
+        system.Fprev.zeros( size );
+        system.Hy.zeros( size );
+        systems.push_back( system );
+    }
+}
+
+//----------------------------------------------------------------------
+void nlQuasiNewtonSolver::resetState( ) {
+    nlNewtonSolver::resetState( );
+    for( qnSystem& system : systems ) {
+        system.valid = false;
+    }
+}
+
+//----------------------------------------------------------------------
+size_t nlQuasiNewtonSolver::getNumStates( ) {
+    // LU, pivots, U, S, numUpdates and valid of every system. A block of
+    // size n needs n^2 + n * (1 + 2 * QN_UPDATE_MAX) + 2 values, and there
+    // are at most numNLPorts blocks.
+    return nlNewtonSolver::getNumStates( ) + numNLPorts * numNLPorts +
+           numNLPorts * ( 3 + 2 * QN_UPDATE_MAX );
+}
+
+//----------------------------------------------------------------------
+void nlQuasiNewtonSolver::getState( double* state ) {
+    nlNewtonSolver::getState( state );
+    double* end = state + getNumStates( );
+    state += nlNewtonSolver::getNumStates( );
+    for( const qnSystem& system : systems ) {
+        const int size = system.size;
+        for( int i = 0; i < size * size; i++ ) {
+            *state++ = system.LU.memptr()[i];
+        }
+        for( int i = 0; i < size; i++ ) {
+            *state++ = system.pivots[i];
+        }
+        for( int i = 0; i < size * QN_UPDATE_MAX; i++ ) {
+            *state++ = system.U.memptr()[i];
+            *state++ = system.S.memptr()[i];
+        }
+        *state++ = system.numUpdates;
+        *state++ = system.valid ? 1.0 : 0.0;
+    }
+    while( state < end ) {
+        *state++ = 0.0;
+    }
+}
+
+//----------------------------------------------------------------------
+void nlQuasiNewtonSolver::setState( const double* state ) {
+    nlNewtonSolver::setState( state );
+    if( !prepared ) {
+        prepareMatrData( );
+    }
+    state += nlNewtonSolver::getNumStates( );
+    for( qnSystem& system : systems ) {
+        const int size = system.size;
+        for( int i = 0; i < size * size; i++ ) {
+            system.LU.memptr()[i] = *state++;
+        }
+        for( int i = 0; i < size; i++ ) {
+            system.pivots[i] = (int)*state++;
+        }
+        for( int i = 0; i < size * QN_UPDATE_MAX; i++ ) {
+            system.U.memptr()[i] = *state++;
+            system.S.memptr()[i] = *state++;
+        }
+        system.numUpdates = (int)*state++;
+        system.valid = ( *state++ != 0.0 );
+    }
+}
+
+
+//==============================================================================
+// Scalar Solver
+//==============================================================================
+nlScalarSolver::nlScalarSolver( std::vector<int> nlList,
+                                matData* myMatData ) : nlNewtonSolver( nlList,
+                                                                       myMatData ),
+                                                       feedback( 0 ) {
+
+}
+
+nlScalarSolver::~nlScalarSolver( ) {
+
+}
+
+//----------------------------------------------------------------------
+void nlScalarSolver::prepareMatrData( ) {
+    nlNewtonSolver::prepareMatrData( );
+    feedback = myMatData->Fmat.at( 0, 0 );
+}
+
+//----------------------------------------------------------------------
+double nlScalarSolver::evalScalar( double x,
+                                   double* dF ) {
+    int currentPort = 0;
+    x0->at( 0 ) = x;
+    nlModels[0]->calculate( fNL, JNL, x0, &currentPort );
+    *dF = feedback * JNL->at( 0, 0 ) - 1.0;
+    return EMa.at( 0 ) + feedback * fNL->at( 0 ) - x;
+}
+
+//----------------------------------------------------------------------
+void nlScalarSolver::nlSolve( vec* inWaves,
+                              vec* outWaves ) {
+
+    if( fixedIterations > 0 ) {
+        // solution of the last sample and F' there for the tangent predictor
+        const double xPrev = x0->at( 0 );
+        const double dFprev = feedback * JNL->at( 0, 0 ) - 1.0;
+        const bool predict = !firstRun;
+        projectInputs( inWaves );
+
+        double x = x0->at( 0 );
+        if( predict ) {
+            x = xPrev + limitStep( x - xPrev, dFprev );
+        }
+        double dF;
+        double F = evalScalar( x, &dF );
+        for( int iter = 0; iter < fixedIterations; iter++ ) {
+            x += limitStep( F, dF );
+            F = evalScalar( x, &dF );
+        }
+        residual = std::fabs( F );
+
+        Fmat_fNL->at( 0 ) = feedback * fNL->at( 0 );
+        projectOutputs( outWaves );
+        return;
+    }
+
+    projectInputs( inWaves );
+
+    double x = x0->at( 0 );
+    double dF;
+    double F = evalScalar( x, &dF );
+    for( int k = 0; k < SCALAR_EXPAND_MAX && !( std::isfinite( F ) && std::isfinite( dF ) ); k++ ) {
+        // the model overflows at the predicted guess, move towards zero
+        x *= 0.5;
+        F = evalScalar( x, &dF );
+    }
+
+    if( std::fabs( F ) >= TOL ) {
+        // search a bracket starting with the Newton step. For a decreasing
+        // fixed point map g(x) = x + F(x) the root lies between x and g(x),
+        // so the step is limited to F. Move on in that direction with
+        // quadrupled steps, and halve the step where the model overflows.
+        double step = - F / dF;
+        if( !std::isfinite( step ) || std::fabs( step ) > std::fabs( F ) ) {
+            step = F;
+        }
+        double other = x + step;
+        double dFother;
+        double Fother = evalScalar( other, &dFother );
+        for( int k = 0; k < SCALAR_EXPAND_MAX; k++ ) {
+            if( !std::isfinite( Fother ) || !std::isfinite( dFother ) ) {
+                step *= 0.5;
+            }
+            else if( ( F < 0 ) == ( Fother < 0 ) ) {
+                x = other;
+                F = Fother;
+                dF = dFother;
+                step *= 4.0;
+            }
+            else {
+                break;
+            }
+            other = x + step;
+            Fother = evalScalar( other, &dFother );
+        }
+
+        double iter = 0;            // # of iteration
+
+        if( ( F < 0 ) != ( Fother < 0 ) && std::isfinite( Fother ) ) {
+            // safeguarded Newton on the bracket, xl is the end with F < 0.
+            // Newton steps that leave the bracket are replaced by a false
+            // position step (Illinois variant), which is fast on the linear
+            // side of exponential characteristics where Newton overshoots.
+            // If the bracket did not halve within two steps (an end deep in
+            // the exponential region dominates the secant), bisect.
+            double xl = ( F < 0 ) ? x : other;
+            double xh = ( F < 0 ) ? other : x;
+            double Fl = ( F < 0 ) ? F : Fother;
+            double Fh = ( F < 0 ) ? Fother : F;
+            if( std::fabs( Fother ) < std::fabs( F ) ) {
+                x = other;
+                F = Fother;
+                dF = dFother;
+            }
+            int side = 0;
+            int slowSteps = 0;
+            double dxOld = std::fabs( xh - xl );
+            double width = dxOld;
+
+            while( ( std::fabs( F ) >= TOL ) && ( iter < ITMAX ) ) {
+                double xnew = x - F / dF;
+                if( slowSteps >= 2 ) {
+                    xnew = 0.5 * ( xl + xh );
+                    slowSteps = 0;
+                }
+                else if( !( ( xnew - xl ) * ( xnew - xh ) < 0 ) ||
+                         std::fabs( xnew - x ) > 0.5 * dxOld ) {
+                    xnew = xl - Fl * ( xh - xl ) / ( Fh - Fl );
+                    if( !( ( xnew - xl ) * ( xnew - xh ) < 0 ) ) {
+                        xnew = 0.5 * ( xl + xh );
+                    }
+                }
+                dxOld = std::fabs( xnew - x );
+                x = xnew;
+                F = evalScalar( x, &dF );
+                if( F < 0 ) {
+                    xl = x;
+                    Fl = F;
+                    if( side < 0 ) {
+                        Fh *= 0.5;
+                    }
+                    side = -1;
+                }
+                else {
+                    xh = x;
+                    Fh = F;
+                    if( side > 0 ) {
+                        Fl *= 0.5;
+                    }
+                    side = 1;
+                }
+                if( std::fabs( xh - xl ) <= 4.0 * DBL_EPSILON * std::fabs( x ) ) {
+                    break;
+                }
+                if( std::fabs( xh - xl ) > 0.5 * width ) {
+                    slowSteps++;
+                }
+                else {
+                    slowSteps = 0;
+                    width = std::fabs( xh - xl );
+                }
+                iter++;
+            }
+        }
+        else {
+            // no sign change found, fall back to plain Newton steps
+            F = evalScalar( x, &dF );
+            while( ( std::fabs( F ) >= TOL ) && ( iter < ITMAX ) ) {
+                x -= F / dF;
+                F = evalScalar( x, &dF );
+                iter++;
+            }
+        }
+
+        // fNL has to belong to the final x
+        if( x0->at( 0 ) != x ) {
+            F = evalScalar( x, &dF );
+        }
+    }
+    residual = std::fabs( F );
+
+    Fmat_fNL->at( 0 ) = feedback * fNL->at( 0 );
+    projectOutputs( outWaves );
+
+}
+
+
+//==============================================================================
+// MLP Solver
+//==============================================================================
+nlMlpSolver::nlMlpSolver( std::vector<int> nlList,
+                          matData* myMatData ) : nlNewtonSolver( nlList, myMatData ),
+                                                 activation( MLP_TANH ),
+                                                 refine( false ),
+                                                 residualLimit( MLP_RESIDUAL_MAX ) {
+    lastFmat_fNL.zeros( numNLPorts );
+}
+
+nlMlpSolver::~nlMlpSolver( ) {
+
+}
+
+//----------------------------------------------------------------------
+void nlMlpSolver::nlSolve( vec* inWaves,
+                           vec* outWaves ) {
+
+    if( layers.empty() ) {
+        nlNewtonSolver::nlSolve( inWaves, outWaves );
+        return;
+    }
+
+    // state of the last sample, to solve this sample again if the
+    // prediction is off
+    const bool wasFirstRun = firstRun;
+    for( int i = 0; i < numNLPorts; i++ ) {
+        xLast.at( i ) = x0->at( i );
+        lastFmat_fNL.at( i ) = Fmat_fNL->at( i );
+    }
+
+    projectInputs( inWaves );
+    evalNetwork( );
+    evalModels( x0 );
+    residual = norm(*F);
+
+    if( refine ) {
+        assembleJacobian( );
+        for( int i = 0; i < numNLPorts; i++ ) {
+            p.at( i ) = - F->at( i );
+            xPrev.at( i ) = x0->at( i );
+        }
+        solveLinear( J->memptr(), p.memptr(), numNLPorts );
+        for( int i = 0; i < numNLPorts; i++ ) {
+            x0->at( i ) += p.at( i );
+        }
+        evalModels( x0 );
+        double normFnew = norm(*F);
+
+        // halve the step like nlNewtonSolver if the prediction is too far
+        // off for the linearization, e.g. deep in a junction
+        int backtrack = 0;
+        while( !( normFnew < residual ) && ( backtrack < BACKTRACK_MAX ) ) {
+            for( int i = 0; i < numNLPorts; i++ ) {
+                p.at( i ) *= 0.5;
+                x0->at( i ) = xPrev.at( i ) + p.at( i );
+            }
+            evalModels( x0 );
+            normFnew = norm(*F);
+            backtrack++;
+        }
+        residual = normFnew;
+    }
+
+    if( !( residual <= residualLimit ) ) {
+        // e.g. an input outside the training range, or a network that
+        // produced inf or NaN
+        for( int i = 0; i < numNLPorts; i++ ) {
+            x0->at( i ) = xLast.at( i );
+            Fmat_fNL->at( i ) = lastFmat_fNL.at( i );
+        }
+        firstRun = wasFirstRun;
+        nlNewtonSolver::nlSolve( inWaves, outWaves );
+        return;
+    }
+
+    projectOutputs( outWaves );
+}
+
+//----------------------------------------------------------------------
+void nlMlpSolver::evalNetwork( ) {
+    double* in = bufferA.data();
+    double* out = bufferB.data();
+    for( int i = 0; i < numNLPorts; i++ ) {
+        in[i] = ( EMa.at( i ) - inputOffset[i] ) * inputScale[i];
+    }
+
+    const size_t numLayers = layers.size();
+    for( size_t l = 0; l < numLayers; l++ ) {
+        const mlpLayer& layer = layers[l];
+        const int rows = layer.numOutputs;
+        const double* w = layer.weights.data();
+        for( int r = 0; r < rows; r++ ) {
+            out[r] = layer.bias[r];
+        }
+        for( int c = 0; c < layer.numInputs; c++ ) {
+            const double xc = in[c];
+            const double* column = w + c * rows;
+            for( int r = 0; r < rows; r++ ) {
+                out[r] += column[r] * xc;
+            }
+        }
+
+        if( l+1 < numLayers ) {
+            if( activation == MLP_RELU ) {
+                for( int r = 0; r < rows; r++ ) {
+                    out[r] = ( out[r] > 0 ) ? out[r] : 0;
+                }
+            }
+            else {
+                for( int r = 0; r < rows; r++ ) {
+                    out[r] = std::tanh( out[r] );
+                }
+            }
+        }
+        std::swap( in, out );
+    }
+
+    for( int i = 0; i < numNLPorts; i++ ) {
+        x0->at( i ) = outputOffset[i] + outputScale[i] * in[i];
+    }
+}
+
+//----------------------------------------------------------------------
+int nlMlpSolver::loadNetwork( const std::string& fileName ) {
+    std::ifstream file( fileName.c_str() );
+    if( !file.is_open() ) {
+        return -1;
+    }
+
+    std::string header;
+    std::string activationName;
+    int numInputs = 0;
+    int numOutputs = 0;
+    int numLayers = 0;
+    file >> header >> numInputs >> numOutputs >> numLayers >> activationName;
+    if( !file || header != "MLP" || numInputs != numNLPorts ||
+        numOutputs != numNLPorts || numLayers < 1 ) {
+        return -1;
+    }
+    int newActivation;
+    if( activationName == "TANH" ) {
+        newActivation = MLP_TANH;
+    }
+    else if( activationName == "RELU" ) {
+        newActivation = MLP_RELU;
+    }
+    else {
+        return -1;
+    }
+
+    std::vector<double> newInputOffset( numInputs );
+    std::vector<double> newInputScale( numInputs );
+    std::vector<double> newOutputOffset( numOutputs );
+    std::vector<double> newOutputScale( numOutputs );
+    for( double& value : newInputOffset ) {
+        file >> value;
+    }
+    for( double& value : newInputScale ) {
+        file >> value;
+    }
+    for( double& value : newOutputOffset ) {
+        file >> value;
+    }
+    for( double& value : newOutputScale ) {
+        file >> value;
+    }
+
+    std::vector<mlpLayer> newLayers( numLayers );
+    int width = numInputs;
+    int maxWidth = numInputs;
+    for( mlpLayer& layer : newLayers ) {
+        file >> layer.numOutputs >> layer.numInputs;
+        if( !file || layer.numInputs != width || layer.numOutputs < 1 ) {
+            return -1;
+        }
+        // the file is row by row, the kernel works column by column
+        layer.weights.resize( layer.numOutputs * layer.numInputs );
+        for( int r = 0; r < layer.numOutputs; r++ ) {
+            for( int c = 0; c < layer.numInputs; c++ ) {
+                file >> layer.weights[c * layer.numOutputs + r];
+            }
+        }
+        layer.bias.resize( layer.numOutputs );
+        for( double& value : layer.bias ) {
+            file >> value;
+        }
+        width = layer.numOutputs;
+        maxWidth = std::max( maxWidth, width );
+    }
+    if( !file || width != numOutputs ) {
+        return -1;
+    }
+
+    layers.swap( newLayers );
+    activation = newActivation;
+    inputOffset.swap( newInputOffset );
+    inputScale.swap( newInputScale );
+    outputOffset.swap( newOutputOffset );
+    outputScale.swap( newOutputScale );
+    bufferA.assign( maxWidth, 0.0 );
+    bufferB.assign( maxWidth, 0.0 );
+    return 0;
+}
+
+//----------------------------------------------------------------------
+bool nlMlpSolver::hasNetwork( ) const {
+    return !layers.empty();
+}
+
+//----------------------------------------------------------------------
+void nlMlpSolver::setRefinement( bool refine ) {
+    this->refine = refine;
+}
+
+//----------------------------------------------------------------------
+void nlMlpSolver::setResidualLimit( double limit ) {
+    residualLimit = limit;
+}
+
+//----------------------------------------------------------------------
+double nlMlpSolver::solveSample( bool canRestart ) {
+    if( blocks.size() > 1 ) {
+        double sumF2 = 0;
+        for( nlBlock& block : blocks ) {
+            const double normF = solveBlock( block, canRestart );
+            sumF2 += normF * normF;
+        }
+        return std::sqrt( sumF2 );
+    }
+    return solveNewton( canRestart );
+}
+
+//----------------------------------------------------------------------
+int nlMlpSolver::generateTrainingData( const std::string& fileName,
+                                       const std::vector<double>& inputMin,
+                                       const std::vector<double>& inputMax,
+                                       int numSamples ) {
+    if( (int)inputMin.size() != numNLPorts || (int)inputMax.size() != numNLPorts ) {
+        return -1;
+    }
+    std::ofstream file( fileName.c_str() );
+    if( !file.is_open() ) {
+        return -1;
+    }
+    file.precision( 17 );
+
+    if( !prepared ) {
+        prepareMatrData( );
+    }
+    std::vector<double> state( nlNewtonSolver::getNumStates( ) );
+    nlNewtonSolver::getState( state.data() );
+
+    std::mt19937 generator( 1 );
+    std::uniform_real_distribution<double> uniform( 0.0, 1.0 );
+    int numWritten = 0;
+    for( int s = 0; s < numSamples; s++ ) {
+        // the solution only depends on Emat * inWaves, so the samples are
+        // drawn there directly
+        for( int i = 0; i < numNLPorts; i++ ) {
+            EMa.at( i ) = inputMin[i] + ( inputMax[i] - inputMin[i] ) * uniform( generator );
+            xLast.at( i ) = x0->at( i );
+        }
+
+        // from the solution of the previous sample, then once from the
+        // guess for zero currents
+        double normF = solveSample( s > 0 );
+        if( !( normF < TOL ) ) {
+            for( int i = 0; i < numNLPorts; i++ ) {
+                x0->at( i ) = EMa.at( i );
+            }
+            normF = solveSample( false );
+        }
+
+        if( normF < TOL ) {
+            for( int i = 0; i < numNLPorts; i++ ) {
+                file << EMa.at( i ) << " ";
+            }
+            for( int i = 0; i < numNLPorts; i++ ) {
+                file << x0->at( i ) << ( ( i+1 < numNLPorts ) ? " " : "\n" );
+            }
+            numWritten++;
+        }
+        else {
+            // don't start the next sample from a failed one
+            for( int i = 0; i < numNLPorts; i++ ) {
+                x0->at( i ) = xLast.at( i );
+            }
+        }
+    }
+
+    nlNewtonSolver::setState( state.data() );
+    if( !file ) {
+        return -1;
+    }
+    return numWritten;
+}
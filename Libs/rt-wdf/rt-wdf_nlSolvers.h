@@ -31,9 +31,12 @@
 
 //==============================================================================
 #include <float.h>
+#include <fstream>
+#include <string>
 
 #include "rt-wdf_types.h"
 #include "rt-wdf_nlModels.h"
+#include "rt-wdf_matVec.h"
 
 
 
@@ -45,6 +48,14 @@
 // TODO: introduce enums!
 /** Enum to specify a Newton Solver*/
 #define NEWTON_SOLVER   1
+/** Enum to specify a quasi-Newton Solver with Broyden updates */
+#define BROYDEN_SOLVER  2
+/** Enum to specify a quasi-Newton Solver with a constant (chord) Jacobian */
+#define CHORD_SOLVER    3
+
+// Surrogate:
+/** Enum to specify a Solver that evaluates a neural network */
+#define MLP_SOLVER      4
 
 
 
@@ -55,12 +66,44 @@
 #define TOL     1.0e-06                     // TODO: evaluate physically meaningful tolerance.
 /** limit on function evaluations */
 #define ITMAX   50
+/** limit on step halvings if a Newton step does not reduce ||F||_2 */
+#define BACKTRACK_MAX   10
 
 
+//==============================================================================
+// Quasi-Newton Solver config parameters
+
+/** the Jacobian is recomputed if ||F||_2 shrinks less than this per step */
+#define QN_CONTRACTION  0.5
+/** the Jacobian is refactorized after this many Broyden updates */
+#define QN_UPDATE_MAX   8
+
+
+//==============================================================================
+// Scalar Solver config parameters
+
+/** limit on step halvings on model overflow and on steps of the bracket search */
+#define SCALAR_EXPAND_MAX   8
+
+
+//==============================================================================
+// MLP Solver config parameters
+
+/** Enum to specify tanh activations of the hidden layers */
+#define MLP_TANH    1
+/** Enum to specify rectified linear activations of the hidden layers */
+#define MLP_RELU    2
+/** default limit on ||F||_2 at the prediction before falling back to Newton */
+#define MLP_RESIDUAL_MAX    1.0e-02
+
+
 //==============================================================================
 // Forward declarations
 class nlSolver;
 class nlNewtonSolver;
+class nlQuasiNewtonSolver;
+class nlScalarSolver;
+class nlMlpSolver;
 
 
 //==============================================================================
@@ -104,6 +147,48 @@ public:
     virtual void nlSolve( vec* inWaves,
                           vec* outWaves ) = 0;
 
+    //----------------------------------------------------------------------
+    /**
+     Function that does nothing if not overwritten by a method in a subclass.
+
+     Is called by the root whenever the E,F,M,N matrices of the solver have
+     changed, so the solver can analyze them before the next nlSolve().
+    */
+    virtual void prepareMatrData( );
+
+    //----------------------------------------------------------------------
+    /**
+     Function that does nothing if not overwritten by a method in a subclass.
+
+     Resets the solver to the state of a new solver, e.g. its initial guess.
+    */
+    virtual void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of state values of the solver, 0 if not overwritten
+     by a method in a subclass.
+
+     @returns                   the number of doubles of the solver state
+    */
+    virtual size_t getNumStates( );
+
+    //----------------------------------------------------------------------
+    /**
+     Stores the state of the solver.
+
+     @param state               array of getNumStates() values
+    */
+    virtual void getState( double* state );
+
+    //----------------------------------------------------------------------
+    /**
+     Restores the state of the solver.
+
+     @param state               array of getNumStates() values
+    */
+    virtual void setState( const double* state );
+
     //----------------------------------------------------------------------
     /**
      Vector of enums that specify the types on non-linearities in the solver
@@ -138,6 +223,165 @@ protected:
     vec* Fmat_fNL;
     /** flag to detect first run of the solver for a clean first initial guess */
     bool firstRun = true;
+    /** Newton step */
+    vec p;
+    /** guess before the last Newton step, to backtrack from it */
+    vec xPrev;
+    /** solution of the last sample, to restart a stagnating iteration */
+    vec xLast;
+
+    //----------------------------------------------------------------------
+    /** [Emat; Mmat], so both input projections are one pass over inWaves */
+    wdfMatVec inputKernel;
+    /** Fmat */
+    wdfMatVec fmatKernel;
+    /** Nmat */
+    wdfMatVec nmatKernel;
+    /** result of inputKernel: Emat * inWaves followed by Mmat * inWaves */
+    vec EMa;
+    /** first and past-the-end port of the model of each port, i.e. the
+        nonzero rows of each column of JNL */
+    std::vector<int> modelFirstPort;
+    std::vector<int> modelEndPort;
+    /** false until prepareMatrData() set up the kernels */
+    bool prepared;
+    /** number of Newton iterations per sample, 0 to iterate until TOL */
+    int fixedIterations;
+    /** ||F||_2 left by the last call to nlSolve() */
+    double residual;
+
+    //----------------------------------------------------------------------
+    /**
+     Calculates EMa for the incoming waves of a sample and predicts x0 from
+     the currents of the last sample.
+    */
+    void projectInputs( vec* inWaves );
+
+    //----------------------------------------------------------------------
+    /**
+     Evaluates the non-linear models at x and sets fNL, JNL, Fmat_fNL and F
+     from the precomputed Emat * inWaves.
+    */
+    void evalModels( vec* x );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets J = Fmat * JNL - I using the block diagonal structure of JNL.
+    */
+    void assembleJacobian( );
+
+    //----------------------------------------------------------------------
+    /**
+     Calculates outWaves = Mmat * inWaves + Nmat * fNL.
+    */
+    void projectOutputs( vec* outWaves );
+
+    //----------------------------------------------------------------------
+    /**
+     Solves A * x = b in place by Gaussian elimination with partial
+     pivoting. A is a column-major n x n matrix and is overwritten, b is
+     replaced by x. The pivot rows are selected and swapped without
+     branches, so the control flow only depends on n; the addresses of
+     the swapped rows still depend on the data.
+    */
+    static void solveLinear( double* A,
+                             double* b,
+                             int n );
+
+    //----------------------------------------------------------------------
+    /**
+     LU factorization with partial pivoting in place. A is a column-major
+     n x n matrix and is overwritten by the unit lower triangular factor
+     (below the diagonal) and the upper triangular factor. pivots[k]
+     receives the row that was swapped with row k in step k.
+    */
+    static void factorLU( double* A,
+                          int* pivots,
+                          int n );
+
+    //----------------------------------------------------------------------
+    /**
+     Solves A * x = b in place with the factors of factorLU(), b is
+     replaced by x.
+    */
+    static void solveLU( const double* LU,
+                         const int* pivots,
+                         double* b,
+                         int n );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the step of a single port in the fixed iteration mode.
+
+     The Newton step is taken on asinh( F ) instead of F, which is the same
+     near the root but jumps back by about VT * log( |F| ) instead of VT from
+     deep inside an exponential characteristic. The step is limited to
+     +-|F|: for a monotonic model and a passive circuit (Fmat(0,0) <= 0) the
+     root lies between x and x + F(x).
+
+     @param F                   residual at the current guess
+     @param dF                  derivative of the residual at the current guess
+     @returns                   the step to add to the guess
+    */
+    static double limitStep( double F,
+                             double dF );
+
+    //----------------------------------------------------------------------
+    /**
+     A set of models whose ports form a strongly connected component of the
+     coupling through Fmat. Holds the ports of the block and the columns of
+     Fmat that its rows read, together with the Newton system of the block.
+    */
+    typedef struct nlBlock {
+        std::vector<nlModel*> models;
+        std::vector<int> modelPorts;
+        std::vector<int> ports;
+        std::vector<int> inputPorts;
+        mat J;
+        vec F;
+        vec p;
+    } nlBlock;
+    /** blocks in solving order, empty if the system is solved at once */
+    std::vector<nlBlock> blocks;
+
+    //----------------------------------------------------------------------
+    /**
+     Evaluates the models of a block at x0 and sets F and J of the block.
+    */
+    void evalBlock( nlBlock& block );
+
+    //----------------------------------------------------------------------
+    /**
+     Solves the Newton system of a block for its ports of x0. All blocks
+     it depends on must have been solved before.
+
+     @param canRestart          true if xLast holds a solution to restart
+                                from if the iteration stagnates
+     @returns                   ||F||_2 of the block after the last step
+    */
+    double solveBlock( nlBlock& block,
+                       bool canRestart );
+
+    //----------------------------------------------------------------------
+    /**
+     Solves the whole NL system for x0 by Newton iteration, starting with
+     a model evaluation at x0.
+
+     @param canRestart          true if xLast holds a solution to restart
+                                from if the iteration stagnates
+     @returns                   ||F||_2 after the last step
+    */
+    double solveNewton( bool canRestart );
+
+    //----------------------------------------------------------------------
+    /**
+     Runs exactly fixedIterations Newton steps from the prediction of
+     projectInputs() and sets residual. See setFixedIterations().
+
+     @param predict             true if x0 was predicted from a last sample,
+                                p holds the solution of that sample
+    */
+    void solveFixed( bool predict );
 
 public:
     //----------------------------------------------------------------------
@@ -148,6 +392,10 @@ public:
      ("Resolving grouped nonlinearities in wave digital filters using
      iterative techniques"), DAFx-16
 
+     Steps that do not reduce ||F||_2 are halved up to BACKTRACK_MAX times.
+     If that doesn't help either, the iteration starts over once from the
+     solution of the last sample instead of the prediction.
+
      Creates a newton solver and it's nonlinearities
 
      @param nlList              is a vector of enums that specify the types of
@@ -169,16 +417,46 @@ public:
      nonlinearities.
 
      The actual solver operates on J and F matrices which are calculated
-     by evalNlModels based on fNL, JNL, Emat and Fmat.
+     based on fNL, JNL, Emat and Fmat. Emat * inWaves and Mmat * inWaves
+     are computed once per sample in one fused product, J is assembled
+     from the block diagonal JNL and the Newton steps are solved in
+     preallocated buffers, so no memory is allocated per sample.
 
      The result outWaves is calculated based on inWaves, x, Nmat, Mmat.
 
+     If prepareMatrData() found independent or sequentially solvable blocks
+     of models, each block is solved by its own Newton iteration with its
+     own convergence check instead.
+
      @param inWaves             is a pointer to a vector of incoming waves
      @param outWaves            is a pointer to a vector of outgoing waves
     */
     void nlSolve( vec* inWaves,
                   vec* outWaves );
 
+    //----------------------------------------------------------------------
+    /**
+     Partitions the NL system into blocks.
+
+     The residual of a port i reads the current of port j if Fmat(i,j) is
+     nonzero, and the ports of a model are always coupled through JNL. The
+     strongly connected components of this dependency graph of models
+     (Tarjan's algorithm) are blocks that can be solved one after the other
+     in topological order: each block only depends on itself and on blocks
+     solved before. The cost per iteration then scales with the size of the
+     largest block instead of numNLPorts. If the system is a single block,
+     it is solved at once as before.
+    */
+    virtual void prepareMatrData( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of blocks the NL system is solved in.
+
+     @returns                   the number of blocks, 1 if it is solved at once
+    */
+    size_t getNumBlocks( ) const;
+
     //----------------------------------------------------------------------
     /**
      Evaluates all non-linear model members of a solver and sets J and F
@@ -193,6 +471,533 @@ public:
     */
     void evalNlModels(vec* inWaves, matData* myMatData, vec* x);
 
+    //----------------------------------------------------------------------
+    /**
+     Switches the solver to a fixed number of iterations per sample.
+
+     With iterations > 0 every call to nlSolve() costs the same: the guess
+     is predicted by a Newton step from the solution of the last sample
+     with its Jacobian (tangent predictor, no extra model evaluation), then
+     exactly this many Newton steps follow without any convergence check.
+     The control flow does not depend on the data (the pivoting of
+     solveLinear() selects rows without branching), so the worst case is
+     the average case and the generated kernels of wdfCodeGenerator can be
+     vectorized across instances, with gathers for the pivot rows. The
+     result is not guaranteed to meet TOL; getResidual() reports how far
+     off it is. Large steps of the input may need more iterations,
+     diverging iterations are not caught (see wdfTree::setGuardMode()).
+
+     Single ports (nlScalarSolver and blocks of one port) take the
+     safeguarded step of limitStep() instead, which keeps hard driven
+     exponential characteristics from diverging. Quasi-Newton solvers use
+     the same fixed Newton iteration in this mode.
+
+     @param iterations          Newton steps per sample, 0 (default) to
+                                iterate until TOL or ITMAX
+    */
+    void setFixedIterations( int iterations );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of iterations per sample of the fixed iteration mode.
+
+     @returns                   the number of iterations, 0 if the solver
+                                iterates until TOL
+    */
+    int getFixedIterations( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns ||F||_2 of the NL system at the result of the last call to
+     nlSolve(). Below TOL unless the solver runs a fixed number of
+     iterations or did not converge within ITMAX.
+
+     @returns                   the residual of the last sample
+    */
+    double getResidual( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Replaces a non-linear model by a table-backed approximation of it, see
+     nlTableModel. Call it before the first call to nlSolve() or after the
+     parameters of the model changed.
+
+     @param modelIndex          index of the model in nlModels
+     @param xMin                lower limit of the table range of every
+                                port of the model
+     @param xMax                upper limit of the table range of every
+                                port of the model
+     @param numPoints           number of grid points of every port
+     @param cacheDirectory      directory of the table cache files, empty
+                                (default) to generate the table without cache
+     @returns                   0 for success, -1 if the model has more than
+                                TABLE_MAX_PORTS ports or the range is invalid
+    */
+    int tabulateModel( size_t modelIndex,
+                       const std::vector<double>& xMin,
+                       const std::vector<double>& xMax,
+                       const std::vector<int>& numPoints,
+                       const std::string& cacheDirectory = std::string( ) );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the non-linear currents fNL of the last call to nlSolve().
+
+     @returns                   a pointer to the vector fNL
+    */
+    const vec* getCurrents( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Resets the guess x0 to zero. The next call to nlSolve() starts from a
+     clean first guess again.
+    */
+    virtual void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     State of the solver: the guess x0, the currents fNL, the prediction
+     term Fmat_fNL and the first run flag.
+    */
+    virtual size_t getNumStates( );
+    virtual void getState( double* state );
+    virtual void setState( const double* state );
+
+};
+
+
+//==============================================================================
+class nlQuasiNewtonSolver : public nlNewtonSolver {
+
+protected:
+    //----------------------------------------------------------------------
+    /** BROYDEN_SOLVER or CHORD_SOLVER */
+    int solverType;
+
+    //----------------------------------------------------------------------
+    /**
+     Quasi-Newton state of the whole NL system or of one block. The inverse
+     Jacobian the iteration works with is
+
+         (I + u_k s_k^T) ... (I + u_1 s_1^T) J^-1
+
+     where J is held as LU factors and u, s are the columns of U and S.
+     All buffers are allocated by prepareMatrData().
+    */
+    typedef struct qnSystem {
+        int size;
+        mat LU;
+        std::vector<int> pivots;
+        mat U;
+        mat S;
+        int numUpdates;
+        bool valid;
+        vec step;
+        vec Fprev;
+        vec Hy;
+    } qnSystem;
+    /** one system per block of nlNewtonSolver, or one for the whole system */
+    std::vector<qnSystem> systems;
+    /** predicted guess of the current sample */
+    vec xstart;
+    /** number of Jacobian factorizations since construction */
+    size_t numFactorizations;
+
+    //----------------------------------------------------------------------
+    /**
+     Evaluates the models of a system at x0.
+
+     @param block               the block of the system, NULL for the whole
+                                system
+     @returns                   ||F||_2 of the system
+    */
+    double evalSystem( nlBlock* block );
+
+    //----------------------------------------------------------------------
+    /**
+     Factorizes the Jacobian of the last evalSystem() call and drops the
+     Broyden updates.
+    */
+    void factorize( qnSystem& system,
+                    nlBlock* block );
+
+    //----------------------------------------------------------------------
+    /**
+     Multiplies v in place with the inverse Jacobian of a system.
+    */
+    void applyInverse( const qnSystem& system,
+                       double* v ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Runs the quasi-Newton iteration on a system from x0.
+
+     @returns                   ||F||_2 of the system after the last step
+    */
+    double solveSystem( qnSystem& system,
+                        nlBlock* block );
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Quasi-Newton solver that keeps a factorized Jacobian between
+     iterations and samples.
+
+     For slowly varying signals the Jacobian barely changes from one sample
+     to the next, so the full Newton step with a new J = Fmat*JNL - I and its
+     factorization is mostly wasted. This solver keeps the LU factors of J
+     and only refactorizes when ||F||_2 shrinks by less than QN_CONTRACTION
+     in a step (and on the first sample). In between J is either kept
+     constant (CHORD_SOLVER) or improved by rank-one Broyden updates of its
+     inverse (BROYDEN_SOLVER). The updates are applied in product form
+     (Sherman-Morrison) on top of the LU factors, which costs O(n^2) per
+     step, and J is refactorized after QN_UPDATE_MAX updates. No explicit
+     inverse is formed and no memory is allocated per sample.
+
+     If prepareMatrData() split the system into blocks, every block keeps
+     its own factorization and is iterated on its own in solving order.
+
+     The result satisfies the same tolerance TOL as nlNewtonSolver. If the
+     iteration does not converge within ITMAX steps, the sample (or block)
+     is solved again by plain Newton iteration.
+
+     @param nlList              is a vector of enums that specify the types of
+                                nonlinearities
+     @param *myMatData          is a pointer to the E,F,M,N (and S) matrices
+     @param solverType          BROYDEN_SOLVER or CHORD_SOLVER
+    */
+    nlQuasiNewtonSolver( std::vector<int> nlList,
+                         matData* myMatData,
+                         int solverType );
+
+    /**
+     Deconstructor.
+    */
+    ~nlQuasiNewtonSolver( );
+
+    //----------------------------------------------------------------------
+    /**
+     Solver function that processes a vector of incoming waves and
+     returns a vector of outgoing waves according to the specified
+     nonlinearities.
+
+     @param inWaves             is a pointer to a vector of incoming waves
+     @param outWaves            is a pointer to a vector of outgoing waves
+    */
+    void nlSolve( vec* inWaves,
+                  vec* outWaves );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of Jacobian factorizations so far.
+
+     @returns                   the number of factorizations
+    */
+    size_t getNumFactorizations( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Sets up the blocks like nlNewtonSolver and allocates one factorization
+     per block. Drops all factorizations, since they belong to the old
+     matrices.
+    */
+    virtual void prepareMatrData( );
+
+    //----------------------------------------------------------------------
+    /**
+     Resets the guess x0 and drops the factorizations.
+    */
+    virtual void resetState( );
+
+    //----------------------------------------------------------------------
+    /**
+     State of the solver: the state of nlNewtonSolver followed by the
+     factors, updates and valid flags of all systems, so a restored solver
+     iterates exactly like the saved one. The size does not depend on the
+     blocks: it is the size for the whole system without blocks.
+    */
+    virtual size_t getNumStates( );
+    virtual void getState( double* state );
+    virtual void setState( const double* state );
+
+};
+
+
+//==============================================================================
+class nlScalarSolver : public nlNewtonSolver {
+
+protected:
+    //----------------------------------------------------------------------
+    /** Fmat(0,0), the feedback of the current into the port voltage */
+    double feedback;
+
+    //----------------------------------------------------------------------
+    /**
+     Evaluates the model at x and returns F(x) = Ea + Fmat(0,0) * fNL(x) - x.
+
+     @param x                   port voltage to evaluate
+     @param *dF                 is a pointer to store F'(x)
+     @returns                   F(x)
+    */
+    double evalScalar( double x,
+                       double* dF );
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Solver for roots with a single non-linear port.
+
+     The scalar equation F(x) = 0 is solved by safeguarded Newton iteration
+     on a bracket of the root: a Newton step is only taken if it stays
+     inside the bracket, otherwise a false position step (Illinois variant)
+     or a bisection shrinks the bracket. This converges for steep
+     exponential characteristics where plain Newton overshoots, and needs
+     no matrices or heap memory.
+
+     The bracket is searched from the predicted guess x with the Newton
+     step, limited to F(x) since for a monotonic model and Fmat(0,0) <= 0
+     (passive circuits) the root lies between x and x + F(x). The search
+     moves on with quadrupled steps, or halved steps where the model
+     overflows, up to SCALAR_EXPAND_MAX times; if still no sign change is
+     found, plain Newton steps are used.
+
+     A sample takes at most 2 * SCALAR_EXPAND_MAX + ITMAX + 3 model
+     evaluations (69 with the defaults): one at the guess, up to
+     SCALAR_EXPAND_MAX while the model overflows there, one plus up to
+     SCALAR_EXPAND_MAX for the bracket search and at most ITMAX + 1 for
+     the iteration on the bracket or the Newton fallback, including the
+     final evaluation at the solution.
+
+     In the fixed iteration mode (setFixedIterations()) the bracket search
+     is skipped and every step, including the tangent predictor, is the
+     safeguarded step of limitStep().
+
+     Is selected automatically by wdfRootNL for NEWTON_SOLVER if the models
+     have one port in total.
+
+     @param nlList              is a vector of enums that specify the types of
+                                nonlinearities
+     @param *myMatData          is a pointer to the E,F,M,N (and S) matrices
+    */
+    nlScalarSolver( std::vector<int> nlList,
+                    matData* myMatData );
+
+    /**
+     Deconstructor.
+    */
+    ~nlScalarSolver( );
+
+    //----------------------------------------------------------------------
+    /**
+     Solver function that processes a vector of incoming waves and
+     returns a vector of outgoing waves according to the specified
+     nonlinearity.
+
+     @param inWaves             is a pointer to a vector of incoming waves
+     @param outWaves            is a pointer to a vector of outgoing waves
+    */
+    void nlSolve( vec* inWaves,
+                  vec* outWaves );
+
+    //----------------------------------------------------------------------
+    /**
+     Reads Fmat(0,0) in addition to the preparation of nlNewtonSolver.
+    */
+    virtual void prepareMatrData( );
+
+};
+
+
+//==============================================================================
+class nlMlpSolver : public nlNewtonSolver {
+
+protected:
+    //----------------------------------------------------------------------
+    /**
+     Dense layer of the network. The weights are stored column by column,
+     so the product is a sequence of axpy operations over contiguous
+     memory that vectorizes without reordering any sums.
+     */
+    typedef struct mlpLayer {
+        int numInputs;
+        int numOutputs;
+        std::vector<double> weights;
+        std::vector<double> bias;
+    } mlpLayer;
+    /** layers of the network, empty if no network is loaded */
+    std::vector<mlpLayer> layers;
+    /** MLP_TANH or MLP_RELU, the output layer is linear */
+    int activation;
+    /** normalization of the inputs: (Emat * inWaves - offset) * scale */
+    std::vector<double> inputOffset;
+    std::vector<double> inputScale;
+    /** denormalization of the outputs: offset + scale * y */
+    std::vector<double> outputOffset;
+    std::vector<double> outputScale;
+    /** ping-pong buffers for the activations, as wide as the widest layer */
+    std::vector<double> bufferA;
+    std::vector<double> bufferB;
+    /** true to refine the output of the network by one Newton step */
+    bool refine;
+    /** predictions with a larger ||F||_2 are solved by Newton iteration */
+    double residualLimit;
+    /** Fmat * fNL of the last sample, to solve a sample again */
+    vec lastFmat_fNL;
+
+    //----------------------------------------------------------------------
+    /**
+     Evaluates the network for Emat * inWaves in EMa and stores the
+     predicted port voltages in x0.
+     */
+    void evalNetwork( );
+
+    //----------------------------------------------------------------------
+    /**
+     Solves the NL system for Emat * inWaves in EMa by Newton iteration
+     from x0, block by block if there are blocks.
+
+     @param canRestart          true if xLast holds a solution to restart
+                                from if the iteration stagnates
+     @returns                   ||F||_2 of the whole system
+     */
+    double solveSample( bool canRestart );
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Solver that predicts the solution of the NL system by a small neural
+     network (multi-layer perceptron) instead of iterating.
+
+     The solution x only depends on Emat * inWaves, one value per port, so
+     the network maps numNLPorts inputs to numNLPorts port voltages,
+     independent of the size of the rest of the circuit. The models are
+     evaluated once at the prediction to get the currents, and optionally
+     one Newton step from the prediction corrects the remaining error (see
+     setRefinement()). As long as the network is accurate, the cost per
+     sample is constant: no iteration and no lookup tables that grow
+     exponentially with the number of ports.
+
+     If ||F||_2 at the result is not finite or above the limit of
+     setResidualLimit(), e.g. for inputs outside the range the network was
+     trained on, the sample is solved again by nlNewtonSolver::nlSolve()
+     from the solution of the last sample. So the worst case is the cost
+     of the network plus the cost of nlNewtonSolver.
+
+     The network is trained offline. Until a network is loaded with
+     loadNetwork(), the solver works exactly like nlNewtonSolver, and
+     generateTrainingData() solves inputs of a given range by Newton
+     iteration to produce training data.
+
+     getResidual() reports ||F||_2 at the result, so the quality of the
+     network can be checked at run time.
+
+     @param nlList              is a vector of enums that specify the types of
+                                nonlinearities
+     @param *myMatData          is a pointer to the E,F,M,N (and S) matrices
+    */
+    nlMlpSolver( std::vector<int> nlList,
+                 matData* myMatData );
+
+    /**
+     Deconstructor.
+    */
+    ~nlMlpSolver( );
+
+    //----------------------------------------------------------------------
+    /**
+     Solver function that processes a vector of incoming waves and
+     returns a vector of outgoing waves according to the specified
+     nonlinearities.
+
+     @param inWaves             is a pointer to a vector of incoming waves
+     @param outWaves            is a pointer to a vector of outgoing waves
+    */
+    void nlSolve( vec* inWaves,
+                  vec* outWaves );
+
+    //----------------------------------------------------------------------
+    /**
+     Loads the network from a text file of whitespace separated values:
+
+         MLP numInputs numOutputs numLayers TANH|RELU
+         inputOffset[numInputs] inputScale[numInputs]
+         outputOffset[numOutputs] outputScale[numOutputs]
+
+     followed by numLayers layers of
+
+         numOutputs numInputs
+         weights[numOutputs * numInputs] (row by row) bias[numOutputs]
+
+     numInputs and numOutputs of the network must equal the number of
+     ports, the layers must chain up. All layers but the last apply the
+     activation. Allocates memory, don't call this from the audio thread.
+
+     @param fileName            path to the network file
+     @returns                   0 for success, -1 if the file can't be read
+                                or doesn't match the solver. The solver
+                                keeps its previous network then.
+    */
+    int loadNetwork( const std::string& fileName );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns whether a network is loaded.
+
+     @returns                   true if nlSolve() evaluates a network,
+                                false if it iterates like nlNewtonSolver
+    */
+    bool hasNetwork( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Switches the Newton step after the network on or off (default off).
+     Like in nlNewtonSolver, the step is halved up to BACKTRACK_MAX times
+     if it doesn't reduce ||F||_2.
+
+     @param refine              true to refine the prediction of the network
+    */
+    void setRefinement( bool refine );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets the limit on ||F||_2 at the result of the network (default
+     MLP_RESIDUAL_MAX). Samples above the limit are solved again by Newton
+     iteration. The residual is in volts at the ports, so circuits with
+     large voltages may need a larger limit.
+
+     @param limit               the largest accepted ||F||_2
+    */
+    void setResidualLimit( double limit );
+
+    //----------------------------------------------------------------------
+    /**
+     Writes training data for a network of this solver. Draws numSamples
+     uniformly distributed values of Emat * inWaves from the box between
+     inputMin and inputMax, solves each by Newton iteration from the
+     solution of the previous one (and once more from the guess for zero
+     currents if that fails) and writes one line per sample with the
+     numNLPorts values of Emat * inWaves followed by the numNLPorts port
+     voltages of the solution. Samples that do not converge to TOL are
+     left out. The random sequence is fixed, so the file is reproducible.
+
+     Choose the box from the range of Emat * inWaves the circuit sees in
+     its intended use. The state of the solver is kept. Allocates memory
+     and writes to a file, don't call this from the audio thread.
+
+     @param fileName            path to the training data file, which is
+                                overwritten
+     @param inputMin            lower bounds of Emat * inWaves, one per port
+     @param inputMax            upper bounds of Emat * inWaves, one per port
+     @param numSamples          number of samples to draw
+     @returns                   the number of samples written, -1 if the
+                                bounds don't match the number of ports or
+                                the file can't be written
+    */
+    int generateTrainingData( const std::string& fileName,
+                              const std::vector<double>& inputMin,
+                              const std::vector<double>& inputMax,
+                              int numSamples );
+
 };
 
 
@@ -0,0 +1,583 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_render.cpp
+ Created: 18 Oct 2026 8:20:00pm
+
+ ==============================================================================
+ */
+
+#include "rt-wdf_render.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define RENDER_USE_MMAP 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #define RENDER_USE_MMAP 0
+#endif
+
+
+//==============================================================================
+//                      O F F L I N E   R E N D E R E R
+//==============================================================================
+wdfOfflineRenderer::wdfOfflineRenderer( wdfTree* tree ) : tree( tree ),
+                                                          nextEvent( 0 ),
+                                                          rawFormat( float32Format ),
+                                                          rawSampleRate( 0 ),
+                                                          outputFormat( float32Format ),
+                                                          inputFormat( float32Format ),
+                                                          inputSampleRate( 0 ),
+                                                          inputOffset( 0 ),
+                                                          inputStride( 0 ),
+                                                          numSamples( 0 ),
+                                                          outputOffset( 0 ),
+                                                          currentBlock( 0 ),
+                                                          threadPool( 2 ) {
+    input.fd = -1;
+    input.data = NULL;
+    input.size = 0;
+    output.fd = -1;
+    output.data = NULL;
+    output.size = 0;
+    for( int i = 0; i < 2; i++ ) {
+        inputBuffers[i].resize( RENDER_BLOCK_SIZE );
+        outputBuffers[i].resize( RENDER_BLOCK_SIZE );
+    }
+}
+
+wdfOfflineRenderer::~wdfOfflineRenderer( ) {
+
+}
+
+//----------------------------------------------------------------------
+int wdfOfflineRenderer::loadAutomation( const std::string& fileName ) {
+    std::ifstream file( fileName.c_str() );
+    if( !file ) {
+        errorMessage = "cannot open automation file '" + fileName + "'";
+        return -1;
+    }
+
+    const std::vector<paramData>& params = tree->getParams( );
+    std::vector<renderEvent> loaded;
+    std::string line;
+    size_t lineNumber = 0;
+    while( std::getline( file, line ) ) {
+        lineNumber++;
+        std::istringstream tokens( line );
+        std::string first;
+        if( !( tokens >> first ) || first[0] == '#' ) {
+            continue;
+        }
+
+        std::ostringstream where;
+        where << fileName << ":" << lineNumber << ": ";
+
+        renderEvent event;
+        std::string param;
+        char* end;
+        event.time = strtod( first.c_str(), &end );
+        if( *end != '\0' || event.time < 0 || !( tokens >> param >> event.value ) ) {
+            errorMessage = where.str() + "expected '<time> <param> <value>'";
+            return -1;
+        }
+
+        unsigned long id = strtoul( param.c_str(), &end, 10 );
+        if( *end != '\0' ) {
+            id = params.size( );
+            for( size_t i = 0; i < params.size(); i++ ) {
+                if( params[i].name == param ) {
+                    id = i;
+                }
+            }
+        }
+        if( id >= params.size() ) {
+            errorMessage = where.str() + "unknown parameter '" + param + "'";
+            return -1;
+        }
+        event.paramID = id;
+        event.position = 0;
+        loaded.push_back( event );
+    }
+
+    events.insert( events.end(), loaded.begin(), loaded.end() );
+    std::stable_sort( events.begin(), events.end(),
+                      []( const renderEvent& l, const renderEvent& r ) { return l.time < r.time; } );
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void wdfOfflineRenderer::clearAutomation( ) {
+    events.clear( );
+}
+
+//----------------------------------------------------------------------
+void wdfOfflineRenderer::setRawFormat( renderSampleFormat format,
+                                       double sampleRate ) {
+    rawFormat = format;
+    rawSampleRate = sampleRate;
+}
+
+//----------------------------------------------------------------------
+void wdfOfflineRenderer::setOutputFormat( renderSampleFormat format ) {
+    outputFormat = format;
+}
+
+//----------------------------------------------------------------------
+int wdfOfflineRenderer::render( const std::string& inputFile,
+                                const std::string& outputFile ) {
+    numSamples = 0;
+    if( openInput( inputFile, &input ) != 0 ) {
+        return -1;
+    }
+
+    if( input.size >= 12 && memcmp( input.data, "RIFF", 4 ) == 0 &&
+        memcmp( input.data + 8, "WAVE", 4 ) == 0 ) {
+        if( parseWavHeader( input ) != 0 ) {
+            closeFile( &input, false );
+            return -1;
+        }
+    }
+    else {
+        inputFormat = rawFormat;
+        inputSampleRate = ( rawSampleRate > 0 ) ? rawSampleRate : tree->getSamplerate( );
+        inputOffset = 0;
+        inputStride = sampleSize( rawFormat );
+        numSamples = input.size / inputStride;
+    }
+
+    if( inputSampleRate != tree->getSamplerate() ) {
+        tree->setSamplerate( inputSampleRate );
+        if( tree->adaptTree( ) != 0 ) {
+            errorMessage = "adaption of the tree failed";
+            closeFile( &input, false );
+            return -1;
+        }
+    }
+
+    const bool wav = outputFile.size() >= 4 &&
+                     outputFile.compare( outputFile.size() - 4, 4, ".wav" ) == 0;
+    outputOffset = wav ? 44 : 0;
+    if( openOutput( outputFile,
+                    outputOffset + numSamples * sampleSize( outputFormat ),
+                    &output ) != 0 ) {
+        closeFile( &input, false );
+        return -1;
+    }
+    if( wav ) {
+        writeWavHeader( output.data, numSamples, inputSampleRate );
+    }
+
+    for( size_t i = 0; i < events.size(); i++ ) {
+        events[i].position = (size_t)std::llround( events[i].time * inputSampleRate );
+    }
+    nextEvent = 0;
+
+    // block k is processed while k+1 is decoded and k-1 is encoded
+    const size_t numBlocks = ( numSamples + RENDER_BLOCK_SIZE - 1 ) / RENDER_BLOCK_SIZE;
+    if( numBlocks > 0 ) {
+        decodeBlock( 0 );
+        for( currentBlock = 0; currentBlock < numBlocks; currentBlock++ ) {
+            threadPool.run( &wdfOfflineRenderer::pipelineTask, this );
+        }
+        encodeBlock( numBlocks - 1 );
+    }
+
+    closeFile( &input, false );
+    return closeFile( &output, true );
+}
+
+//----------------------------------------------------------------------
+size_t wdfOfflineRenderer::getNumRenderedSamples( ) const {
+    return numSamples;
+}
+
+//----------------------------------------------------------------------
+const std::string& wdfOfflineRenderer::getErrorMessage( ) const {
+    return errorMessage;
+}
+
+//----------------------------------------------------------------------
+void wdfOfflineRenderer::pipelineTask( void* context,
+                                       size_t threadIndex ) {
+    wdfOfflineRenderer* renderer = static_cast<wdfOfflineRenderer*>( context );
+    const size_t block = renderer->currentBlock;
+    if( threadIndex == 0 ) {
+        renderer->processBlock( block );
+    }
+    else {
+        if( ( block + 1 ) * RENDER_BLOCK_SIZE < renderer->numSamples ) {
+            renderer->decodeBlock( block + 1 );
+        }
+        if( block > 0 ) {
+            renderer->encodeBlock( block - 1 );
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+void wdfOfflineRenderer::processBlock( size_t block ) {
+    const size_t start = block * RENDER_BLOCK_SIZE;
+    const size_t end = std::min( start + RENDER_BLOCK_SIZE, numSamples );
+    const double* in = inputBuffers[block % 2].data( );
+    double* out = outputBuffers[block % 2].data( );
+
+    size_t n = start;
+    while( n < end ) {
+        while( nextEvent < events.size() && events[nextEvent].position <= n ) {
+            tree->setParam( events[nextEvent].paramID, events[nextEvent].value );
+            nextEvent++;
+        }
+        size_t segmentEnd = end;
+        if( nextEvent < events.size() ) {
+            segmentEnd = std::min( segmentEnd, events[nextEvent].position );
+        }
+        tree->processBlock( in + ( n - start ), out + ( n - start ), segmentEnd - n );
+        n = segmentEnd;
+    }
+}
+
+//----------------------------------------------------------------------
+void wdfOfflineRenderer::decodeBlock( size_t block ) {
+    const size_t start = block * RENDER_BLOCK_SIZE;
+    const size_t length = std::min( (size_t)RENDER_BLOCK_SIZE, numSamples - start );
+    const unsigned char* p = input.data + inputOffset + start * inputStride;
+    double* buffer = inputBuffers[block % 2].data( );
+
+    for( size_t i = 0; i < length; i++, p += inputStride ) {
+        switch( inputFormat ) {
+            case pcm8Format:
+                buffer[i] = ( p[0] - 128 ) / 128.0;
+                break;
+            case pcm16Format:
+                buffer[i] = (int16_t)( p[0] | ( p[1] << 8 ) ) / 32768.0;
+                break;
+            case pcm24Format:
+                buffer[i] = (int32_t)( ( p[0] << 8 ) | ( p[1] << 16 ) | ( (uint32_t)p[2] << 24 ) ) / 2147483648.0;
+                break;
+            case pcm32Format:
+                buffer[i] = (int32_t)( p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( (uint32_t)p[3] << 24 ) ) / 2147483648.0;
+                break;
+            case float32Format: {
+                float value;
+                memcpy( &value, p, sizeof( value ) );
+                buffer[i] = value;
+                break;
+            }
+            case float64Format:
+                memcpy( &buffer[i], p, sizeof( double ) );
+                break;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+void wdfOfflineRenderer::encodeBlock( size_t block ) {
+    const size_t start = block * RENDER_BLOCK_SIZE;
+    const size_t length = std::min( (size_t)RENDER_BLOCK_SIZE, numSamples - start );
+    const size_t stride = sampleSize( outputFormat );
+    unsigned char* p = output.data + outputOffset + start * stride;
+    const double* buffer = outputBuffers[block % 2].data( );
+
+    for( size_t i = 0; i < length; i++, p += stride ) {
+        const double clipped = std::max( -1.0, std::min( 1.0, buffer[i] ) );
+        switch( outputFormat ) {
+            case pcm8Format:
+                p[0] = (unsigned char)std::min( 255L, std::lround( clipped * 128.0 ) + 128 );
+                break;
+            case pcm16Format: {
+                const long value = std::min( 32767L, std::lround( clipped * 32768.0 ) );
+                p[0] = value & 0xff;
+                p[1] = ( value >> 8 ) & 0xff;
+                break;
+            }
+            case pcm24Format: {
+                const long value = std::min( 8388607L, std::lround( clipped * 8388608.0 ) );
+                p[0] = value & 0xff;
+                p[1] = ( value >> 8 ) & 0xff;
+                p[2] = ( value >> 16 ) & 0xff;
+                break;
+            }
+            case pcm32Format: {
+                const long long value = std::min( 2147483647LL, std::llround( clipped * 2147483648.0 ) );
+                p[0] = value & 0xff;
+                p[1] = ( value >> 8 ) & 0xff;
+                p[2] = ( value >> 16 ) & 0xff;
+                p[3] = ( value >> 24 ) & 0xff;
+                break;
+            }
+            case float32Format: {
+                const float value = (float)buffer[i];
+                memcpy( p, &value, sizeof( value ) );
+                break;
+            }
+            case float64Format:
+                memcpy( p, &buffer[i], sizeof( double ) );
+                break;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+/**
+ Reads little endian integers from a byte array.
+ */
+static uint32_t readLE( const unsigned char* p,
+                        int numBytes ) {
+    uint32_t value = 0;
+    for( int i = numBytes - 1; i >= 0; i-- ) {
+        value = ( value << 8 ) | p[i];
+    }
+    return value;
+}
+
+//----------------------------------------------------------------------
+int wdfOfflineRenderer::parseWavHeader( const renderFile& file ) {
+    const unsigned char* data = file.data;
+    size_t pos = 12;
+    bool haveFormat = false;
+    while( pos + 8 <= file.size ) {
+        const size_t chunkSize = readLE( data + pos + 4, 4 );
+        const unsigned char* chunk = data + pos + 8;
+        const size_t available = std::min( chunkSize, file.size - pos - 8 );
+
+        if( memcmp( data + pos, "fmt ", 4 ) == 0 && available >= 16 ) {
+            unsigned int tag = readLE( chunk, 2 );
+            const unsigned int bits = readLE( chunk + 14, 2 );
+            if( tag == 0xfffe && available >= 26 ) {
+                tag = readLE( chunk + 24, 2 );      // WAVE_FORMAT_EXTENSIBLE
+            }
+            inputSampleRate = readLE( chunk + 4, 4 );
+            inputStride = readLE( chunk + 12, 2 );
+
+            if( tag == 1 && bits == 8 )        inputFormat = pcm8Format;
+            else if( tag == 1 && bits == 16 )  inputFormat = pcm16Format;
+            else if( tag == 1 && bits == 24 )  inputFormat = pcm24Format;
+            else if( tag == 1 && bits == 32 )  inputFormat = pcm32Format;
+            else if( tag == 3 && bits == 32 )  inputFormat = float32Format;
+            else if( tag == 3 && bits == 64 )  inputFormat = float64Format;
+            else {
+                errorMessage = "unsupported WAV sample format in '" + file.name + "'";
+                return -1;
+            }
+            if( inputStride < sampleSize( inputFormat ) || inputSampleRate <= 0 ) {
+                errorMessage = "invalid WAV format chunk in '" + file.name + "'";
+                return -1;
+            }
+            haveFormat = true;
+        }
+        else if( memcmp( data + pos, "data", 4 ) == 0 ) {
+            if( !haveFormat ) {
+                break;
+            }
+            inputOffset = pos + 8;
+            numSamples = available / inputStride;
+            return 0;
+        }
+        pos += 8 + chunkSize + ( chunkSize & 1 );
+    }
+
+    errorMessage = "no format or data chunk in '" + file.name + "'";
+    return -1;
+}
+
+//----------------------------------------------------------------------
+void wdfOfflineRenderer::writeWavHeader( unsigned char* data,
+                                         size_t numSamples,
+                                         double sampleRate ) {
+    const uint32_t bytes = (uint32_t)sampleSize( outputFormat );
+    const uint32_t rate = (uint32_t)std::lround( sampleRate );
+    const bool isFloat = ( outputFormat == float32Format || outputFormat == float64Format );
+    const uint32_t fields[] = {
+        36 + (uint32_t)( numSamples * bytes ),  // RIFF size
+        16,                                     // fmt size
+        ( isFloat ? 3u : 1u ) | ( 1u << 16 ),   // format tag, 1 channel
+        rate,                                   // sample rate
+        rate * bytes,                           // byte rate
+        bytes | ( ( bytes * 8 ) << 16 ),        // block align, bits per sample
+        (uint32_t)( numSamples * bytes )        // data size
+    };
+    const char* ids[] = { "RIFF", "WAVE", "fmt ", "data" };
+
+    memcpy( data, ids[0], 4 );
+    memcpy( data + 8, ids[1], 4 );
+    memcpy( data + 12, ids[2], 4 );
+    memcpy( data + 36, ids[3], 4 );
+    const size_t offsets[] = { 4, 16, 20, 24, 28, 32, 40 };
+    for( size_t i = 0; i < 7; i++ ) {
+        for( int k = 0; k < 4; k++ ) {
+            data[offsets[i] + k] = ( fields[i] >> ( 8 * k ) ) & 0xff;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+size_t wdfOfflineRenderer::sampleSize( renderSampleFormat format ) {
+    switch( format ) {
+        case pcm8Format:    return 1;
+        case pcm16Format:   return 2;
+        case pcm24Format:   return 3;
+        case pcm32Format:   return 4;
+        case float32Format: return 4;
+        case float64Format: return 8;
+    }
+    return 4;
+}
+
+//----------------------------------------------------------------------
+int wdfOfflineRenderer::openInput( const std::string& fileName,
+                                   renderFile* file ) {
+    file->name = fileName;
+    file->data = NULL;
+    file->size = 0;
+#if RENDER_USE_MMAP
+    file->fd = open( fileName.c_str(), O_RDONLY );
+    struct stat info;
+    if( file->fd < 0 || fstat( file->fd, &info ) != 0 ) {
+        errorMessage = "cannot open input file '" + fileName + "'";
+        closeFile( file, false );
+        return -1;
+    }
+    file->size = info.st_size;
+    if( file->size > 0 ) {
+        void* mapped = mmap( NULL, file->size, PROT_READ, MAP_PRIVATE, file->fd, 0 );
+        if( mapped == MAP_FAILED ) {
+            errorMessage = "cannot map input file '" + fileName + "'";
+            closeFile( file, false );
+            return -1;
+        }
+        file->data = static_cast<unsigned char*>( mapped );
+        madvise( mapped, file->size, MADV_SEQUENTIAL );
+    }
+#else
+    std::ifstream stream( fileName.c_str(), std::ios::binary );
+    if( !stream ) {
+        errorMessage = "cannot open input file '" + fileName + "'";
+        return -1;
+    }
+    file->buffer.assign( std::istreambuf_iterator<char>( stream ),
+                         std::istreambuf_iterator<char>() );
+    file->size = file->buffer.size( );
+    file->data = file->buffer.data( );
+#endif
+    return 0;
+}
+
+#if RENDER_USE_MMAP
+//----------------------------------------------------------------------
+/**
+ Allocates the blocks of a new file of the given size, so that stores into
+ a shared mapping of it cannot fail with SIGBUS on a full disk.
+ */
+static int reserveFile( int fd,
+                        size_t size ) {
+    if( size == 0 ) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    fstore_t store = { F_ALLOCATEALL, F_PEOFPOSMODE, 0, static_cast<off_t>( size ), 0 };
+    if( fcntl( fd, F_PREALLOCATE, &store ) == -1 ) {
+        return -1;
+    }
+    return ftruncate( fd, size );
+#else
+    return ( posix_fallocate( fd, 0, size ) == 0 ) ? 0 : -1;
+#endif
+}
+#endif
+
+//----------------------------------------------------------------------
+int wdfOfflineRenderer::openOutput( const std::string& fileName,
+                                    size_t size,
+                                    renderFile* file ) {
+    file->name = fileName;
+    file->data = NULL;
+    file->size = size;
+#if RENDER_USE_MMAP
+    file->fd = open( fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    if( file->fd < 0 ) {
+        errorMessage = "cannot create output file '" + fileName + "'";
+        closeFile( file, false );
+        return -1;
+    }
+    if( reserveFile( file->fd, size ) != 0 ) {
+        errorMessage = "cannot reserve space for output file '" + fileName + "'";
+        closeFile( file, false );
+        return -1;
+    }
+    if( size > 0 ) {
+        void* mapped = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0 );
+        if( mapped == MAP_FAILED ) {
+            errorMessage = "cannot map output file '" + fileName + "'";
+            closeFile( file, false );
+            return -1;
+        }
+        file->data = static_cast<unsigned char*>( mapped );
+    }
+#else
+    file->buffer.assign( size, 0 );
+    file->data = file->buffer.data( );
+#endif
+    return 0;
+}
+
+//----------------------------------------------------------------------
+int wdfOfflineRenderer::closeFile( renderFile* file,
+                                   bool write ) {
+    int result = 0;
+#if RENDER_USE_MMAP
+    if( file->data != NULL ) {
+        if( write && msync( file->data, file->size, MS_SYNC ) != 0 ) {
+            errorMessage = "cannot write output file '" + file->name + "'";
+            result = -1;
+        }
+        munmap( file->data, file->size );
+    }
+    if( file->fd >= 0 && close( file->fd ) != 0 && write ) {
+        errorMessage = "cannot write output file '" + file->name + "'";
+        result = -1;
+    }
+    file->fd = -1;
+#else
+    if( write ) {
+        std::ofstream stream( file->name.c_str(), std::ios::binary );
+        stream.write( reinterpret_cast<const char*>( file->buffer.data() ), file->buffer.size() );
+        if( !stream ) {
+            errorMessage = "cannot write output file '" + file->name + "'";
+            result = -1;
+        }
+    }
+    file->buffer.clear( );
+#endif
+    file->data = NULL;
+    file->size = 0;
+    return result;
+}
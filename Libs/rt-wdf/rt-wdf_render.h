@@ -0,0 +1,304 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_render.h
+ Created: 18 Oct 2026 8:20:00pm
+
+ ==============================================================================
+ */
+
+#ifndef RTWDF_RENDER_H_INCLUDED
+#define RTWDF_RENDER_H_INCLUDED
+
+//==============================================================================
+#include <string>
+#include <vector>
+
+#include "rt-wdf.h"
+#include "rt-wdf_threadPool.h"
+
+
+//==============================================================================
+// Offline renderer config parameters
+
+/** Number of samples per block of the render pipeline */
+#define RENDER_BLOCK_SIZE   65536
+
+
+//==============================================================================
+/** Sample formats of raw files and of rendered files */
+typedef enum renderSampleFormat {
+    pcm8Format,
+    pcm16Format,
+    pcm24Format,
+    pcm32Format,
+    float32Format,
+    float64Format
+} renderSampleFormat;
+
+
+//==============================================================================
+class wdfOfflineRenderer {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Streams an audio file through a tree.
+
+     The input file is memory-mapped and decoded block by block, the output
+     file is created with its final size and memory-mapped as well. Blocks
+     of RENDER_BLOCK_SIZE samples are double buffered: while the tree
+     processes block k with wdfTree::processBlock(), a second thread decodes
+     block k+1 and encodes block k-1, so file I/O overlaps the computation.
+
+     Input files are WAV files (8/16/24/32 bit PCM or 32/64 bit float, only
+     the first channel is used) or headerless raw files in the format set
+     with setRawFormat(). The tree is adapted to the sample rate of the
+     input. Output files ending in ".wav" are written as mono WAV files,
+     all others as raw files in the output format.
+
+     The tree must be initialized. It is used exclusively by the renderer
+     while render() runs.
+
+     @param tree                is a pointer to the tree to render
+     */
+    wdfOfflineRenderer( wdfTree* tree );
+
+    //----------------------------------------------------------------------
+    /**
+     Deconstructor
+     */
+    virtual ~wdfOfflineRenderer( );
+
+    //----------------------------------------------------------------------
+    /**
+     Loads parameter automation from a text file.
+
+     Every line holds an event "<time> <param> <value>": the time in seconds,
+     the parameter as its ID or its name in the tree's param vector and the
+     new value that is passed to wdfTree::setParam() when the rendering
+     reaches that time. Empty lines and lines starting with '#' are ignored.
+     Events do not have to be sorted.
+
+     @param fileName            path of the automation file
+
+     @returns                   0 for success, -1 for error
+     */
+    int loadAutomation( const std::string& fileName );
+
+    //----------------------------------------------------------------------
+    /**
+     Removes all automation events.
+     */
+    void clearAutomation( );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets the format of raw input files.
+
+     @param format              sample format of raw input files
+     @param sampleRate          sample rate of raw input files
+     */
+    void setRawFormat( renderSampleFormat format,
+                       double sampleRate );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets the sample format of rendered files. Default is float32Format.
+
+     @param format              sample format of the output file
+     */
+    void setOutputFormat( renderSampleFormat format );
+
+    //----------------------------------------------------------------------
+    /**
+     Renders an input file to an output file.
+
+     @param inputFile           path of a WAV or raw input file
+     @param outputFile          path of the output file, will be overwritten
+
+     @returns                   0 for success, -1 for error. See
+                                getErrorMessage() for details.
+     */
+    int render( const std::string& inputFile,
+                const std::string& outputFile );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of samples of the last render() call.
+
+     @returns                   the number of rendered samples
+     */
+    size_t getNumRenderedSamples( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns a human readable description of the last error.
+
+     @returns                   the error message of the last failed call
+     */
+    const std::string& getErrorMessage( ) const;
+
+private:
+    //----------------------------------------------------------------------
+    /**
+     A file that is mapped into memory.
+     */
+    typedef struct renderFile {
+        std::string name;
+        int fd;
+        unsigned char* data;
+        size_t size;
+        std::vector<unsigned char> buffer;
+    } renderFile;
+
+    //----------------------------------------------------------------------
+    /**
+     A parameter change at a sample position.
+     */
+    typedef struct renderEvent {
+        size_t position;
+        double time;
+        size_t paramID;
+        double value;
+    } renderEvent;
+
+    //----------------------------------------------------------------------
+    /**
+     Maps a file for reading.
+
+     @returns                   0 for success, -1 for error
+     */
+    int openInput( const std::string& fileName,
+                   renderFile* file );
+
+    //----------------------------------------------------------------------
+    /**
+     Creates a file with the given size and maps it for writing.
+
+     The blocks of the file are allocated up front, so a full disk is
+     reported here instead of faulting while the samples are written.
+
+     @returns                   0 for success, -1 for error
+     */
+    int openOutput( const std::string& fileName,
+                    size_t size,
+                    renderFile* file );
+
+    //----------------------------------------------------------------------
+    /**
+     Unmaps a file and writes it back if it was opened for writing.
+
+     A mapped output file is flushed with msync() before it is unmapped,
+     so write errors are reported instead of being lost.
+
+     @returns                   0 for success, -1 for error
+     */
+    int closeFile( renderFile* file,
+                   bool write );
+
+    //----------------------------------------------------------------------
+    /**
+     Reads the header of a WAV file and sets the input format.
+
+     @returns                   0 for success, -1 for error
+     */
+    int parseWavHeader( const renderFile& file );
+
+    //----------------------------------------------------------------------
+    /**
+     Writes the header of a mono WAV file.
+     */
+    void writeWavHeader( unsigned char* data,
+                         size_t numSamples,
+                         double sampleRate );
+
+    //----------------------------------------------------------------------
+    /**
+     Thread pool task: thread 0 processes the current block, thread 1
+     decodes the next and encodes the previous block.
+     */
+    static void pipelineTask( void* context,
+                              size_t threadIndex );
+
+    //----------------------------------------------------------------------
+    /**
+     Processes a block and applies the automation events inside it.
+     */
+    void processBlock( size_t block );
+
+    //----------------------------------------------------------------------
+    /**
+     Decodes a block of the input file into its buffer.
+     */
+    void decodeBlock( size_t block );
+
+    //----------------------------------------------------------------------
+    /**
+     Encodes a block from its buffer into the output file.
+     */
+    void encodeBlock( size_t block );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the size of one sample in bytes.
+     */
+    static size_t sampleSize( renderSampleFormat format );
+
+    //----------------------------------------------------------------------
+    /** Tree to render */
+    wdfTree* tree;
+    /** Automation events sorted by time */
+    std::vector<renderEvent> events;
+    /** Index of the next event */
+    size_t nextEvent;
+    /** Format and rate of raw input files */
+    renderSampleFormat rawFormat;
+    double rawSampleRate;
+    /** Format of the output file */
+    renderSampleFormat outputFormat;
+    /** Format of the current input */
+    renderSampleFormat inputFormat;
+    /** Sample rate of the current input */
+    double inputSampleRate;
+    /** Offset of the first sample, distance between two samples and number
+        of samples of the current input */
+    size_t inputOffset;
+    size_t inputStride;
+    size_t numSamples;
+    /** Offset of the first sample of the output */
+    size_t outputOffset;
+    /** Mapped input and output files */
+    renderFile input;
+    renderFile output;
+    /** Double buffers of decoded input and unencoded output samples */
+    std::vector<double> inputBuffers[2];
+    std::vector<double> outputBuffers[2];
+    /** Block that is currently processed */
+    size_t currentBlock;
+    /** Pool with the compute and the I/O thread */
+    wdfThreadPool threadPool;
+    /** Description of the last error */
+    std::string errorMessage;
+
+};
+
+#endif  // RTWDF_RENDER_H_INCLUDED
@@ -0,0 +1,297 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_rootTopology.cpp
+ Created: 18 Oct 2026 2:40:00pm
+
+ ==============================================================================
+ */
+
+#include "rt-wdf_rootTopology.h"
+
+#include <set>
+#include <algorithm>
+
+
+//==============================================================================
+//                         R O O T   T O P O L O G Y
+//==============================================================================
+wdfRootTopology::wdfRootTopology( const std::vector<std::pair<size_t,size_t>>& subtreePorts,
+                                  const std::vector<std::pair<size_t,size_t>>& nlPorts ) : valid( true ),
+                                                                                          numNodes( 0 ) {
+    for( const std::vector<std::pair<size_t,size_t>>* ports : { &subtreePorts, &nlPorts } ) {
+        for( const std::pair<size_t,size_t>& port : *ports ) {
+            numNodes = std::max( numNodes, std::max( port.first, port.second ) );
+            valid = valid && ( port.first != port.second );
+        }
+    }
+
+    // node ids are shifted down by one, the reference node becomes -1
+    for( const std::pair<size_t,size_t>& port : subtreePorts ) {
+        subtreePos.push_back( std::make_pair( (int)port.first - 1, (int)port.second - 1 ) );
+    }
+    for( const std::pair<size_t,size_t>& port : nlPorts ) {
+        nlPos.push_back( std::make_pair( (int)port.first - 1, (int)port.second - 1 ) );
+    }
+
+    analyze( );
+}
+
+wdfRootTopology::wdfRootTopology( const mat& subtreeIncidence,
+                                  const mat& nlIncidence ) : valid( true ),
+                                                             numNodes( subtreeIncidence.n_rows ) {
+    valid = ( nlIncidence.n_cols == 0 || nlIncidence.n_rows == numNodes );
+
+    for( const mat* incidence : { &subtreeIncidence, &nlIncidence } ) {
+        std::vector<std::pair<int,int>>& pos = ( incidence == &subtreeIncidence ) ? subtreePos : nlPos;
+        for( size_t col = 0; col < incidence->n_cols; col++ ) {
+            std::pair<int,int> port( -1, -1 );
+            for( size_t row = 0; row < incidence->n_rows; row++ ) {
+                const double entry = incidence->at( row, col );
+                if( entry == 1.0 && port.first < 0 ) {
+                    port.first = (int)row;
+                }
+                else if( entry == -1.0 && port.second < 0 ) {
+                    port.second = (int)row;
+                }
+                else if( entry != 0.0 ) {
+                    valid = false;
+                }
+            }
+            valid = valid && ( port.first >= 0 || port.second >= 0 );
+            pos.push_back( port );
+        }
+    }
+
+    analyze( );
+}
+
+//----------------------------------------------------------------------
+size_t wdfRootTopology::getNumSubtrees( ) const {
+    return subtreePos.size();
+}
+
+//----------------------------------------------------------------------
+size_t wdfRootTopology::getNumNlPorts( ) const {
+    return nlPos.size();
+}
+
+//----------------------------------------------------------------------
+void wdfRootTopology::analyze( ) {
+    // graph of the nodal matrix, only subtree ports have a conductance
+    std::vector<std::set<size_t>> adjacency( numNodes );
+    for( const std::pair<int,int>& port : subtreePos ) {
+        if( port.first >= 0 && port.second >= 0 ) {
+            adjacency[port.first].insert( port.second );
+            adjacency[port.second].insert( port.first );
+        }
+    }
+
+    // minimum degree ordering; the neighbours of an eliminated node are
+    // exactly the structural nonzeros of its column in L (including fill-in)
+    std::vector<int> position( numNodes, -1 );
+    std::vector<std::vector<size_t>> eliminatedNeighbours( numNodes );
+    for( size_t step = 0; step < numNodes; step++ ) {
+        size_t pivot = numNodes;
+        for( size_t node = 0; node < numNodes; node++ ) {
+            if( position[node] < 0 &&
+                ( pivot == numNodes || adjacency[node].size() < adjacency[pivot].size() ) ) {
+                pivot = node;
+            }
+        }
+        position[pivot] = (int)step;
+
+        std::vector<size_t> neighbours( adjacency[pivot].begin(), adjacency[pivot].end() );
+        for( size_t a : neighbours ) {
+            adjacency[a].erase( pivot );
+            for( size_t b : neighbours ) {
+                if( a != b ) {
+                    adjacency[a].insert( b );
+                }
+            }
+        }
+        eliminatedNeighbours[step] = neighbours;
+    }
+
+    colPattern.assign( numNodes, std::vector<size_t>() );
+    rowPattern.assign( numNodes, std::vector<size_t>() );
+    for( size_t j = 0; j < numNodes; j++ ) {
+        for( size_t node : eliminatedNeighbours[j] ) {
+            colPattern[j].push_back( position[node] );
+        }
+        std::sort( colPattern[j].begin(), colPattern[j].end() );
+        for( size_t i : colPattern[j] ) {
+            rowPattern[i].push_back( j );
+        }
+    }
+
+    for( std::vector<std::pair<int,int>>* ports : { &subtreePos, &nlPos } ) {
+        for( std::pair<int,int>& port : *ports ) {
+            if( port.first >= (int)numNodes || port.second >= (int)numNodes ) {
+                valid = false;
+                continue;
+            }
+            port.first  = ( port.first  >= 0 ) ? position[port.first]  : -1;
+            port.second = ( port.second >= 0 ) ? position[port.second] : -1;
+        }
+    }
+
+    Y.zeros( numNodes, numNodes );
+    L.zeros( numNodes, numNodes );
+    D.zeros( numNodes );
+    Zs.zeros( numNodes, subtreePos.size() );
+    Zn.zeros( numNodes, nlPos.size() );
+}
+
+//----------------------------------------------------------------------
+int wdfRootTopology::factorize( const std::vector<double>& G ) {
+    Y.zeros( );
+    for( size_t k = 0; k < subtreePos.size(); k++ ) {
+        const int p = subtreePos[k].first;
+        const int q = subtreePos[k].second;
+        if( p >= 0 ) {
+            Y.at( p, p ) += G[k];
+        }
+        if( q >= 0 ) {
+            Y.at( q, q ) += G[k];
+        }
+        if( p >= 0 && q >= 0 ) {
+            Y.at( std::max( p, q ), std::min( p, q ) ) -= G[k];
+        }
+    }
+
+    for( size_t j = 0; j < numNodes; j++ ) {
+        double d = Y.at( j, j );
+        for( size_t k : rowPattern[j] ) {
+            d -= L.at( j, k ) * L.at( j, k ) * D.at( k );
+        }
+        if( !( d > 1.0e-12 * Y.at( j, j ) ) ) {
+            return -1;
+        }
+        D.at( j ) = d;
+        L.at( j, j ) = 1.0;
+
+        for( size_t i : colPattern[j] ) {
+            double s = Y.at( i, j );
+            for( size_t k : rowPattern[j] ) {
+                s -= L.at( i, k ) * L.at( j, k ) * D.at( k );
+            }
+            L.at( i, j ) = s / d;
+        }
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void wdfRootTopology::solvePort( double* z,
+                                 int from,
+                                 int to ) const {
+    if( from >= 0 ) {
+        z[from] = 1.0;
+    }
+    if( to >= 0 ) {
+        z[to] = -1.0;
+    }
+
+    for( size_t j = 0; j < numNodes; j++ ) {
+        if( z[j] != 0.0 ) {
+            for( size_t i : colPattern[j] ) {
+                z[i] -= L.at( i, j ) * z[j];
+            }
+        }
+    }
+    for( size_t j = 0; j < numNodes; j++ ) {
+        z[j] /= D.at( j );
+    }
+    for( size_t j = numNodes; j-- > 0; ) {
+        for( size_t i : colPattern[j] ) {
+            z[j] -= L.at( i, j ) * z[i];
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+int wdfRootTopology::setRootMatrData( matData* rootMatrixData,
+                                      double* Rp ) {
+    if( !valid ) {
+        return -1;
+    }
+
+    const size_t numSubtrees = subtreePos.size();
+    const size_t numNlPorts  = nlPos.size();
+
+    std::vector<double> G( numSubtrees );
+    for( size_t k = 0; k < numSubtrees; k++ ) {
+        G[k] = 1.0 / Rp[k];
+    }
+    if( factorize( G ) != 0 ) {
+        return -1;
+    }
+
+    Zs.zeros( );
+    for( size_t k = 0; k < numSubtrees; k++ ) {
+        solvePort( Zs.colptr( k ), subtreePos[k].first, subtreePos[k].second );
+    }
+    Zn.zeros( );
+    for( size_t l = 0; l < numNlPorts; l++ ) {
+        solvePort( Zn.colptr( l ), nlPos[l].first, nlPos[l].second );
+    }
+
+    // port voltage of a solution column z across the port (from, to)
+    auto portVoltage = []( const double* z, const std::pair<int,int>& port ) {
+        return ( port.first  >= 0 ? z[port.first]  : 0.0 ) -
+               ( port.second >= 0 ? z[port.second] : 0.0 );
+    };
+
+    if( numNlPorts == 0 ) {
+        rootMatrixData->Smat.set_size( numSubtrees, numSubtrees );
+        for( size_t k = 0; k < numSubtrees; k++ ) {
+            for( size_t i = 0; i < numSubtrees; i++ ) {
+                rootMatrixData->Smat.at( i, k ) = 2.0 * G[k] * portVoltage( Zs.colptr( k ), subtreePos[i] ) - ( i == k ? 1.0 : 0.0 );
+            }
+        }
+    }
+    else {
+        rootMatrixData->Emat.set_size( numNlPorts, numSubtrees );
+        rootMatrixData->Fmat.set_size( numNlPorts, numNlPorts );
+        rootMatrixData->Mmat.set_size( numSubtrees, numSubtrees );
+        rootMatrixData->Nmat.set_size( numSubtrees, numNlPorts );
+
+        for( size_t k = 0; k < numSubtrees; k++ ) {
+            for( size_t j = 0; j < numNlPorts; j++ ) {
+                rootMatrixData->Emat.at( j, k ) = G[k] * portVoltage( Zs.colptr( k ), nlPos[j] );
+            }
+            for( size_t i = 0; i < numSubtrees; i++ ) {
+                rootMatrixData->Mmat.at( i, k ) = 2.0 * G[k] * portVoltage( Zs.colptr( k ), subtreePos[i] ) - ( i == k ? 1.0 : 0.0 );
+            }
+        }
+        for( size_t l = 0; l < numNlPorts; l++ ) {
+            for( size_t j = 0; j < numNlPorts; j++ ) {
+                rootMatrixData->Fmat.at( j, l ) = -portVoltage( Zn.colptr( l ), nlPos[j] );
+            }
+            for( size_t i = 0; i < numSubtrees; i++ ) {
+                rootMatrixData->Nmat.at( i, l ) = -2.0 * portVoltage( Zn.colptr( l ), subtreePos[i] );
+            }
+        }
+    }
+
+    return 0;
+}
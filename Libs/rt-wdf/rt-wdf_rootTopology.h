@@ -0,0 +1,177 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_rootTopology.h
+ Created: 18 Oct 2026 2:40:00pm
+
+ ==============================================================================
+ */
+
+#ifndef RTWDF_ROOTTOPOLOGY_H_INCLUDED
+#define RTWDF_ROOTTOPOLOGY_H_INCLUDED
+
+//==============================================================================
+#include <vector>
+#include <utility>
+
+#include "rt-wdf_types.h"
+
+
+//==============================================================================
+class wdfRootTopology {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Description of the connection topology of an R-type or NL root that
+     derives the root matrices numerically from the subtree port resistances.
+
+     Every subtree is a two-terminal port between two circuit nodes of the
+     root. Seen from the root it is a voltage source (its ascending wave) in
+     series with its port resistance. Every non-linear port is a current
+     source whose current fNL flows from the first to the second node. The
+     port voltages are taken from the first to the second node.
+
+     Nodes are numbered 0..numNodes-1 where node 0 is the reference (ground)
+     node of the root.
+
+     The nodal matrix of the root has a fixed sparsity pattern, so its
+     fill-reducing ordering and the structure of the LDL^T factors are
+     computed once here. setRootMatrData() only redoes the numeric part.
+
+     @param subtreePorts        (from, to) node pairs of all subtree ports in
+                                the order of the tree's subtreeEntryNodes
+     @param nlPorts             (from, to) node pairs of all non-linear ports
+                                in the order of the NL solver's ports
+     */
+    wdfRootTopology( const std::vector<std::pair<size_t,size_t>>& subtreePorts,
+                     const std::vector<std::pair<size_t,size_t>>& nlPorts );
+
+    //----------------------------------------------------------------------
+    /**
+     Creates a root topology from reduced incidence matrices.
+
+     Each column describes one port with +1 in the row of its first node and
+     -1 in the row of its second node. Rows correspond to all circuit nodes
+     except the reference node, so ports to the reference node only have one
+     entry.
+
+     @param subtreeIncidence    (numNodes-1) x (numSubtrees) incidence matrix
+     @param nlIncidence         (numNodes-1) x (numNlPorts) incidence matrix
+     */
+    wdfRootTopology( const mat& subtreeIncidence,
+                     const mat& nlIncidence );
+
+    //----------------------------------------------------------------------
+    /**
+     Fills the root matrices according to the port resistances.
+
+     Without non-linear ports the S matrix for wdfRootRtype is filled,
+     otherwise the E,F,M,N matrices for wdfRootNL. The matrices are always
+     recalculated, since other code (sweep and sample-rate caches) may have
+     overwritten the matData object since the last call. Only the numeric
+     factorization is redone, which is cheap compared to the ad-hoc
+     inversions it replaces.
+
+     Call this from the tree's setRootMatrData( ) implementation.
+
+     @param rootMatrixData      is a pointer to the matData object of the
+                                root
+     @param Rp                  is a vector of port resistances of all
+                                subtrees of the root.
+
+     @returns                   0 for success, -1 for error (invalid topology
+                                or a node without resistive connection)
+     */
+    int setRootMatrData( matData* rootMatrixData,
+                         double* Rp );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of subtree ports of the root.
+
+     @returns                   the number of subtree ports
+     */
+    size_t getNumSubtrees( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of non-linear ports of the root.
+
+     @returns                   the number of non-linear ports
+     */
+    size_t getNumNlPorts( ) const;
+
+private:
+    //----------------------------------------------------------------------
+    /**
+     Computes the fill-reducing ordering of the nodal matrix and the
+     structure of its LDL^T factorization.
+     */
+    void analyze( );
+
+    //----------------------------------------------------------------------
+    /**
+     Numeric LDL^T factorization of the nodal matrix for conductances G.
+
+     @returns                   0 for success, -1 if the matrix is singular
+     */
+    int factorize( const std::vector<double>& G );
+
+    //----------------------------------------------------------------------
+    /**
+     Solves Y * z = e_from - e_to in place with the current factorization.
+
+     @param z                   pointer to a zeroed vector of size numNodes-1
+     @param from                permuted position of the first node or -1
+     @param to                  permuted position of the second node or -1
+     */
+    void solvePort( double* z,
+                    int from,
+                    int to ) const;
+
+    //----------------------------------------------------------------------
+    /** True if the topology description was valid */
+    bool valid;
+    /** Number of non-reference nodes */
+    size_t numNodes;
+    /** Permuted node positions of subtree ports (-1 for the reference) */
+    std::vector<std::pair<int,int>> subtreePos;
+    /** Permuted node positions of non-linear ports (-1 for the reference) */
+    std::vector<std::pair<int,int>> nlPos;
+    /** Structural nonzero rows i > j of column j of L */
+    std::vector<std::vector<size_t>> colPattern;
+    /** Structural nonzero columns k < i of row i of L */
+    std::vector<std::vector<size_t>> rowPattern;
+    /** Lower triangle of the permuted nodal matrix */
+    mat Y;
+    /** Unit lower triangular factor */
+    mat L;
+    /** Diagonal factor */
+    vec D;
+    /** Solutions for all subtree ports, one per column */
+    mat Zs;
+    /** Solutions for all non-linear ports, one per column */
+    mat Zn;
+
+};
+
+#endif  // RTWDF_ROOTTOPOLOGY_H_INCLUDED
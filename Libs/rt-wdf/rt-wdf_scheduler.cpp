@@ -0,0 +1,365 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_scheduler.cpp
+ Created: 18 Oct 2026 7:45:00pm
+
+ ==============================================================================
+ */
+
+#include "rt-wdf_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#ifdef __linux__
+    #include <dirent.h>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <time.h>
+#elif defined(__APPLE__)
+    #include <mach/mach.h>
+    #include <pthread.h>
+#elif defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#endif
+
+
+//==============================================================================
+//                      B A T C H   S C H E D U L E R
+//==============================================================================
+wdfBatchScheduler::wdfBatchScheduler( size_t numThreads,
+                                      size_t blockSize ) : threadPool( std::max( numThreads, (size_t)1 ) ),
+                                                           blockSize( std::max( blockSize, (size_t)1 ) ),
+                                                           remaining( 0 ) {
+    const size_t count = threadPool.getNumThreads( );
+    queues.reset( new batchQueue[count] );
+    threadNodes.assign( count, 0 );
+    threadCpus.assign( count, -1 );
+    pinned.assign( count, 0 );
+    readNumaTopology( );
+}
+
+wdfBatchScheduler::~wdfBatchScheduler( ) {
+
+}
+
+//----------------------------------------------------------------------
+int wdfBatchScheduler::addInstance( wdfTree* tree ) {
+    if( tree == NULL || tree->getNumThreads() > 1 ) {
+        return -1;
+    }
+
+    batchInstance instance;
+    instance.tree = tree;
+    instance.input = NULL;
+    instance.output = NULL;
+    instance.numSamples = 0;
+    instance.position = 0;
+    instance.homeThread = instances.size() % threadPool.getNumThreads();
+    instance.cpuTime = 0.0;
+    instances.push_back( instance );
+
+    return (int)( instances.size() - 1 );
+}
+
+//----------------------------------------------------------------------
+int wdfBatchScheduler::setBuffers( size_t instance,
+                                   const double* input,
+                                   double* output,
+                                   size_t numSamples ) {
+    if( instance >= instances.size() ||
+        ( numSamples > 0 && ( input == NULL || output == NULL ) ) ) {
+        return -1;
+    }
+
+    instances[instance].input = input;
+    instances[instance].output = output;
+    instances[instance].numSamples = numSamples;
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void wdfBatchScheduler::process( ) {
+    size_t count = 0;
+    for( size_t i = 0; i < instances.size(); i++ ) {
+        instances[i].position = 0;
+        if( instances[i].numSamples > 0 ) {
+            queues[instances[i].homeThread].jobs.push_back( i );
+            count++;
+        }
+    }
+    if( count == 0 ) {
+        return;
+    }
+    remaining = count;
+
+#ifdef __linux__
+    // the caller is not pinned, look up where it runs right now
+    int cpu = sched_getcpu( );
+    if( cpu >= 0 && (size_t)cpu < cpuNodes.size() ) {
+        threadNodes[0] = cpuNodes[cpu];
+    }
+#endif
+
+    threadPool.run( &wdfBatchScheduler::workerTask, this );
+}
+
+//----------------------------------------------------------------------
+void wdfBatchScheduler::workerTask( void* context,
+                                    size_t threadIndex ) {
+    wdfBatchScheduler* scheduler = static_cast<wdfBatchScheduler*>( context );
+    scheduler->pinThread( threadIndex );
+
+    size_t index;
+    while( scheduler->remaining > 0 ) {
+        if( !scheduler->takeJob( threadIndex, &index ) ) {
+            std::this_thread::yield( );
+            continue;
+        }
+
+        batchInstance& instance = scheduler->instances[index];
+        const size_t length = std::min( scheduler->blockSize,
+                                        instance.numSamples - instance.position );
+        const double startTime = threadCpuTime( );
+        instance.tree->processBlock( instance.input + instance.position,
+                                     instance.output + instance.position,
+                                     length );
+        instance.cpuTime += threadCpuTime( ) - startTime;
+        instance.position += length;
+        instance.homeThread = threadIndex;
+
+        if( instance.position < instance.numSamples ) {
+            // keep it in this thread's cache unless someone steals it
+            batchQueue& queue = scheduler->queues[threadIndex];
+            std::lock_guard<std::mutex> lock( queue.lock );
+            queue.jobs.push_front( index );
+        }
+        else {
+            scheduler->remaining--;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+bool wdfBatchScheduler::takeJob( size_t threadIndex,
+                                 size_t* instance ) {
+    {
+        batchQueue& queue = queues[threadIndex];
+        std::lock_guard<std::mutex> lock( queue.lock );
+        if( !queue.jobs.empty() ) {
+            *instance = queue.jobs.front( );
+            queue.jobs.pop_front( );
+            return true;
+        }
+    }
+
+    // steal from the back, threads on the same node first
+    const size_t count = threadPool.getNumThreads( );
+    for( int sameNode = 1; sameNode >= 0; sameNode-- ) {
+        for( size_t k = 1; k < count; k++ ) {
+            const size_t victim = ( threadIndex + k ) % count;
+            if( ( threadNodes[victim] == threadNodes[threadIndex] ) != ( sameNode == 1 ) ) {
+                continue;
+            }
+            batchQueue& queue = queues[victim];
+            std::lock_guard<std::mutex> lock( queue.lock );
+            if( !queue.jobs.empty() ) {
+                *instance = queue.jobs.back( );
+                queue.jobs.pop_back( );
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------
+size_t wdfBatchScheduler::getNumInstances( ) const {
+    return instances.size();
+}
+
+//----------------------------------------------------------------------
+double wdfBatchScheduler::getCpuTime( size_t instance ) const {
+    if( instance >= instances.size() ) {
+        return 0.0;
+    }
+    return instances[instance].cpuTime;
+}
+
+//----------------------------------------------------------------------
+void wdfBatchScheduler::resetCpuTime( ) {
+    for( size_t i = 0; i < instances.size(); i++ ) {
+        instances[i].cpuTime = 0.0;
+    }
+}
+
+//----------------------------------------------------------------------
+size_t wdfBatchScheduler::getThreadNode( size_t threadIndex ) const {
+    if( threadIndex >= threadNodes.size() ) {
+        return 0;
+    }
+    return threadNodes[threadIndex];
+}
+
+//----------------------------------------------------------------------
+void wdfBatchScheduler::readNumaTopology( ) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO( &allowed );
+    if( sched_getaffinity( 0, sizeof( allowed ), &allowed ) != 0 ) {
+        return;
+    }
+
+    // CPUs of every node that this process may run on
+    std::vector<std::vector<int>> nodeCpus;
+    std::vector<size_t> nodeIds;
+    DIR* dir = opendir( "/sys/devices/system/node" );
+    if( dir == NULL ) {
+        return;
+    }
+    while( struct dirent* entry = readdir( dir ) ) {
+        unsigned int node;
+        char tail;
+        if( sscanf( entry->d_name, "node%u%c", &node, &tail ) != 1 ) {
+            continue;
+        }
+        char path[64];
+        snprintf( path, sizeof( path ), "/sys/devices/system/node/node%u/cpulist", node );
+        FILE* file = fopen( path, "r" );
+        if( file == NULL ) {
+            continue;
+        }
+
+        // cpulist has the form "0-3,8,10-11"
+        std::vector<int> cpus;
+        int first;
+        while( fscanf( file, "%d", &first ) == 1 ) {
+            int last = first;
+            int separator = fgetc( file );
+            if( separator == '-' ) {
+                if( fscanf( file, "%d", &last ) != 1 ) {
+                    break;
+                }
+                separator = fgetc( file );
+            }
+            for( int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++ ) {
+                if( cpuNodes.size() <= (size_t)cpu ) {
+                    cpuNodes.resize( cpu + 1, 0 );
+                }
+                cpuNodes[cpu] = node;
+                if( CPU_ISSET( cpu, &allowed ) ) {
+                    cpus.push_back( cpu );
+                }
+            }
+            if( separator != ',' ) {
+                break;
+            }
+        }
+        fclose( file );
+
+        if( !cpus.empty() ) {
+            nodeCpus.push_back( cpus );
+            nodeIds.push_back( node );
+        }
+    }
+    closedir( dir );
+    if( nodeCpus.empty() ) {
+        return;
+    }
+
+    // alternate between the nodes so that few threads already use all of them
+    std::vector<int> cpuOrder;
+    std::vector<size_t> nodeOrder;
+    for( size_t k = 0; cpuOrder.size() < (size_t)CPU_COUNT( &allowed ); k++ ) {
+        bool found = false;
+        for( size_t n = 0; n < nodeCpus.size(); n++ ) {
+            if( k < nodeCpus[n].size() ) {
+                cpuOrder.push_back( nodeCpus[n][k] );
+                nodeOrder.push_back( nodeIds[n] );
+                found = true;
+            }
+        }
+        if( !found ) {
+            break;
+        }
+    }
+
+    for( size_t t = 0; t < threadCpus.size(); t++ ) {
+        threadNodes[t] = nodeOrder[t % nodeOrder.size()];
+        if( SCHEDULER_PIN_THREADS && t > 0 ) {
+            threadCpus[t] = cpuOrder[t % cpuOrder.size()];
+        }
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+void wdfBatchScheduler::pinThread( size_t threadIndex ) {
+    if( pinned[threadIndex] ) {
+        return;
+    }
+    pinned[threadIndex] = 1;
+
+#ifdef __linux__
+    if( threadCpus[threadIndex] >= 0 ) {
+        cpu_set_t cpus;
+        CPU_ZERO( &cpus );
+        CPU_SET( threadCpus[threadIndex], &cpus );
+        pthread_setaffinity_np( pthread_self(), sizeof( cpus ), &cpus );
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+double wdfBatchScheduler::threadCpuTime( ) {
+#ifdef __linux__
+    struct timespec now;
+    if( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &now ) == 0 ) {
+        return now.tv_sec + 1.0e-9 * now.tv_nsec;
+    }
+#elif defined(__APPLE__)
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+    if( thread_info( pthread_mach_thread_np( pthread_self() ), THREAD_BASIC_INFO,
+                     reinterpret_cast<thread_info_t>( &info ), &count ) == KERN_SUCCESS ) {
+        return info.user_time.seconds + info.system_time.seconds +
+               1.0e-6 * ( info.user_time.microseconds + info.system_time.microseconds );
+    }
+#elif defined(_WIN32)
+    FILETIME creationTime;
+    FILETIME exitTime;
+    FILETIME kernelTime;
+    FILETIME userTime;
+    if( GetThreadTimes( GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime ) ) {
+        // 100 ns units
+        const unsigned long long kernel = ( (unsigned long long)kernelTime.dwHighDateTime << 32 ) | kernelTime.dwLowDateTime;
+        const unsigned long long user = ( (unsigned long long)userTime.dwHighDateTime << 32 ) | userTime.dwLowDateTime;
+        return 1.0e-7 * ( kernel + user );
+    }
+#endif
+    return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
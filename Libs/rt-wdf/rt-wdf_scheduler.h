@@ -0,0 +1,246 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_scheduler.h
+ Created: 18 Oct 2026 7:45:00pm
+
+ ==============================================================================
+ */
+
+#ifndef RTWDF_SCHEDULER_H_INCLUDED
+#define RTWDF_SCHEDULER_H_INCLUDED
+
+//==============================================================================
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rt-wdf.h"
+#include "rt-wdf_threadPool.h"
+
+
+//==============================================================================
+// Batch scheduler config parameters
+
+/** Default number of samples that are processed per job */
+#define SCHEDULER_BLOCK_SIZE    512
+/** Pin the worker threads to cores, spread over the NUMA nodes (Linux) */
+#define SCHEDULER_PIN_THREADS   1
+
+
+//==============================================================================
+class wdfBatchScheduler {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Scheduler that processes many independent trees on a thread pool.
+
+     Every instance is a tree with an input and an output buffer. process()
+     cuts the buffers into blocks and runs them on all threads of a
+     wdfThreadPool. Each thread has a queue of instances: it keeps working
+     on the instance it processed last (its state stays in the thread's
+     cache) and idle threads steal instances from the back of the other
+     queues between two blocks. The blocks of one instance are always
+     processed in order and by one thread at a time.
+
+     On Linux the worker threads are pinned round-robin to the NUMA nodes
+     listed in /sys/devices/system/node and thieves prefer queues of their
+     own node. An instance starts each process() call on the thread that
+     processed it last, so its memory stays local to that node.
+
+     The thread CPU time spent in every instance is accumulated and can be
+     queried with getCpuTime().
+
+     @param numThreads          total number of threads including the thread
+                                that calls process()
+     @param blockSize           number of samples per job
+     */
+    wdfBatchScheduler( size_t numThreads,
+                       size_t blockSize = SCHEDULER_BLOCK_SIZE );
+
+    //----------------------------------------------------------------------
+    /**
+     Deconstructor
+     */
+    ~wdfBatchScheduler( );
+
+    //----------------------------------------------------------------------
+    /**
+     Adds a tree to the scheduler. The tree must be initialized and adapted
+     and must not use its own thread pool (see wdfTree::setNumThreads()).
+     The scheduler does not take ownership.
+
+     @param tree                is a pointer to the tree
+
+     @returns                   the index of the instance, -1 for error
+     */
+    int addInstance( wdfTree* tree );
+
+    //----------------------------------------------------------------------
+    /**
+     Sets the buffers that the next call to process() works on.
+
+     @param instance            index of the instance
+     @param input               array of numSamples input values
+     @param output              array to store numSamples output values, may
+                                be the same as input
+     @param numSamples          number of samples to process, 0 to skip the
+                                instance
+
+     @returns                   0 for success, -1 for error
+     */
+    int setBuffers( size_t instance,
+                    const double* input,
+                    double* output,
+                    size_t numSamples );
+
+    //----------------------------------------------------------------------
+    /**
+     Processes the buffers of all instances and returns when all of them
+     are done. Must not be called from two threads at once.
+     */
+    void process( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of instances.
+
+     @returns                   the number of instances
+     */
+    size_t getNumInstances( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the thread CPU time that was spent in an instance since it was
+     added or since the last call to resetCpuTime().
+
+     @param instance            index of the instance
+
+     @returns                   the CPU time in seconds
+     */
+    double getCpuTime( size_t instance ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Resets the CPU time of all instances.
+     */
+    void resetCpuTime( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the NUMA node that a thread was pinned to.
+
+     @param threadIndex         index of the thread, 0 is the caller of
+                                process()
+
+     @returns                   the NUMA node, 0 if unknown
+     */
+    size_t getThreadNode( size_t threadIndex ) const;
+
+private:
+    //----------------------------------------------------------------------
+    /**
+     Thread pool task that processes jobs until all instances are done.
+     */
+    static void workerTask( void* context,
+                            size_t threadIndex );
+
+    //----------------------------------------------------------------------
+    /**
+     Takes the next job for a thread from its own queue or steals one.
+
+     @returns                   true if a job was found
+     */
+    bool takeJob( size_t threadIndex,
+                  size_t* instance );
+
+    //----------------------------------------------------------------------
+    /**
+     Reads the NUMA nodes and their CPUs and decides which thread is
+     pinned to which CPU.
+     */
+    void readNumaTopology( );
+
+    //----------------------------------------------------------------------
+    /**
+     Pins the calling worker thread to its CPU.
+     */
+    void pinThread( size_t threadIndex );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the CPU time of the calling thread in seconds: user and system
+     time from CLOCK_THREAD_CPUTIME_ID on Linux, thread_info() on macOS
+     and GetThreadTimes() on Windows. Other platforms (or a failing call)
+     fall back to the wall time of std::chrono::steady_clock, which also
+     counts the time the thread was descheduled.
+     */
+    static double threadCpuTime( );
+
+    //----------------------------------------------------------------------
+    /**
+     A tree with its buffers and accounting.
+     */
+    typedef struct batchInstance {
+        wdfTree* tree;
+        const double* input;
+        double* output;
+        size_t numSamples;
+        size_t position;
+        size_t homeThread;
+        double cpuTime;
+    } batchInstance;
+
+    //----------------------------------------------------------------------
+    /**
+     Queue of instances of one thread.
+     */
+    typedef struct batchQueue {
+        std::mutex lock;
+        std::deque<size_t> jobs;
+    } batchQueue;
+
+    //----------------------------------------------------------------------
+    /** Threads that process the jobs */
+    wdfThreadPool threadPool;
+    /** Number of samples per job */
+    size_t blockSize;
+    /** All instances */
+    std::vector<batchInstance> instances;
+    /** One queue per thread */
+    std::unique_ptr<batchQueue[]> queues;
+    /** NUMA node of each thread */
+    std::vector<size_t> threadNodes;
+    /** CPU of each thread, -1 to leave the thread unpinned */
+    std::vector<int> threadCpus;
+    /** NUMA node of each CPU id */
+    std::vector<size_t> cpuNodes;
+    /** True for threads that are already pinned */
+    std::vector<char> pinned;
+    /** Number of instances that are not finished */
+    std::atomic<size_t> remaining;
+
+};
+
+#endif  // RTWDF_SCHEDULER_H_INCLUDED
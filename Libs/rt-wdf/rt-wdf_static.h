@@ -0,0 +1,776 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_static.h
+ Created: 18 Oct 2026 5:20:00pm
+
+ ==============================================================================
+ */
+
+#ifndef RTWDF_STATIC_H_INCLUDED
+#define RTWDF_STATIC_H_INCLUDED
+
+//==============================================================================
+// Static (template composed) WDF trees.
+//
+// Header-only counterpart of the adapted tree nodes and unadapted root
+// elements in rt-wdf.h for fixed topologies. The tree structure is a type,
+// e.g.
+//
+//     typedef wdfStaticSeries<wdfStaticResVSource,
+//                             wdfStaticParallel<wdfStaticRes, wdfStaticCap>> Subtree;
+//     wdfStaticTree<wdfStaticUnterminatedRes, Subtree> tree( ... );
+//
+// so pullWaveUp() and pushWaveDown() are resolved at compile time and inline
+// into a single function without virtual calls, pointers or heap memory.
+// All nodes use the same wave equations as the runtime nodes
+// (rt-wdf_equations.h), the results are identical.
+//
+// Coefficients only change in adaptTree(). After changing a component value
+// (e.g. tree.subtree.right.left.R) call adaptTree() again.
+//
+// Every subtree node provides:
+//     double adaptPorts( double sampleRate )     returns the port resistance
+//     double pullWaveUp( )                       returns the ascending wave
+//     void pushWaveDown( double descendingWave )
+// and every root element provides:
+//     void setPortResistance( double Rp, double sampleRate )
+//     double calculateDownB( double ascendingWave )
+//==============================================================================
+#include "rt-wdf_equations.h"
+
+
+//==============================================================================
+class wdfStaticNode {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Upfacing port of a static tree node. Base class of all static nodes,
+     it holds the state that a wdfPort holds for runtime nodes.
+     */
+    constexpr wdfStaticNode( ) : Rp( 0 ),
+                                 a( 0 ),
+                                 b( 0 ) {
+    }
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the voltage across the upfacing port.
+
+     @returns                   the port voltage (a+b)/2
+     */
+    double getPortVoltage( ) const {
+        return ( a + b ) / 2.0;
+    }
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the current through the upfacing port.
+
+     @returns                   the port current (a-b)/(2*Rp)
+     */
+    double getPortCurrent( ) const {
+        return ( a - b ) / ( 2.0 * Rp );
+    }
+
+    //----------------------------------------------------------------------
+    /** Port resistance of the upfacing port */
+    double Rp;
+    /** Wave coming down from the parent */
+    double a;
+    /** Wave going up to the parent */
+    double b;
+
+};
+
+
+#pragma mark - Static Adapters
+//==============================================================================
+template<typename Left, typename Right>
+class wdfStaticSeries : public wdfStaticNode {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static series adapter, see wdfTerminatedSeries.
+
+     @param left                left child node
+     @param right               right child node
+     */
+    constexpr wdfStaticSeries( const Left& left,
+                               const Right& right ) : wdfStaticNode( ),
+                                                      left( left ),
+                                                      right( right ),
+                                                      yl( 0 ),
+                                                      yr( 0 ) {
+    }
+
+    //----------------------------------------------------------------------
+    double adaptPorts( double sampleRate ) {
+        const double Rl = left.adaptPorts( sampleRate );
+        const double Rr = right.adaptPorts( sampleRate );
+        Rp = wdfSeriesUpRes( Rl, Rr );
+        yl = wdfSeriesCoeff( Rp, Rl, Rr );
+        yr = 1.0 - yl;
+        return Rp;
+    }
+
+    //----------------------------------------------------------------------
+    inline double pullWaveUp( ) {
+        b = wdfSeriesUpB( left.pullWaveUp( ), right.pullWaveUp( ) );
+        return b;
+    }
+
+    //----------------------------------------------------------------------
+    inline void pushWaveDown( double descendingWave ) {
+        a = descendingWave;
+        double bl, br;
+        wdfSeriesDownB( yl, yr, left.b, right.b, descendingWave, &bl, &br );
+        left.pushWaveDown( bl );
+        right.pushWaveDown( br );
+    }
+
+    //----------------------------------------------------------------------
+    /** Left child node */
+    Left left;
+    /** Right child node */
+    Right right;
+
+private:
+    //----------------------------------------------------------------------
+    /** Scattering coefficient of the left port */
+    double yl;
+    /** Scattering coefficient of the right port */
+    double yr;
+
+};
+
+
+//==============================================================================
+template<typename Left, typename Right>
+class wdfStaticParallel : public wdfStaticNode {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static parallel adapter, see wdfTerminatedParallel.
+
+     @param left                left child node
+     @param right               right child node
+     */
+    constexpr wdfStaticParallel( const Left& left,
+                                 const Right& right ) : wdfStaticNode( ),
+                                                        left( left ),
+                                                        right( right ),
+                                                        dl( 0 ),
+                                                        dr( 0 ) {
+    }
+
+    //----------------------------------------------------------------------
+    double adaptPorts( double sampleRate ) {
+        const double Rl = left.adaptPorts( sampleRate );
+        const double Rr = right.adaptPorts( sampleRate );
+        Rp = wdfParallelUpRes( Rl, Rr );
+        dl = wdfParallelCoeff( 1.0 / Rp, 1.0 / Rl, 1.0 / Rr );
+        dr = 1.0 - dl;
+        return Rp;
+    }
+
+    //----------------------------------------------------------------------
+    inline double pullWaveUp( ) {
+        const double al = left.pullWaveUp( );
+        const double ar = right.pullWaveUp( );
+        b = wdfParallelUpB( dl, dr, al, ar );
+        return b;
+    }
+
+    //----------------------------------------------------------------------
+    inline void pushWaveDown( double descendingWave ) {
+        a = descendingWave;
+        double bl, br;
+        wdfParallelDownB( 1.0, dl, dr, left.b, right.b, descendingWave, &bl, &br );
+        left.pushWaveDown( bl );
+        right.pushWaveDown( br );
+    }
+
+    //----------------------------------------------------------------------
+    /** Left child node */
+    Left left;
+    /** Right child node */
+    Right right;
+
+private:
+    //----------------------------------------------------------------------
+    /** Scattering coefficient of the left port */
+    double dl;
+    /** Scattering coefficient of the right port */
+    double dr;
+
+};
+
+
+//==============================================================================
+template<typename Child>
+class wdfStaticInverter : public wdfStaticNode {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static inverter, see wdfInverter.
+
+     @param child               child node
+     */
+    constexpr wdfStaticInverter( const Child& child ) : wdfStaticNode( ),
+                                                        child( child ) {
+    }
+
+    //----------------------------------------------------------------------
+    double adaptPorts( double sampleRate ) {
+        Rp = child.adaptPorts( sampleRate );
+        return Rp;
+    }
+
+    //----------------------------------------------------------------------
+    inline double pullWaveUp( ) {
+        b = wdfInverterB( child.pullWaveUp( ) );
+        return b;
+    }
+
+    //----------------------------------------------------------------------
+    inline void pushWaveDown( double descendingWave ) {
+        a = descendingWave;
+        child.pushWaveDown( wdfInverterB( descendingWave ) );
+    }
+
+    //----------------------------------------------------------------------
+    /** Child node */
+    Child child;
+
+};
+
+
+#pragma mark - Static Leafs
+//==============================================================================
+class wdfStaticCap : public wdfStaticNode {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static adapted capacitor, see wdfTerminatedCap.
+
+     @param C                   capacitance
+     */
+    constexpr wdfStaticCap( double C ) : wdfStaticNode( ),
+                                         C( C ),
+                                         prevA( 0 ) {
+    }
+
+    //----------------------------------------------------------------------
+    double adaptPorts( double sampleRate ) {
+        Rp = wdfCapRes( sampleRate, C );
+        return Rp;
+    }
+
+    //----------------------------------------------------------------------
+    inline double pullWaveUp( ) {
+        b = prevA;
+        return b;
+    }
+
+    //----------------------------------------------------------------------
+    inline void pushWaveDown( double descendingWave ) {
+        a = descendingWave;
+        prevA = descendingWave;
+    }
+
+    //----------------------------------------------------------------------
+    /** Capacitance */
+    double C;
+    /** Incident wave of the last sample */
+    double prevA;
+
+};
+
+
+//==============================================================================
+class wdfStaticInd : public wdfStaticNode {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static adapted inductor, see wdfTerminatedInd.
+
+     @param L                   inductance
+     */
+    constexpr wdfStaticInd( double L ) : wdfStaticNode( ),
+                                         L( L ),
+                                         prevA( 0 ) {
+    }
+
+    //----------------------------------------------------------------------
+    double adaptPorts( double sampleRate ) {
+        Rp = wdfIndRes( sampleRate, L );
+        return Rp;
+    }
+
+    //----------------------------------------------------------------------
+    inline double pullWaveUp( ) {
+        b = prevA;
+        return b;
+    }
+
+    //----------------------------------------------------------------------
+    inline void pushWaveDown( double descendingWave ) {
+        a = descendingWave;
+        prevA = -1.0 * descendingWave;
+    }
+
+    //----------------------------------------------------------------------
+    /** Inductance */
+    double L;
+    /** Negated incident wave of the last sample */
+    double prevA;
+
+};
+
+
+//==============================================================================
+class wdfStaticRes : public wdfStaticNode {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static adapted resistor, see wdfTerminatedRes.
+
+     @param R                   resistance
+     */
+    constexpr wdfStaticRes( double R ) : wdfStaticNode( ),
+                                         R( R ) {
+    }
+
+    //----------------------------------------------------------------------
+    double adaptPorts( double /*sampleRate*/ ) {
+        Rp = R;
+        return Rp;
+    }
+
+    //----------------------------------------------------------------------
+    inline double pullWaveUp( ) {
+        b = 0.0;
+        return b;
+    }
+
+    //----------------------------------------------------------------------
+    inline void pushWaveDown( double descendingWave ) {
+        a = descendingWave;
+    }
+
+    //----------------------------------------------------------------------
+    /** Resistance */
+    double R;
+
+};
+
+
+//==============================================================================
+class wdfStaticResVSource : public wdfStaticNode {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static resistive voltage source, see wdfTerminatedResVSource.
+
+     @param Vs                  source voltage
+     @param RSer                series resistance
+     */
+    constexpr wdfStaticResVSource( double Vs,
+                                   double RSer ) : wdfStaticNode( ),
+                                                   Vs( Vs ),
+                                                   RSer( RSer ) {
+    }
+
+    //----------------------------------------------------------------------
+    double adaptPorts( double /*sampleRate*/ ) {
+        Rp = RSer;
+        return Rp;
+    }
+
+    //----------------------------------------------------------------------
+    inline double pullWaveUp( ) {
+        b = Vs;
+        return b;
+    }
+
+    //----------------------------------------------------------------------
+    inline void pushWaveDown( double descendingWave ) {
+        a = descendingWave;
+    }
+
+    //----------------------------------------------------------------------
+    /** Source voltage, may be changed at any time */
+    double Vs;
+    /** Series resistance */
+    double RSer;
+
+};
+
+
+//==============================================================================
+class wdfStaticResCSource : public wdfStaticNode {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static resistive current source, see wdfTerminatedResCSource.
+
+     @param Is                  source current
+     @param RPar                parallel resistance
+     */
+    constexpr wdfStaticResCSource( double Is,
+                                   double RPar ) : wdfStaticNode( ),
+                                                   Is( Is ),
+                                                   RPar( RPar ) {
+    }
+
+    //----------------------------------------------------------------------
+    double adaptPorts( double /*sampleRate*/ ) {
+        Rp = RPar;
+        return Rp;
+    }
+
+    //----------------------------------------------------------------------
+    inline double pullWaveUp( ) {
+        b = RPar * Is;
+        return b;
+    }
+
+    //----------------------------------------------------------------------
+    inline void pushWaveDown( double descendingWave ) {
+        a = descendingWave;
+    }
+
+    //----------------------------------------------------------------------
+    /** Source current, may be changed at any time */
+    double Is;
+    /** Parallel resistance */
+    double RPar;
+
+};
+
+
+#pragma mark - Static Root Elements
+//==============================================================================
+class wdfStaticIdealVSource {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static ideal voltage source at the root, see wdfIdealVSource.
+
+     @param Vs                  source voltage
+     */
+    constexpr wdfStaticIdealVSource( double Vs ) : Vs( Vs ) {
+    }
+
+    //----------------------------------------------------------------------
+    void setPortResistance( double /*Rp*/,
+                            double /*sampleRate*/ ) {
+    }
+
+    //----------------------------------------------------------------------
+    inline double calculateDownB( double ascendingWave ) {
+        return wdfIdealVSourceB( Vs, ascendingWave );
+    }
+
+    //----------------------------------------------------------------------
+    /** Source voltage, may be changed at any time */
+    double Vs;
+
+};
+
+
+//==============================================================================
+class wdfStaticIdealCSource {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static ideal current source at the root, see wdfIdealCSource.
+
+     @param Is                  source current
+     */
+    constexpr wdfStaticIdealCSource( double Is ) : Is( Is ),
+                                                   Rp( 0 ) {
+    }
+
+    //----------------------------------------------------------------------
+    void setPortResistance( double Rp,
+                            double /*sampleRate*/ ) {
+        this->Rp = Rp;
+    }
+
+    //----------------------------------------------------------------------
+    inline double calculateDownB( double ascendingWave ) {
+        return wdfIdealCSourceB( Rp, Is, ascendingWave );
+    }
+
+    //----------------------------------------------------------------------
+    /** Source current, may be changed at any time */
+    double Is;
+
+private:
+    //----------------------------------------------------------------------
+    /** Port resistance of the subtree */
+    double Rp;
+
+};
+
+
+//==============================================================================
+class wdfStaticSwitch {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static ideal switch at the root, see wdfUnterminatedSwitch.
+
+     @param position            0 for an open, 1 for a closed switch
+     */
+    constexpr wdfStaticSwitch( int position ) : position( position ) {
+    }
+
+    //----------------------------------------------------------------------
+    void setPortResistance( double /*Rp*/,
+                            double /*sampleRate*/ ) {
+    }
+
+    //----------------------------------------------------------------------
+    inline double calculateDownB( double ascendingWave ) {
+        return ( position == 0 ) ? +1.0 * ascendingWave : -1.0 * ascendingWave;
+    }
+
+    //----------------------------------------------------------------------
+    /** Switch position, may be changed at any time */
+    int position;
+
+};
+
+
+//==============================================================================
+class wdfStaticUnterminatedRes {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static unadapted resistor at the root, see wdfUnterminatedRes.
+
+     @param R                   resistance
+     */
+    constexpr wdfStaticUnterminatedRes( double R ) : R( R ),
+                                                     reflectionCoeff( 0 ) {
+    }
+
+    //----------------------------------------------------------------------
+    void setPortResistance( double Rp,
+                            double /*sampleRate*/ ) {
+        reflectionCoeff = wdfUnterminatedResCoeff( Rp, R );
+    }
+
+    //----------------------------------------------------------------------
+    inline double calculateDownB( double ascendingWave ) {
+        return reflectionCoeff * ascendingWave;
+    }
+
+    //----------------------------------------------------------------------
+    /** Resistance */
+    double R;
+
+private:
+    //----------------------------------------------------------------------
+    /** Reflection coefficient */
+    double reflectionCoeff;
+
+};
+
+
+//==============================================================================
+class wdfStaticUnterminatedCap {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static unadapted capacitor at the root, see wdfUnterminatedCap.
+
+     @param C                   capacitance
+     */
+    constexpr wdfStaticUnterminatedCap( double C ) : C( C ),
+                                                     prevA( 0 ),
+                                                     prevB( 0 ),
+                                                     reflectionCoeff( 0 ) {
+    }
+
+    //----------------------------------------------------------------------
+    void setPortResistance( double Rp,
+                            double sampleRate ) {
+        reflectionCoeff = wdfUnterminatedCapCoeff( Rp, sampleRate, C );
+    }
+
+    //----------------------------------------------------------------------
+    inline double calculateDownB( double ascendingWave ) {
+        prevB = wdfUnterminatedCapB( reflectionCoeff, ascendingWave, prevA, prevB );
+        prevA = ascendingWave;
+        return prevB;
+    }
+
+    //----------------------------------------------------------------------
+    /** Capacitance */
+    double C;
+    /** Ascending wave of the last sample */
+    double prevA;
+    /** Reflected wave of the last sample */
+    double prevB;
+
+private:
+    //----------------------------------------------------------------------
+    /** Reflection coefficient */
+    double reflectionCoeff;
+
+};
+
+
+//==============================================================================
+class wdfStaticUnterminatedInd {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static unadapted inductor at the root, see wdfUnterminatedInd.
+
+     @param L                   inductance
+     */
+    constexpr wdfStaticUnterminatedInd( double L ) : L( L ),
+                                                     prevA( 0 ),
+                                                     prevB( 0 ),
+                                                     reflectionCoeff( 0 ) {
+    }
+
+    //----------------------------------------------------------------------
+    void setPortResistance( double Rp,
+                            double sampleRate ) {
+        reflectionCoeff = wdfUnterminatedIndCoeff( Rp, sampleRate, L );
+    }
+
+    //----------------------------------------------------------------------
+    inline double calculateDownB( double ascendingWave ) {
+        prevB = wdfUnterminatedIndB( reflectionCoeff, ascendingWave, prevA, prevB );
+        prevA = ascendingWave;
+        return prevB;
+    }
+
+    //----------------------------------------------------------------------
+    /** Inductance */
+    double L;
+    /** Ascending wave of the last sample */
+    double prevA;
+    /** Reflected wave of the last sample */
+    double prevB;
+
+private:
+    //----------------------------------------------------------------------
+    /** Reflection coefficient */
+    double reflectionCoeff;
+
+};
+
+
+#pragma mark - Static Tree
+//==============================================================================
+template<typename RootElement, typename Subtree>
+class wdfStaticTree {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Static tree with a single subtree below an unadapted root element,
+     the static counterpart of a wdfTree with a wdfRootSimple.
+
+     @param root                root element
+     @param subtree             subtree below the root
+     */
+    constexpr wdfStaticTree( const RootElement& root,
+                             const Subtree& subtree ) : root( root ),
+                                                        subtree( subtree ),
+                                                        treeSampleRate( 1 ) {
+    }
+
+    //----------------------------------------------------------------------
+    /**
+     Sets the sample rate. Call adaptTree() afterwards.
+
+     @param fs                  sample rate in Hz
+     */
+    void setSamplerate( double fs ) {
+        treeSampleRate = fs;
+    }
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the sample rate of the tree.
+
+     @returns                   the sample rate in Hz
+     */
+    double getSamplerate( ) const {
+        return treeSampleRate;
+    }
+
+    //----------------------------------------------------------------------
+    /**
+     Recalculates all port resistances and coefficients. Call this after
+     the sample rate or a component value changed.
+     */
+    void adaptTree( ) {
+        root.setPortResistance( subtree.adaptPorts( treeSampleRate ), treeSampleRate );
+    }
+
+    //----------------------------------------------------------------------
+    /**
+     Computes one sample: pulls the waves up to the root, reflects them at
+     the root element and pushes them back down.
+     */
+    inline void cycleWave( ) {
+        subtree.pushWaveDown( root.calculateDownB( subtree.pullWaveUp( ) ) );
+    }
+
+    //----------------------------------------------------------------------
+    /** Root element */
+    RootElement root;
+    /** Subtree below the root */
+    Subtree subtree;
+
+private:
+    //----------------------------------------------------------------------
+    /** Sample rate of the tree */
+    double treeSampleRate;
+
+};
+
+#endif  // RTWDF_STATIC_H_INCLUDED
@@ -0,0 +1,192 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_sweep.cpp
+ Created: 18 Oct 2026 9:05:00pm
+
+ ==============================================================================
+ */
+
+#include "rt-wdf_sweep.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+//==============================================================================
+//                      P A R A M E T E R   S W E E P
+//==============================================================================
+wdfParameterSweep::wdfParameterSweep( wdfTreeFactory factory,
+                                      void* context,
+                                      size_t numThreads ) : factory( factory ),
+                                                            factoryContext( context ),
+                                                            input( NULL ),
+                                                            numSamples( 0 ),
+                                                            doubleOutput( NULL ),
+                                                            floatOutput( NULL ),
+                                                            threadPool( std::max( numThreads, (size_t)1 ) ) {
+    trees.resize( threadPool.getNumThreads() );
+    currentValues.resize( threadPool.getNumThreads() );
+    failed.assign( threadPool.getNumThreads(), 0 );
+}
+
+wdfParameterSweep::~wdfParameterSweep( ) {
+
+}
+
+//----------------------------------------------------------------------
+int wdfParameterSweep::addAxis( size_t paramID,
+                                const std::vector<double>& values ) {
+    if( values.empty() ) {
+        errorMessage = "an axis needs at least one value";
+        return -1;
+    }
+
+    sweepAxis axis;
+    axis.paramID = paramID;
+    axis.values = values;
+    axes.push_back( axis );
+    return 0;
+}
+
+//----------------------------------------------------------------------
+size_t wdfParameterSweep::getNumPoints( ) const {
+    size_t count = 1;
+    for( size_t i = 0; i < axes.size(); i++ ) {
+        count *= axes[i].values.size( );
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------
+double wdfParameterSweep::getPointValue( size_t point,
+                                         size_t axis ) const {
+    for( size_t i = axes.size(); i-- > axis + 1; ) {
+        point /= axes[i].values.size( );
+    }
+    return axes[axis].values[point % axes[axis].values.size()];
+}
+
+//----------------------------------------------------------------------
+void wdfParameterSweep::setInput( const double* input,
+                                  size_t numSamples ) {
+    this->input = input;
+    this->numSamples = numSamples;
+}
+
+//----------------------------------------------------------------------
+int wdfParameterSweep::render( double* output ) {
+    return renderAll( output, NULL );
+}
+
+//----------------------------------------------------------------------
+int wdfParameterSweep::render( float* output ) {
+    return renderAll( NULL, output );
+}
+
+//----------------------------------------------------------------------
+const std::string& wdfParameterSweep::getErrorMessage( ) const {
+    return errorMessage;
+}
+
+//----------------------------------------------------------------------
+int wdfParameterSweep::renderAll( double* doubleOutput,
+                                  float* floatOutput ) {
+    if( input == NULL && numSamples > 0 ) {
+        errorMessage = "no input set";
+        return -1;
+    }
+
+    this->doubleOutput = doubleOutput;
+    this->floatOutput = floatOutput;
+    threadPool.run( &wdfParameterSweep::renderTask, this );
+
+    for( size_t t = 0; t < failed.size(); t++ ) {
+        if( failed[t] ) {
+            errorMessage = "the tree factory failed";
+            return -1;
+        }
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void wdfParameterSweep::renderTask( void* context,
+                                    size_t threadIndex ) {
+    static_cast<wdfParameterSweep*>( context )->renderPoints( threadIndex );
+}
+
+//----------------------------------------------------------------------
+void wdfParameterSweep::renderPoints( size_t threadIndex ) {
+    // contiguous ranges keep neighboring grid points on one instance
+    const size_t numThreads = threadPool.getNumThreads( );
+    const size_t numPoints = getNumPoints( );
+    const size_t first = numPoints * threadIndex / numThreads;
+    const size_t last = numPoints * ( threadIndex + 1 ) / numThreads;
+    if( first == last ) {
+        return;
+    }
+
+    // the instance is created by the thread that uses it
+    std::unique_ptr<wdfTree>& tree = trees[threadIndex];
+    std::vector<double>& values = currentValues[threadIndex];
+    if( !tree ) {
+        tree.reset( factory( factoryContext ) );
+        if( !tree ) {
+            failed[threadIndex] = 1;
+            return;
+        }
+        tree->setRootMatrCacheSize( SWEEP_CACHE_SIZE );
+        values.assign( axes.size(), NAN );
+    }
+    values.resize( axes.size(), NAN );
+    failed[threadIndex] = 0;
+
+    std::vector<double> block;
+    if( floatOutput != NULL ) {
+        block.resize( std::min( numSamples, (size_t)SWEEP_BLOCK_SIZE ) );
+    }
+
+    for( size_t point = first; point < last; point++ ) {
+        for( size_t axis = 0; axis < axes.size(); axis++ ) {
+            const double value = getPointValue( point, axis );
+            if( value != values[axis] ) {
+                tree->setParam( axes[axis].paramID, value );
+                values[axis] = value;
+            }
+        }
+        tree->resetState( );
+
+        if( doubleOutput != NULL ) {
+            tree->processBlock( input, doubleOutput + point * numSamples, numSamples );
+        }
+        else {
+            float* column = floatOutput + point * numSamples;
+            for( size_t n = 0; n < numSamples; n += block.size() ) {
+                const size_t length = std::min( block.size(), numSamples - n );
+                tree->processBlock( input + n, block.data(), length );
+                for( size_t i = 0; i < length; i++ ) {
+                    column[n + i] = (float)block[i];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,229 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_sweep.h
+ Created: 18 Oct 2026 9:05:00pm
+
+ ==============================================================================
+ */
+
+#ifndef RTWDF_SWEEP_H_INCLUDED
+#define RTWDF_SWEEP_H_INCLUDED
+
+//==============================================================================
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rt-wdf.h"
+#include "rt-wdf_threadPool.h"
+
+
+//==============================================================================
+// Parameter sweep config parameters
+
+/** Number of root matrix sets that every instance caches */
+#define SWEEP_CACHE_SIZE    64
+/** Number of samples that are processed at once for float output */
+#define SWEEP_BLOCK_SIZE    4096
+
+
+//==============================================================================
+/**
+ Creates a new tree instance for a wdfParameterSweep. The tree must be
+ initialized, have its sample rate set and be adapted. Is called from the
+ worker threads, so it must be thread-safe.
+
+ @param context             pointer that was passed to the sweep
+ @returns                   a new tree, the sweep takes ownership. NULL for
+                            error.
+ */
+typedef wdfTree* (*wdfTreeFactory)( void* context );
+
+
+//==============================================================================
+class wdfParameterSweep {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Renders one input through a circuit for every point of a parameter grid.
+
+     The grid is the cartesian product of the values of all axes, the axis
+     that was added last changes fastest. Every thread creates one tree
+     instance once and renders a contiguous range of grid points with it:
+     between two points only the parameters that changed are set and the
+     state is reset with wdfTree::resetState(). Each instance caches its
+     root matrices (wdfTree::setRootMatrCacheSize()), so neighboring grid
+     points that share the port resistances at the root, e.g. along an axis
+     that does not touch the root, skip setRootMatrData().
+
+     All instances read the same input buffer. The results are written in
+     columns: numSamples outputs of grid point 0, then of point 1 and so on.
+
+     @param factory             function that creates the tree instances
+     @param context             pointer that is passed to the factory
+     @param numThreads          number of threads including the calling
+                                thread
+     */
+    wdfParameterSweep( wdfTreeFactory factory,
+                       void* context,
+                       size_t numThreads );
+
+    //----------------------------------------------------------------------
+    /**
+     Deconstructor
+     */
+    virtual ~wdfParameterSweep( );
+
+    //----------------------------------------------------------------------
+    /**
+     Adds an axis to the parameter grid.
+
+     @param paramID             ID of the parameter as passed to setParam()
+     @param values              values of the parameter on this axis
+
+     @returns                   0 for success, -1 for error
+     */
+    int addAxis( size_t paramID,
+                 const std::vector<double>& values );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of grid points.
+
+     @returns                   the product of the sizes of all axes
+     */
+    size_t getNumPoints( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the parameter value of a grid point on an axis.
+
+     @param point               index of the grid point
+     @param axis                index of the axis in the order of addAxis()
+
+     @returns                   the parameter value
+     */
+    double getPointValue( size_t point,
+                          size_t axis ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Sets the input that is rendered for every grid point. The buffer is
+     not copied and must stay valid during render().
+
+     @param input               array of numSamples input values
+     @param numSamples          number of samples
+     */
+    void setInput( const double* input,
+                   size_t numSamples );
+
+    //----------------------------------------------------------------------
+    /**
+     Renders all grid points.
+
+     @param output              array of getNumPoints() * numSamples values
+                                to store the columns
+
+     @returns                   0 for success, -1 for error. See
+                                getErrorMessage() for details.
+     */
+    int render( double* output );
+
+    //----------------------------------------------------------------------
+    /**
+     Renders all grid points to single precision columns, which halves the
+     size of large sweeps.
+
+     @param output              array of getNumPoints() * numSamples values
+                                to store the columns
+
+     @returns                   0 for success, -1 for error. See
+                                getErrorMessage() for details.
+     */
+    int render( float* output );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns a human readable description of the last error.
+
+     @returns                   the error message of the last failed call
+     */
+    const std::string& getErrorMessage( ) const;
+
+private:
+    //----------------------------------------------------------------------
+    /**
+     Thread pool task that renders the grid points of one thread.
+     */
+    static void renderTask( void* context,
+                            size_t threadIndex );
+
+    //----------------------------------------------------------------------
+    /**
+     Renders the grid points of one thread into either output buffer.
+     */
+    void renderPoints( size_t threadIndex );
+
+    //----------------------------------------------------------------------
+    /**
+     Common part of both render() variants.
+     */
+    int renderAll( double* doubleOutput,
+                   float* floatOutput );
+
+    //----------------------------------------------------------------------
+    /**
+     An axis of the parameter grid.
+     */
+    typedef struct sweepAxis {
+        size_t paramID;
+        std::vector<double> values;
+    } sweepAxis;
+
+    //----------------------------------------------------------------------
+    /** Function that creates the trees */
+    wdfTreeFactory factory;
+    /** Context of the factory */
+    void* factoryContext;
+    /** Axes of the grid */
+    std::vector<sweepAxis> axes;
+    /** Shared input */
+    const double* input;
+    size_t numSamples;
+    /** Output of the current render() call, one of them is NULL */
+    double* doubleOutput;
+    float* floatOutput;
+    /** One tree per thread, created on first use by that thread */
+    std::vector<std::unique_ptr<wdfTree>> trees;
+    /** Values that were last set in each tree, one row per thread */
+    std::vector<std::vector<double>> currentValues;
+    /** Per thread flag for a failed factory call */
+    std::vector<char> failed;
+    /** Threads that render the grid */
+    wdfThreadPool threadPool;
+    /** Description of the last error */
+    std::string errorMessage;
+
+};
+
+#endif  // RTWDF_SWEEP_H_INCLUDED
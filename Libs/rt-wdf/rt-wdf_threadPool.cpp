@@ -0,0 +1,124 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_threadPool.cpp
+ Created: 18 Oct 2026 7:10:00pm
+
+ ==============================================================================
+ */
+
+#include "rt-wdf_threadPool.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+    #include <immintrin.h>
+    #define THREADPOOL_PAUSE( )     _mm_pause( )
+#elif defined( __aarch64__ ) || defined( __arm__ )
+    #define THREADPOOL_PAUSE( )     __asm__ __volatile__( "yield" )
+#elif defined( _M_ARM64 ) || defined( _M_ARM )
+    #include <intrin.h>
+    #define THREADPOOL_PAUSE( )     __yield( )
+#else
+    #define THREADPOOL_PAUSE( )
+#endif
+
+
+//==============================================================================
+//                          T H R E A D   P O O L
+//==============================================================================
+wdfThreadPool::wdfThreadPool( size_t numThreads ) : currentTask( NULL ),
+                                                    currentContext( NULL ),
+                                                    generation( 0 ),
+                                                    pending( 0 ),
+                                                    sleeping( 0 ),
+                                                    quit( false ) {
+    for( size_t i = 1; i < numThreads; i++ ) {
+        workers.push_back( std::thread( &wdfThreadPool::workerLoop, this, i ) );
+    }
+}
+
+wdfThreadPool::~wdfThreadPool( ) {
+    quit = true;
+    {
+        std::lock_guard<std::mutex> lock( sleepMutex );
+        generation++;
+    }
+    wakeup.notify_all( );
+    for( size_t i = 0; i < workers.size(); i++ ) {
+        workers[i].join( );
+    }
+}
+
+//----------------------------------------------------------------------
+size_t wdfThreadPool::getNumThreads( ) const {
+    return workers.size() + 1;
+}
+
+//----------------------------------------------------------------------
+void wdfThreadPool::run( wdfThreadTask task,
+                         void* context ) {
+    if( workers.empty() ) {
+        task( context, 0 );
+        return;
+    }
+
+    currentTask = task;
+    currentContext = context;
+    pending = workers.size();
+    generation++;
+    if( sleeping > 0 ) {
+        std::lock_guard<std::mutex> lock( sleepMutex );
+        wakeup.notify_all( );
+    }
+
+    task( context, 0 );
+
+    while( pending > 0 ) {
+        std::this_thread::yield( );
+    }
+}
+
+//----------------------------------------------------------------------
+void wdfThreadPool::workerLoop( size_t threadIndex ) {
+    unsigned int seenGeneration = 0;
+    while( true ) {
+        // poll first, sleep only if no task arrives for a while
+        unsigned int spins = 0;
+        while( generation == seenGeneration && spins < THREADPOOL_SPIN_COUNT ) {
+            // spin-wait hint: frees pipeline resources for a hyperthread
+            // sibling and avoids the memory order flush on exit of the loop
+            THREADPOOL_PAUSE( );
+            spins++;
+        }
+        if( generation == seenGeneration ) {
+            sleeping++;
+            std::unique_lock<std::mutex> lock( sleepMutex );
+            wakeup.wait( lock, [&]{ return generation != seenGeneration; } );
+            sleeping--;
+        }
+        seenGeneration = generation;
+
+        if( quit ) {
+            return;
+        }
+        currentTask( currentContext, threadIndex );
+        pending--;
+    }
+}
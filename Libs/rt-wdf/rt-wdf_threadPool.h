@@ -0,0 +1,140 @@
+/*
+ ==============================================================================
+
+ This file is part of the RT-WDF library.
+ Copyright (c) 2015,2016 - Maximilian Rest, Ross Dunkel, Kurt Werner.
+
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+
+ Details of these licenses can be found at: www.gnu.org/licenses
+
+ RT-WDF is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ -----------------------------------------------------------------------------
+ To release a closed-source product which uses RT-WDF, commercial licenses are
+ available: write to rt-wdf@e-rm.de for more information.
+
+ ==============================================================================
+
+ rt-wdf_threadPool.h
+ Created: 18 Oct 2026 7:10:00pm
+
+ ==============================================================================
+ */
+
+#ifndef RTWDF_THREADPOOL_H_INCLUDED
+#define RTWDF_THREADPOOL_H_INCLUDED
+
+//==============================================================================
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//==============================================================================
+// Thread pool config parameters
+
+/** Number of polls before an idle worker goes to sleep. Every poll is
+    followed by a spin-wait hint (pause on x86, yield on ARM) that takes
+    tens of cycles, so this is around as long as 20000 bare polls. */
+#define THREADPOOL_SPIN_COUNT   2000
+
+
+//==============================================================================
+/**
+ Task that is run on all threads of a wdfThreadPool.
+
+ @param context             pointer that was passed to wdfThreadPool::run()
+ @param threadIndex         index of the executing thread, 0 is the caller
+ */
+typedef void (*wdfThreadTask)( void* context,
+                               size_t threadIndex );
+
+
+//==============================================================================
+class wdfThreadPool {
+
+public:
+    //----------------------------------------------------------------------
+    /**
+     Fork-join pool with a low-overhead barrier.
+
+     run() starts a task on all threads and returns when every thread has
+     finished it. Workers poll for new tasks and only go to sleep after
+     THREADPOOL_SPIN_COUNT unsuccessful polls, so two calls per sample
+     (e.g. the pull and push phase of a tree) do not pay for a kernel
+     wakeup as long as the samples keep coming. Neither run() nor the
+     workers allocate memory or take locks while they are busy.
+
+     The pool is meant for large circuits that are rendered offline: the
+     spinning workers keep their cores busy and the barrier still costs
+     around a microsecond, so it only pays off with many nodes per thread.
+
+     @param numThreads          total number of threads including the thread
+                                that calls run(). numThreads - 1 workers are
+                                started.
+     */
+    wdfThreadPool( size_t numThreads );
+
+    //----------------------------------------------------------------------
+    /**
+     Deconstructor. Stops and joins all workers.
+     */
+    ~wdfThreadPool( );
+
+    //----------------------------------------------------------------------
+    /**
+     Returns the number of threads including the calling thread.
+
+     @returns                   the number of threads
+     */
+    size_t getNumThreads( ) const;
+
+    //----------------------------------------------------------------------
+    /**
+     Runs a task on all threads and waits until all of them are finished.
+     The calling thread executes the task with threadIndex 0. Must not be
+     called from within a task or from two threads at once.
+
+     @param task                function to run
+     @param context             pointer that is passed to the task
+     */
+    void run( wdfThreadTask task,
+              void* context );
+
+private:
+    //----------------------------------------------------------------------
+    /**
+     Main loop of a worker thread.
+
+     @param threadIndex         index of the worker, starting at 1
+     */
+    void workerLoop( size_t threadIndex );
+
+    //----------------------------------------------------------------------
+    /** Worker threads */
+    std::vector<std::thread> workers;
+    /** Task of the current generation */
+    wdfThreadTask currentTask;
+    /** Context of the current generation */
+    void* currentContext;
+    /** Incremented for every call to run() */
+    std::atomic<unsigned int> generation;
+    /** Number of workers that have not finished the current task */
+    std::atomic<size_t> pending;
+    /** Number of workers that are sleeping or about to sleep */
+    std::atomic<size_t> sleeping;
+    /** Set to stop the workers */
+    std::atomic<bool> quit;
+    /** Mutex and condition for sleeping workers */
+    std::mutex sleepMutex;
+    std::condition_variable wakeup;
+
+};
+
+#endif  // RTWDF_THREADPOOL_H_INCLUDED
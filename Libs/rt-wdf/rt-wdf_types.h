@@ -38,9 +38,10 @@ using namespace arma;
 /** A struct that holds matrices for R-type and NL root nodes.
 
     wdfRootRtype only uses the S matrix of this struct.
-    wdfRootNL only uses the E,F,M,N matrices of this struct.
+    wdfRootNL only uses the E,F,M,N matrices of this struct, wdfRootMixed
+    additionally fills T.
 
-    @see wdfRootRtype, wdfRootNL
+    @see wdfRootRtype, wdfRootNL, wdfRootMixed
 */
 typedef struct matData{
 
@@ -69,8 +70,10 @@ typedef struct matData{
     */
     mat Nmat;
 
-    /** T-Matrix as used in wdfRootLinear and wdfRootMixed.
-     Size: (numBrPorts) x (numNlPorts)
+    /** T-Matrix as used in wdfRootMixed: the nonzero rows of the N-Matrix,
+        i.e. the coupling of the NL currents into the subtrees which are
+        affected by the non-linearities. Filled by the root itself.
+        Size: (numNlAffectedBrPorts) x (numNlPorts)
      */
     mat Tmat;
 